@@ -0,0 +1,410 @@
+#!/usr/bin/env python3
+"""
+Scancode table generator
+
+Reads ps2demo/ps2_keys.def (the single source of truth for key mappings)
+and regenerates:
+  - ps2demo/ps2_scancodes_gen.h         PS2_<NAME> (Set 2) constants
+  - ps2demo/ps2_scancode_tables_gen.h   dense Set 1/2/3 lookup and reverse tables
+  - sim/ps2_key_names_gen.h             key names for the capture analyzer
+  - ps2_decoder.py                      SCAN_CODES / EXTENDED_SCAN_CODES
+  - SCANCODES.md                        "Complete Scancode Table" section
+
+Usage:
+  python3 gen_scancodes.py          # rewrite outputs, print table sizes
+  python3 gen_scancodes.py --check  # fail if any output is out of date
+"""
+
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+DEF_FILE = os.path.join(ROOT, 'ps2demo', 'ps2_keys.def')
+CODES_H = os.path.join(ROOT, 'ps2demo', 'ps2_scancodes_gen.h')
+TABLES_H = os.path.join(ROOT, 'ps2demo', 'ps2_scancode_tables_gen.h')
+NAMES_H = os.path.join(ROOT, 'sim', 'ps2_key_names_gen.h')
+DECODER_PY = os.path.join(ROOT, 'ps2_decoder.py')
+SCANCODES_MD = os.path.join(ROOT, 'SCANCODES.md')
+
+FLAGS = ('e0', 'prtsc', 'pause', 'makeonly', 'alias')
+
+# Packed entry layout (must match ps2_scancodes.h)
+PACKED_E0 = 0x80
+
+
+class Key:
+    def __init__(self, name, keycode, code, set1, set3, flags, usage, section, line):
+        self.name = name
+        self.keycode = keycode
+        self.code = code  # Set 2
+        self.set1 = set1
+        self.set3 = set3
+        self.flags = flags
+        self.usage = usage
+        self.section = section
+        self.line = line
+
+    @property
+    def e0(self):
+        return 'e0' in self.flags or 'prtsc' in self.flags
+
+    def code_in(self, scancode_set):
+        return {1: self.set1, 2: self.code, 3: self.set3}[scancode_set]
+
+
+def fail(msg):
+    sys.exit('gen_scancodes: ' + msg)
+
+
+def parse(path):
+    keys = []
+    section = None
+    with open(path) as f:
+        for n, raw in enumerate(f, 1):
+            line = raw.strip()
+            if line.startswith('## '):
+                section = line[3:].strip()
+                continue
+            if not line or line.startswith('#'):
+                continue
+            cols = line.split()
+            if len(cols) != 7:
+                fail(f'{path}:{n}: expected 7 columns, got {len(cols)}')
+            name, keycode, code, set1, set3, flags, usage = cols
+            flags = () if flags == '-' else tuple(flags.split(','))
+            for flag in flags:
+                if flag not in FLAGS:
+                    fail(f'{path}:{n}: unknown flag {flag!r}')
+            keys.append(Key(name, keycode, int(code, 16),
+                            None if set1 == '-' else int(set1, 16),
+                            None if set3 == '-' else int(set3, 16), flags,
+                            None if usage == '-' else int(usage, 16),
+                            section, n))
+    return keys
+
+
+def validate(keys):
+    seen_names, seen_keycodes, seen_usages = {}, {}, {}
+    seen_codes = {1: {}, 2: {}, 3: {}}
+    for key in keys:
+        where = f'{DEF_FILE}:{key.line}'
+        if key.name in seen_names:
+            fail(f'{where}: duplicate name {key.name}')
+        seen_names[key.name] = key
+        if key.keycode in seen_keycodes:
+            fail(f'{where}: duplicate keycode {key.keycode}')
+        seen_keycodes[key.keycode] = key
+        if key.usage is not None:
+            if key.usage in seen_usages:
+                fail(f'{where}: duplicate usage 0x{key.usage:04X}')
+            seen_usages[key.usage] = key
+        for scancode_set in (1, 2, 3):
+            code = key.code_in(scancode_set)
+            if code is None:
+                continue
+            if not 0 < code <= 0xFF:
+                fail(f'{where}: Set {scancode_set} code out of range')
+            if scancode_set != 3 and key.e0 and code >= 0x80:
+                fail(f'{where}: E0 codes must be below 0x80')
+            # Set 3 has no prefixes, every key has a code of its own
+            if scancode_set == 3:
+                slot = code
+            else:
+                slot = (key.e0, 'pause' in key.flags, code)
+            seen = seen_codes[scancode_set]
+            if 'alias' in key.flags:
+                if slot not in seen:
+                    fail(f'{where}: Set {scancode_set} alias of nothing')
+            elif slot in seen:
+                fail(f'{where}: Set {scancode_set} code also used by {seen[slot].name} '
+                     f'(mark one of them alias)')
+            else:
+                seen[slot] = key
+
+
+def pack(keys, scancode_set):
+    """Assign each key its one-byte Set 1 or Set 2 table entry.
+
+    Plain codes below 0x80 are stored as-is and E0 codes as 0x80 | code.
+    Everything else (plain codes above 0x7F, PrintScreen, Pause, make-only
+    keys) gets an escape slot 0x80 | n with n below the smallest E0 code in use.
+    """
+    escapes = [None]  # slot 0 is never used: 0x80 would read as E0 00
+    packed = {}
+    for key in keys:
+        code = key.code_in(scancode_set)
+        if code is None:
+            continue
+        special = any(flag in key.flags for flag in ('prtsc', 'pause', 'makeonly'))
+        if special or (not key.e0 and code >= 0x80):
+            packed[key.name] = PACKED_E0 | len(escapes)
+            escapes.append(key)
+        elif key.e0:
+            packed[key.name] = PACKED_E0 | code
+        else:
+            packed[key.name] = code
+
+    lowest_e0 = min(k.code_in(scancode_set) for k in keys
+                    if 'e0' in k.flags and k.code_in(scancode_set) is not None)
+    if len(escapes) > lowest_e0:
+        fail(f'Set {scancode_set}: {len(escapes) - 1} escapes collide with '
+             f'E0 code 0x{lowest_e0:02X}')
+    return packed, escapes
+
+
+HEADER_NOTE = '// GENERATED by gen_scancodes.py from ps2_keys.def - do not edit'
+
+
+def gen_codes_h(keys, escapes):
+    set1_escapes, set2_escapes = escapes
+    out = [f'// ps2_scancodes_gen.h - PS/2 Scan Code Set 2 make codes',
+           HEADER_NOTE,
+           '#ifndef PS2_SCANCODES_GEN_H',
+           '#define PS2_SCANCODES_GEN_H',
+           '']
+    section = None
+    for key in keys:
+        if key.section != section:
+            if section is not None:
+                out.append('')
+            out.append(f'// {key.section}')
+            section = key.section
+        out.append(f'#define PS2_{key.name:<16} 0x{key.code:02X}')
+
+    usages = [k.usage for k in keys if k.usage is not None]
+    out += ['',
+            '// Consumer usage range covered by the usage table',
+            f'#define PS2_USAGE_FIRST 0x{min(usages):04X}',
+            f'#define PS2_USAGE_LAST  0x{max(usages):04X}',
+            '',
+            '// Escape slots used by the packed keycode tables',
+            f'#define PS2_SET1_ESCAPES {len(set1_escapes)}',
+            f'#define PS2_SET2_ESCAPES {len(set2_escapes)}',
+            '',
+            '#endif // PS2_SCANCODES_GEN_H',
+            '']
+    return '\n'.join(out)
+
+
+def c_mapping(key, scancode_set):
+    code = f'PS2_{key.name}' if scancode_set == 2 else f'0x{key.code_in(scancode_set):02X}'
+    if 'prtsc' in key.flags:
+        return f'{{{code}, false, PS2_KEY_PRINTSCREEN}}'
+    if 'pause' in key.flags:
+        return f'{{{code}, false, PS2_KEY_PAUSE}}'
+    if 'makeonly' in key.flags:
+        return f'{{{code}, {"true" if key.e0 else "false"}, PS2_KEY_MAKE_ONLY}}'
+    return f'{{{code}, {"true" if key.e0 else "false"}, PS2_KEY_NORMAL}}'
+
+
+def c_packed_table(keys, scancode_set, packed, escapes, width):
+    out = [f'// QMK keycode -> packed Set {scancode_set} entry (see ps2_scancodes.h)',
+           f'static const uint8_t ps2_set{scancode_set}_table[256] = {{']
+    for key in keys:
+        if key.name in packed:
+            out.append(f'    {"[" + key.keycode + "]":<{width}} = 0x{packed[key.name]:02X},  // {key.name}')
+    out += ['};',
+            '',
+            f'// Set {scancode_set} entries that do not fit the packed format',
+            f'static const ps2_mapping_t ps2_set{scancode_set}_escapes[PS2_SET{scancode_set}_ESCAPES] = {{']
+    for slot, key in enumerate(escapes):
+        if key is not None:
+            out.append(f'    [{slot}] = {c_mapping(key, scancode_set)},')
+    out += ['};', '']
+    return out
+
+
+def gen_tables_h(keys, packed, escapes):
+    width = max(len(k.keycode) for k in keys) + 2
+    out = ['// ps2_scancode_tables_gen.h - Dense scancode lookup tables',
+           HEADER_NOTE,
+           '// Only ps2_scancodes.c includes this file.',
+           '#ifndef PS2_SCANCODE_TABLES_GEN_H',
+           '#define PS2_SCANCODE_TABLES_GEN_H',
+           '']
+    for scancode_set in (2, 1):
+        out += c_packed_table(keys, scancode_set, packed[scancode_set - 1],
+                              escapes[scancode_set - 1], width)
+    out += ['// QMK keycode -> Set 3 make code (no prefixes, nothing to pack)',
+            'static const uint8_t ps2_set3_table[256] = {']
+    for key in keys:
+        if key.set3 is not None:
+            out.append(f'    {"[" + key.keycode + "]":<{width}} = 0x{key.set3:02X},  // {key.name}')
+    out += ['};',
+            '',
+            '// Consumer usage - PS2_USAGE_FIRST -> QMK keycode',
+            'static const uint8_t ps2_usage_table[PS2_USAGE_LAST - PS2_USAGE_FIRST + 1] = {']
+    for key in sorted((k for k in keys if k.usage is not None), key=lambda k: k.usage):
+        out.append(f'    [0x{key.usage:04X} - PS2_USAGE_FIRST] = {key.keycode},')
+    out += ['};',
+            '',
+            '// Scancode -> QMK keycode, for decoders']
+    plain = [k for k in keys if not k.e0 and 'alias' not in k.flags and 'pause' not in k.flags]
+    extended = [k for k in keys if k.e0 and 'alias' not in k.flags]
+    pause = [k for k in keys if 'pause' in k.flags]
+    out.append('static const uint8_t ps2_reverse_plain[256] = {')
+    for key in sorted(plain, key=lambda k: k.code):
+        out.append(f'    [0x{key.code:02X}] = {key.keycode},')
+    out += ['};',
+            '',
+            'static const uint8_t ps2_reverse_e0[128] = {']
+    for key in sorted(extended, key=lambda k: k.code):
+        out.append(f'    [0x{key.code:02X}] = {key.keycode},')
+    out += ['};',
+            '',
+            '// The only E1 sequence',
+            f'#define PS2_REVERSE_E1 {pause[0].keycode if pause else "KC_NO"}',
+            '',
+            '#endif // PS2_SCANCODE_TABLES_GEN_H',
+            '']
+    return '\n'.join(out)
+
+
+def gen_names_h(keys):
+    out = ['// ps2_key_names_gen.h - Display name of each key, by QMK keycode',
+           HEADER_NOTE,
+           '#ifndef PS2_KEY_NAMES_GEN_H',
+           '#define PS2_KEY_NAMES_GEN_H',
+           '',
+           'static const char *const ps2_key_names[256] = {']
+    width = max(len(k.keycode) for k in keys) + 2
+    for key in keys:
+        out.append(f'    {"[" + key.keycode + "]":<{width}} = "{key.name}",')
+    out += ['};',
+            '',
+            '#endif // PS2_KEY_NAMES_GEN_H',
+            '']
+    return '\n'.join(out)
+
+
+def table_sizes(keys):
+    # The escape table holds ps2_mapping_t, whose size depends on the
+    # target's enum width; ps2_scancodes_benchmark() reports it exactly
+    usages = [k.usage for k in keys if k.usage is not None]
+    return [('Set 2 table', 256),
+            ('Set 1 table', 256),
+            ('Set 3 table', 256),
+            ('usage table', max(usages) - min(usages) + 1),
+            ('reverse plain', 256),
+            ('reverse E0', 128)]
+
+
+def replace_block(text, begin, end, body, path):
+    pattern = re.compile(re.escape(begin) + r'.*?' + re.escape(end), re.S)
+    if not pattern.search(text):
+        fail(f'{path}: missing {begin!r} / {end!r} markers')
+    return pattern.sub(lambda _: begin + '\n' + body + end, text, count=1)
+
+
+def py_dict(name, comment, keys, extra=()):
+    out = [f'# {comment}', f'{name} = {{']
+    section = None
+    for key in keys:
+        if key.section != section:
+            out.append(f'    # {key.section}')
+            section = key.section
+        out.append(f"    0x{key.code:02X}: '{key.name}',")
+    for code, label in extra:
+        out.append(f"    0x{code:02X}: '{label}',")
+    out.append('}')
+    return out
+
+
+def gen_decoder(text, keys):
+    plain = [k for k in keys if not k.e0 and 'alias' not in k.flags and 'pause' not in k.flags]
+    extended = [k for k in keys if k.e0 and 'alias' not in k.flags]
+    body = py_dict('SCAN_CODES', 'PS/2 Scan Code Set 2 - Comprehensive lookup table', plain)
+    body.append('')
+    # E0 12 is the fake shift PrintScreen sends ahead of E0 7C
+    body += py_dict('EXTENDED_SCAN_CODES', 'Extended scan codes (prefixed with 0xE0)', extended,
+                    extra=[(0x12, 'PRTSC_PART')])
+    return replace_block(text, '# BEGIN GENERATED SCANCODES (gen_scancodes.py)',
+                         '# END GENERATED SCANCODES', '\n'.join(body) + '\n', DECODER_PY)
+
+
+def sequences(key):
+    if 'prtsc' in key.flags:
+        return 'E0 12 E0 7C', 'E0 F0 7C E0 F0 12'
+    if 'pause' in key.flags:
+        return 'E1 14 77 E1 F0 14 F0 77', '(none)'
+    prefix = 'E0 ' if key.e0 else ''
+    if 'makeonly' in key.flags:
+        return f'{prefix}{key.code:02X}', '(none)'
+    return f'{prefix}{key.code:02X}', f'{prefix}F0 {key.code:02X}'
+
+
+def set1_make(key):
+    if key.set1 is None:
+        return ''
+    if 'prtsc' in key.flags:
+        return '`E0 2A E0 37`'
+    if 'pause' in key.flags:
+        return '`E1 1D 45 E1 9D C5`'
+    return f'`{"E0 " if key.e0 else ""}{key.set1:02X}`'
+
+
+def gen_markdown(text, keys):
+    out = []
+    section = None
+    for key in keys:
+        if key.section != section:
+            if section is not None:
+                out.append('')
+            out += [f'### {key.section}', '',
+                    '| Key | QMK Code | Make | Break | Set 1 Make | Set 3 | Consumer Usage |',
+                    '|-----|----------|------|-------|------------|-------|----------------|']
+            section = key.section
+        make, brk = sequences(key)
+        usage = f'0x{key.usage:04X}' if key.usage is not None else ''
+        set3 = f'`{key.set3:02X}`' if key.set3 is not None else ''
+        out.append(f'| {key.name} | {key.keycode} | `{make}` | `{brk}` | {set1_make(key)} | {set3} | {usage} |')
+    return replace_block(text, '<!-- BEGIN GENERATED SCANCODES (gen_scancodes.py) -->',
+                         '<!-- END GENERATED SCANCODES -->', '\n'.join(out) + '\n\n', SCANCODES_MD)
+
+
+def main():
+    check = '--check' in sys.argv[1:]
+    keys = parse(DEF_FILE)
+    validate(keys)
+    set1_packed, set1_escapes = pack(keys, 1)
+    set2_packed, set2_escapes = pack(keys, 2)
+    packed = (set1_packed, set2_packed)
+    escapes = (set1_escapes, set2_escapes)
+
+    outputs = {CODES_H: gen_codes_h(keys, escapes),
+               TABLES_H: gen_tables_h(keys, packed, escapes),
+               NAMES_H: gen_names_h(keys)}
+    with open(DECODER_PY) as f:
+        outputs[DECODER_PY] = gen_decoder(f.read(), keys)
+    with open(SCANCODES_MD) as f:
+        outputs[SCANCODES_MD] = gen_markdown(f.read(), keys)
+
+    stale = []
+    for path, text in outputs.items():
+        current = open(path).read() if os.path.exists(path) else None
+        if current == text:
+            continue
+        stale.append(os.path.relpath(path, ROOT))
+        if not check:
+            with open(path, 'w') as f:
+                f.write(text)
+
+    if check:
+        if stale:
+            fail('out of date, run gen_scancodes.py: ' + ', '.join(stale))
+        return
+
+    for path in stale:
+        print(f'wrote {path}')
+    print(f'{len(keys)} keys')
+    total = 0
+    for name, size in table_sizes(keys):
+        print(f'  {name:<14} {size:4d} bytes')
+        total += size
+    print(f'  {"escape tables":<14} {len(set1_escapes) + len(set2_escapes):4d} entries')
+    print(f'  {"total":<14} {total:4d} bytes of flash + escape tables')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""
+PS/2 trace log decoder
+
+The firmware writes hot-path events as binary records and prints them as
+"PS2T <16 hex digits>" lines when the bus is idle. This turns those lines
+back into text, using the event list in ps2demo/ps2_trace.h. Every other
+console line is passed through unchanged.
+
+Usage:
+  qmk console | python3 ps2_trace.py
+  python3 ps2_trace.py capture.txt
+  python3 ps2_trace.py --header path/to/ps2_trace.h capture.txt
+"""
+
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+TRACE_H = os.path.join(ROOT, 'ps2demo', 'ps2_trace.h')
+
+RECORD = re.compile(r'PS2T ([0-9A-Fa-f]{16})\s*$')
+EVENT = re.compile(r'^\s*PS2_EV_(\w+)\s*(?:=\s*(\w+))?\s*,\s*//\s*(.*?)\s*$')
+
+
+def load_events(path):
+    """Event token -> (name, format) from the ps2_trace_event_t enum."""
+    events = {}
+    in_enum = False
+    value = 0
+    for line in open(path):
+        if 'typedef enum' in line:
+            in_enum = True
+            continue
+        if in_enum and line.strip().startswith('}'):
+            if 'ps2_trace_event_t' in line:
+                break
+            in_enum = False
+            continue
+        match = EVENT.match(line) if in_enum else None
+        if match:
+            name, explicit, fmt = match.groups()
+            if explicit is not None:
+                value = int(explicit, 0)
+            events[value] = (name, fmt)
+            value += 1
+    if not events:
+        sys.exit(f'ps2_trace: no events found in {path}')
+    return events
+
+
+class Decoder:
+    def __init__(self, events):
+        self.events = events
+        self.last_time = None
+        self.elapsed = 0  # ms, with the 16-bit timestamp unwrapped
+
+    def decode(self, digits):
+        raw = bytes.fromhex(digits)
+        time = int.from_bytes(raw[0:2], 'big')
+        event, c = raw[2], raw[3]
+        a = int.from_bytes(raw[4:6], 'big')
+        b = int.from_bytes(raw[6:8], 'big')
+
+        if self.last_time is not None:
+            self.elapsed += (time - self.last_time) & 0xFFFF
+        self.last_time = time
+
+        name, fmt = self.events.get(event, (f'EVENT_{event}', 'a={a:#06x} b={b:#06x} c={c:#04x}'))
+        try:
+            text = fmt.format(a=a, b=b, c=c)
+        except (IndexError, KeyError, ValueError):
+            text = f'{fmt} (a={a:#06x} b={b:#06x} c={c:#04x})'
+        return f'[{self.elapsed / 1000:9.3f}] {name:<18} {text}'
+
+
+def main():
+    args = sys.argv[1:]
+    header = TRACE_H
+    if '--header' in args:
+        i = args.index('--header')
+        header = args[i + 1]
+        del args[i:i + 2]
+
+    decoder = Decoder(load_events(header))
+    source = open(args[0]) if args else sys.stdin
+    for line in source:
+        match = RECORD.search(line)
+        if match:
+            print(decoder.decode(match.group(1)))
+        else:
+            sys.stdout.write(line)
+        sys.stdout.flush()
+
+
+if __name__ == '__main__':
+    main()
@@ -12,13 +12,38 @@
 #define PS2_KEYBOARD_CLOCK_PIN  GP16
 #define PS2_KEYBOARD_DATA_PIN   GP17
 
-// PS/2 Mouse Pin definitions (future)
+// PS/2 Mouse Pin definitions
 #define PS2_MOUSE_CLOCK_PIN     GP18
 #define PS2_MOUSE_DATA_PIN      GP19
 
+// Max time (us) ps2_keyboard_task() may spend draining a multi-byte sequence
+// when no hardware timer drives the PS/2 engine. A frame already started is
+// always finished (0 = one frame per call).
+#define PS2_TASK_BUDGET_US      2000
+
+// Time (us) the PS/2 timer fires ahead of each clock edge and waits out with
+// interrupts masked, so other interrupts don't move the edge
+// #define PS2_EDGE_LEAD_US        3
+
+// Min time (us) between consumer/system key events, so an encoder's
+// detents queue up as a count instead of flooding the bus
+// #define PS2_EXTRA_INTERVAL_US   4000
+
+// Trace log detail (see ps2_trace.h). Defaults to WARN with the console
+// enabled; DEBUG logs every key change, PS2_TRACE_LEVEL_OFF compiles every
+// trace call out.
+// #define PS2_TRACE_LEVEL         PS2_TRACE_LEVEL_DEBUG
+
+// Key event log buffer (bytes) for sim/replay, see ps2_keylog.h. On by
+// default with the console enabled; PS2_KEYLOG_ENABLE 0 turns it off.
+// #define PS2_KEYLOG_SIZE         8192
+
 // Mode switch pin (to toggle between USB and PS/2)
 #define MODE_SWITCH_PIN GP14  // High = USB, Low = PS/2
 
+// Time (us) a new switch position must hold before it takes effect
+// #define MODE_SWITCH_SETTLE_US   500
+
 // Debounce reduces chatter (can also be set in info.json)
 #define DEBOUNCE 5
 
@@ -0,0 +1,105 @@
+// host_detect.c - Which hosts are connected, judged from their buses
+//
+// USB counts as connected while the USB driver is active (enumerated,
+// configured and getting start-of-frame packets) or suspended: ChibiOS
+// suspends it after 3ms without SOFs, which is what a sleeping host looks
+// like, and that host is still the one the keyboard wakes. A PS/2 port
+// counts as connected when its host inhibited or talked to it, or when the
+// host's pull-ups show on the lines (see ps2_bus_probe_host()). A host is
+// taken as connected on the first evidence and as gone after
+// HOST_DETECT_MISSES probes in a row without any. The firmware then stops
+// spending time on its transport: USB reports are no longer sent, and the
+// PS/2 ports queue nothing.
+#include "host_detect.h"
+#include "host_fanout.h"
+#include "ps2_keyboard.h"
+#include "ps2_mouse.h"
+#include "quantum.h"
+
+#if defined(PROTOCOL_CHIBIOS)
+#include "usb_main.h"  // USB_DRIVER
+#endif
+
+#ifndef HOST_DETECT_INTERVAL_MS
+#define HOST_DETECT_INTERVAL_MS 100
+#endif
+
+#ifndef HOST_DETECT_MISSES
+#define HOST_DETECT_MISSES 3
+#endif
+
+static const char *const host_names[HOST_COUNT] = {"USB", "PS/2 keyboard", "PS/2 mouse"};
+
+static struct {
+    bool present;
+    uint8_t misses;  // Probes in a row without evidence
+} hosts[HOST_COUNT] = {
+    [0 ... HOST_COUNT - 1] = {.present = true},
+};
+
+static bool host_detect_evidence(host_id_t host) {
+    switch (host) {
+        case HOST_USB:
+#if defined(PROTOCOL_CHIBIOS)
+            switch (usbGetDriverStateI(&USB_DRIVER)) {
+                case USB_ACTIVE:
+                case USB_SUSPENDED:
+                    return true;
+                default:
+                    return false;
+            }
+#else
+            return true;  // No USB state to look at
+#endif
+        case HOST_PS2_KEYBOARD:
+            return ps2_bus_probe_host(&ps2_keyboard_port);
+        case HOST_PS2_MOUSE:
+            return ps2_bus_probe_host(&ps2_mouse_port);
+        default:
+            return true;
+    }
+}
+
+static void host_detect_apply(host_id_t host, bool present) {
+    uprintf("[HOST] %s %s\n", host_names[host], present ? "connected" : "not connected");
+    switch (host) {
+        case HOST_USB:
+            host_fanout_enable_usb(present);
+            break;
+        case HOST_PS2_KEYBOARD:
+            ps2_keyboard_set_host_present(present);
+            break;
+        case HOST_PS2_MOUSE:
+            ps2_mouse_set_host_present(present);
+            break;
+        default:
+            break;
+    }
+}
+
+void host_detect_task(void) {
+#if HOST_DETECT_ENABLE
+    static uint32_t last_probe = 0;
+    if (timer_elapsed32(last_probe) < HOST_DETECT_INTERVAL_MS) {
+        return;
+    }
+    last_probe = timer_read32();
+
+    for (uint8_t host = 0; host < HOST_COUNT; host++) {
+        if (host_detect_evidence(host)) {
+            hosts[host].misses = 0;
+            if (!hosts[host].present) {
+                hosts[host].present = true;
+                host_detect_apply(host, true);
+            }
+        } else if (hosts[host].present && ++hosts[host].misses >= HOST_DETECT_MISSES) {
+            hosts[host].present = false;
+            host_detect_apply(host, false);
+        }
+    }
+#endif
+}
+
+bool host_detect_present(host_id_t host) {
+    return host < HOST_COUNT && hosts[host].present;
+}
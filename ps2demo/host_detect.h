@@ -0,0 +1,27 @@
+// host_detect.h - Which hosts are connected, judged from their buses
+#ifndef HOST_DETECT_H
+#define HOST_DETECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 0 = every host counts as connected and only the mode switch decides
+#ifndef HOST_DETECT_ENABLE
+#define HOST_DETECT_ENABLE 1
+#endif
+
+typedef enum {
+    HOST_USB,
+    HOST_PS2_KEYBOARD,
+    HOST_PS2_MOUSE,
+    HOST_COUNT
+} host_id_t;
+
+// Look at the evidence every HOST_DETECT_INTERVAL_MS and turn transports on
+// or off as hosts come and go. Call from the main loop once both the USB
+// driver and the PS/2 ports are up.
+void host_detect_task(void);
+
+bool host_detect_present(host_id_t host);
+
+#endif // HOST_DETECT_H
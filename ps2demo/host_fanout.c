@@ -0,0 +1,61 @@
+// host_fanout.c - Every report to both the USB and the PS/2 host
+//
+// Each transport keeps its own state: the USB driver sends reports as QMK
+// made them, the PS/2 keyboard diffs them against what its host holds and
+// the mouse port adds movement up per sample period. USB is always called
+// first, and neither waits on the other: PS/2 keys that don't fit in the
+// queue go to its backlog, whichever host is selected. The selection only
+// picks the LED source.
+#include "host_fanout.h"
+#include <stddef.h>
+
+static host_driver_t *fanout_usb = NULL;
+static host_driver_t *fanout_ps2 = NULL;
+static host_driver_t *fanout_leds = NULL;
+static bool fanout_usb_enabled = true;
+
+void host_fanout_init(host_driver_t *usb, host_driver_t *ps2) {
+    fanout_usb = usb;
+    fanout_ps2 = ps2;
+    fanout_leds = usb;
+}
+
+void host_fanout_select(host_driver_t *leds) {
+    fanout_leds = leds;
+}
+
+void host_fanout_enable_usb(bool enable) {
+    fanout_usb_enabled = enable;
+}
+
+static uint8_t fanout_keyboard_leds(void) {
+    return fanout_leds ? fanout_leds->keyboard_leds() : 0;
+}
+
+static void fanout_send_keyboard(report_keyboard_t *report) {
+    if (fanout_usb_enabled) fanout_usb->send_keyboard(report);
+    fanout_ps2->send_keyboard(report);
+}
+
+static void fanout_send_nkro(report_nkro_t *report) {
+    if (fanout_usb_enabled) fanout_usb->send_nkro(report);
+    fanout_ps2->send_nkro(report);
+}
+
+static void fanout_send_mouse(report_mouse_t *report) {
+    if (fanout_usb_enabled) fanout_usb->send_mouse(report);
+    fanout_ps2->send_mouse(report);
+}
+
+static void fanout_send_extra(report_extra_t *report) {
+    if (fanout_usb_enabled) fanout_usb->send_extra(report);
+    fanout_ps2->send_extra(report);
+}
+
+host_driver_t host_fanout_driver = {
+    .keyboard_leds = fanout_keyboard_leds,
+    .send_keyboard = fanout_send_keyboard,
+    .send_nkro = fanout_send_nkro,
+    .send_mouse = fanout_send_mouse,
+    .send_extra = fanout_send_extra,
+};
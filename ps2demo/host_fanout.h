@@ -0,0 +1,19 @@
+// host_fanout.h - Composite host driver feeding USB and PS/2 at once
+#ifndef HOST_FANOUT_H
+#define HOST_FANOUT_H
+
+#include <stdbool.h>
+#include "host_driver.h"  // For host_driver_t
+
+extern host_driver_t host_fanout_driver;
+
+// Forward every report to both drivers; LEDs come from usb until selected
+void host_fanout_init(host_driver_t *usb, host_driver_t *ps2);
+
+// Host whose LED / lock state the keyboard shows
+void host_fanout_select(host_driver_t *leds);
+
+// Stop calling the USB driver while no USB host is connected
+void host_fanout_enable_usb(bool enable);
+
+#endif // HOST_FANOUT_H
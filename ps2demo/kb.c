@@ -1,14 +1,40 @@
-// keyboards/bjl/ps2demo/kb.c - FIXED VERSION with proper USB driver restoration
+// keyboards/bjl/ps2demo/kb.c - Mode switch and USB + PS/2 fan-out
 #include "kb.h"
 #include "ps2_keyboard.h"
+#include "ps2_mouse.h"
+#include "ps2_trace.h"
+#include "ps2_stats.h"
+#include "ps2_keylog.h"
+#include "host_fanout.h"
+#include "host_detect.h"
 #include "print.h"
 #include "host.h"
 
 // Mode state
 static bool usb_mode = true;
-static bool last_mode = true;
 
-// Store original USB driver to restore later
+// A new switch level takes effect once it has held this long; any edge in
+// between restarts the wait. Both hosts get every report whatever the
+// switch says, so a bounce that gets through costs nothing but a log line.
+#ifndef MODE_SWITCH_SETTLE_US
+#define MODE_SWITCH_SETTLE_US 500
+#endif
+
+typedef enum {
+    MODE_SWITCH_STABLE,    // Pin level is the settled position
+    MODE_SWITCH_SETTLING   // Pin changed, waiting out glitches
+} mode_switch_state_t;
+
+static struct {
+    mode_switch_state_t state;
+    bool level;         // Last sampled pin level (HIGH = USB)
+    uint32_t since_us;  // When it last changed
+    bool usb;           // Settled position
+    bool moved;         // Settled somewhere new since the connected hosts last changed
+    uint8_t hosts;      // Connected hosts then: bit 0 USB, bit 1 PS/2 keyboard
+} mode_switch = {MODE_SWITCH_STABLE, true, 0, true, false, 0x03};
+
+// QMK's USB driver, captured when the fan-out driver replaces it
 static host_driver_t *original_usb_driver = NULL;
 
 bool is_usb_mode(void) {
@@ -28,106 +54,153 @@ void keyboard_post_init_kb(void) {
     keyboard_post_init_user();
 }
 
-void housekeeping_task_kb(void) {
-    static uint32_t mode_change_time = 0;
-    bool current_mode = readPin(MODE_SWITCH_PIN);
-
-    // Check for mode mismatch (current pin vs last known mode)
-    // This handles both runtime switching AND initial boot detection
-    if (current_mode != last_mode) {
-        if (mode_change_time == 0) {
-            mode_change_time = timer_read32();
-        } else if (timer_elapsed32(mode_change_time) > 50) {
-            // Mode stable for 50ms - switch!
-            last_mode = current_mode;
-            usb_mode = current_mode;
-            mode_change_time = 0;
-
-            uprintf("================================\n");
-            uprintf("Mode switch: %s\n", usb_mode ? "USB" : "PS/2");
-            uprintf("================================\n");
-
-            if (!usb_mode) {
-                // ===== Switching TO PS/2 =====
-
-                // CRITICAL: Capture the driver here, where we know it is valid
-                if (original_usb_driver == NULL) {
-                    original_usb_driver = host_get_driver();
-                }
+// Make usb the mode in use. Never waits: every connected host already gets
+// every report, so only the LED source changes. A PS/2 host that fell
+// behind while USB was selected skips its backlog and gets the keys held
+// right now within a few milliseconds.
+static void mode_switch_apply(bool usb) {
+    usb_mode = usb;
 
-                // Clear USB keyboard state while USB driver is still active
-                clear_keyboard();
-                wait_ms(20);
+    uprintf("================================\n");
+    uprintf("Mode switch: %s\n", usb_mode ? "USB" : "PS/2");
+    uprintf("================================\n");
 
-                // Now switch to PS/2
-                ps2_keyboard_init(PS2_KEYBOARD_CLOCK_PIN, PS2_KEYBOARD_DATA_PIN);
-                host_set_driver(&ps2_keyboard_host_driver);
-                uprintf("[PS2] PS/2 driver activated\n");
+    host_fanout_select(usb_mode ? original_usb_driver : &ps2_keyboard_host_driver);
+    if (!usb_mode) {
+        ps2_keyboard_catch_up();
+    }
+}
 
-            } else {
-                // ===== Switching TO USB =====
-                // Disable PS/2 typematic first
-                ps2_keyboard_typematic_disable();
+// Sample the pin every loop: an edge starts the glitch filter, a level that
+// outlasts it becomes the settled position. Handles runtime switching and
+// the boot position.
+static void mode_switch_task(void) {
+    bool level = readPin(MODE_SWITCH_PIN);
+    uint32_t now = ps2_micros();
+
+    if (level != mode_switch.level) {
+        mode_switch.level = level;
+        mode_switch.since_us = now;
+        mode_switch.state = level == mode_switch.usb ? MODE_SWITCH_STABLE : MODE_SWITCH_SETTLING;
+        return;
+    }
 
-                // Restore the original USB driver
-                if (original_usb_driver != NULL) {
-                    host_set_driver(original_usb_driver);
-                    uprintf("[USB] USB driver restored\n");
-                } else {
-                    uprintf("[USB] ERROR: original_usb_driver is NULL!\n");
-                }
+    if (mode_switch.state == MODE_SWITCH_SETTLING && now - mode_switch.since_us >= MODE_SWITCH_SETTLE_US) {
+        mode_switch.state = MODE_SWITCH_STABLE;
+        mode_switch.usb = level;
+        mode_switch.moved = true;
+    }
+}
 
-                wait_ms(20);
+// The host to follow: the switch position if it was moved since a host
+// last came or went, else the only one connected, else (both or neither)
+// the switch position again. Detection picks the host when the hosts
+// change; flipping the switch afterwards still overrides it.
+static bool mode_wanted_usb(void) {
+    bool usb = host_detect_present(HOST_USB);
+    bool ps2 = host_detect_present(HOST_PS2_KEYBOARD);
+    uint8_t hosts = (usb ? 0x01 : 0) | (ps2 ? 0x02 : 0);
+    if (hosts != mode_switch.hosts) {
+        mode_switch.hosts = hosts;
+        mode_switch.moved = false;
+    }
+    return usb == ps2 || mode_switch.moved ? mode_switch.usb : usb;
+}
 
-                // Clear keyboard state in USB mode
-                clear_keyboard();
-                send_keyboard_report();
+void housekeeping_task_kb(void) {
+#ifdef PS2_SCANCODE_BENCHMARK
+    // Run once, late enough for `qmk console` to be attached
+    static bool benchmark_done = false;
+    if (!benchmark_done && timer_read32() > 5000) {
+        benchmark_done = true;
+        ps2_scancodes_benchmark();
+    }
+#endif
+
+    // Fan out to both hosts once QMK has installed its USB driver (it isn't
+    // set yet in keyboard_post_init_kb())
+    if (original_usb_driver == NULL && host_get_driver() != NULL) {
+        original_usb_driver = host_get_driver();
+        ps2_keyboard_init(PS2_KEYBOARD_CLOCK_PIN, PS2_KEYBOARD_DATA_PIN);
+        ps2_mouse_init(PS2_MOUSE_CLOCK_PIN, PS2_MOUSE_DATA_PIN);
+        host_fanout_init(original_usb_driver, &ps2_keyboard_host_driver);
+        host_set_driver(&host_fanout_driver);
+        uprintf("[HOST] Reports go to USB and PS/2\n");
+    }
 
-                wait_ms(20);
-            }
+    // The switch and both buses run once the fan-out driver is in (the
+    // keyboard task drains the trace log when the buses are idle)
+    if (original_usb_driver != NULL) {
+        host_detect_task();
+        mode_switch_task();
+        if (mode_wanted_usb() != usb_mode) {
+            mode_switch_apply(!usb_mode);
         }
+        ps2_mouse_task();
+        ps2_stats_sent(ps2_keyboard_task());
     } else {
-        mode_change_time = 0;
+        ps2_trace_drain(PS2_TRACE_DRAIN_BATCH);
     }
 
-    // Run PS/2 task only in PS/2 mode
-    if (!usb_mode) {
-        ps2_keyboard_task();
-    }
+    // Every loop: the key log groups events by the scan they came from
+    ps2_keylog_task();
 
     housekeeping_task_user();
 }
 
 bool process_record_kb(uint16_t keycode, keyrecord_t *record) {
-    // In PS/2 mode, ensure the correct driver is set BEFORE processing
-    if (!usb_mode) {
-        if (host_get_driver() != &ps2_keyboard_host_driver) {
-            uprintf("[ERROR] Wrong driver in PS/2 mode! Fixing...\n");
-            host_set_driver(&ps2_keyboard_host_driver);
+    // Ensure the fan-out driver is still set BEFORE processing
+    if (original_usb_driver != NULL) {
+        if (host_get_driver() != &host_fanout_driver) {
+            uprintf("[ERROR] Fan-out driver replaced! Fixing...\n");
+            host_set_driver(&host_fanout_driver);
         }
+        // Keystroke latency is measured from here to the wire
+        ps2_stats_key_event(record->event.time);
+    }
+    if (keycode != PS2_KEYLOG) {
+        ps2_keylog_event(keycode, record->event.pressed);
     }
 
     if (!process_record_user(keycode, record)) {
         return false;
     }
 
-    if (record->event.pressed) {
-        uprintf("[DEBUG] Key pressed: keycode=0x%04X (%s mode)\n",
-                keycode, usb_mode ? "USB" : "PS/2");
-    } else {
-        uprintf("[DEBUG] Key released: keycode=0x%04X (%s mode)\n",
-                keycode, usb_mode ? "USB" : "PS/2");
+    switch (keycode) {
+        case PS2_STATS:
+            if (record->event.pressed) {
+                ps2_stats_dump();
+            }
+            return false;
+
+        case PS2_STATS_RESET:
+            if (record->event.pressed) {
+                ps2_stats_reset();
+                uprintf("[PS2] Latency stats reset\n");
+            }
+            return false;
+
+        case PS2_KEYLOG:
+            if (record->event.pressed) {
+                if (ps2_keylog_recording()) {
+                    ps2_keylog_stop();
+                } else {
+                    ps2_keylog_start();
+                }
+            }
+            return false;
     }
 
+    PS2_TRACE_DEBUG(record->event.pressed ? PS2_EV_MATRIX_PRESS : PS2_EV_MATRIX_RELEASE,
+                    keycode, 0, usb_mode);
+
     return true;
 }
 
 bool led_update_kb(led_t led_state) {
-    // In PS/2 mode, block LED updates from USB
-    // This prevents USB from sending any HID reports
-    if (!usb_mode) {
-        return false;  // Don't process LED updates in PS/2 mode
-    }
+    // LED state comes from the host the mode switch selects: the USB host's
+    // output report in USB mode, the PS/2 host's Set LEDs (0xED) command in
+    // PS/2 mode
     return led_update_user(led_state);
 }
 
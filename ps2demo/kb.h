@@ -22,6 +22,13 @@
 // For keyboards with direct pin matrix (no diode matrix scanning)
 // QMK will handle this automatically with DIRECT_PINS in config.h
 
+// Keyboard keycodes
+enum ps2demo_keycodes {
+    PS2_STATS = QK_KB_0,  // Print PS/2 latency histograms and counters
+    PS2_STATS_RESET,      // Clear them
+    PS2_KEYLOG,           // Start recording key events, or stop and print the log
+};
+
 // Optional: Add any keyboard-specific functions here
 void keyboard_pre_init_kb(void);
 void keyboard_post_init_kb(void);
@@ -0,0 +1,735 @@
+// ps2_bus.c - Device-side PS/2 wire engine
+#include "ps2_bus.h"
+#include "ps2_stats.h"
+#include "ps2_trace.h"
+#include "quantum.h"  // QMK main header with GPIO functions
+#include <string.h>
+
+// =============================================================================
+// TIMING PROFILES
+// =============================================================================
+
+static const ps2_timing_profile_t ps2_timing_profiles[PS2_TIMING_PROFILE_COUNT] = {
+    // ~15kHz, inside the 10-16.7kHz the spec allows
+    [PS2_TIMING_SPEC_FAST]    = {"spec-fast",    12,  33,  21,  50, 100,  50},
+    // 10kHz with generous gaps
+    [PS2_TIMING_CONSERVATIVE] = {"conservative", 25,  50,  25, 100, 300,  50},
+    // v2.0 timing (~3.3kHz), slow but accepted by everything tested so far
+    [PS2_TIMING_KVM_SAFE]     = {"kvm-safe",    100, 100, 100, 100, 300, 100},
+};
+
+void ps2_bus_set_timing(ps2_port_t *port, ps2_timing_profile_id_t profile) {
+    if (profile < PS2_TIMING_PROFILE_COUNT) {
+        port->timing = &ps2_timing_profiles[profile];
+    }
+}
+
+#if PS2_GPIO_DIRECT
+// Open drain on the SIO block: the output latch is held low from
+// ps2_bus_init(), so enabling a pin's output driver pulls the line low and
+// disabling it lets the pull-up take it high. Each edge is a single store
+// to a set/clear alias, with the mask worked out at init.
+static inline void ps2_clk_high(ps2_port_t *port) {
+    SIO->GPIO_OE_CLR = port->clk_mask;
+}
+
+static inline void ps2_clk_low(ps2_port_t *port) {
+    SIO->GPIO_OE_SET = port->clk_mask;
+}
+
+static inline void ps2_data_high(ps2_port_t *port) {
+    SIO->GPIO_OE_CLR = port->data_mask;
+}
+
+static inline void ps2_data_low(ps2_port_t *port) {
+    SIO->GPIO_OE_SET = port->data_mask;
+}
+
+static inline bool ps2_clk_read(ps2_port_t *port) {
+    return (SIO->GPIO_IN & port->clk_mask) != 0;
+}
+
+static inline bool ps2_data_read(ps2_port_t *port) {
+    return (SIO->GPIO_IN & port->data_mask) != 0;
+}
+#else
+// Helper functions using QMK GPIO API
+static inline void ps2_clk_high(ps2_port_t *port) {
+    setPinInput(port->clk_pin);  // Release to pullup (high-Z with pullup)
+}
+
+static inline void ps2_clk_low(ps2_port_t *port) {
+    writePinLow(port->clk_pin);
+    setPinOutput(port->clk_pin);
+}
+
+static inline void ps2_data_high(ps2_port_t *port) {
+    setPinInput(port->data_pin);  // Release to pullup (high-Z with pullup)
+}
+
+static inline void ps2_data_low(ps2_port_t *port) {
+    writePinLow(port->data_pin);
+    setPinOutput(port->data_pin);
+}
+
+static inline bool ps2_clk_read(ps2_port_t *port) {
+    return readPin(port->clk_pin);
+}
+
+static inline bool ps2_data_read(ps2_port_t *port) {
+    return readPin(port->data_pin);
+}
+#endif
+
+// =============================================================================
+// TRANSMIT ENGINE
+// =============================================================================
+// Each byte goes out as an 11-bit frame (start, 8 data bits LSB first, odd
+// parity, stop). Instead of bit-banging the whole frame with wait_us(), the
+// frame is split into phases and every timer tick advances exactly one phase,
+// so the main loop (matrix scan, debounce, mode detection) keeps running
+// between clock edges.
+
+// Re-check interval (us) while the host holds CLK low
+#define PS2_INHIBIT_POLL    1000
+
+static uint16_t ps2_rx_begin(ps2_port_t *port);
+
+// Build the 11-bit frame for a byte once, when it is loaded: start(0), data,
+// odd parity, stop(1). 0x6996 holds the parity of every nibble, so the
+// parity bit takes a fold and a shift instead of a loop over the bits.
+static uint16_t ps2_tx_build_frame(uint8_t data) {
+    uint8_t odd = (0x6996 >> ((data ^ (data >> 4)) & 0x0F)) & 1;
+    return ((uint16_t)data << 1) | ((uint16_t)(odd ^ 1) << 9) | (1 << 10);
+}
+
+// Bytes of one packet go out back to back with the short burst gap
+static inline bool ps2_tx_in_burst(ps2_port_t *port) {
+    return port->tx.index > 1;
+}
+
+static inline bool ps2_tx_burst_follows(ps2_port_t *port) {
+    return port->tx.index < port->tx.packet.len;
+}
+
+// Load the next byte into the engine: the rest of the current packet first,
+// then the next packet from the queue. Returns false if nothing to send.
+static bool ps2_tx_load_next(ps2_port_t *port) {
+    if (!ps2_tx_burst_follows(port)) {
+        if (!ps2_queue_pop(&port->queue, &port->tx.packet)) {
+            port->tx.packet.len = 0;
+            port->tx.index = 0;
+            return false;
+        }
+        port->tx.index = 0;
+        port->tx.started_us = ps2_stats_now();
+#if PS2_STATS_ENABLE
+        if (port->timed) {
+            ps2_stats_record(PS2_STAGE_QUEUE, port->tx.started_us - port->tx.packet.queued_us);
+        }
+#endif
+    }
+    port->tx.frame = ps2_tx_build_frame(port->tx.packet.bytes[port->tx.index++]);
+    port->tx.bit = 0;
+    port->tx.phase = PS2_TX_PHASE_START;
+    return true;
+}
+
+// Last stop bit of a packet is out: keep it for a host Resend and time it
+static void ps2_tx_packet_done(ps2_port_t *port) {
+    port->tx_last_packet = port->tx.packet;
+#if PS2_STATS_ENABLE
+    if (!port->timed) {
+        return;
+    }
+    uint32_t now = ps2_stats_now();
+    ps2_stats_record(PS2_STAGE_WIRE, now - port->tx.started_us);
+    if (port->tx.packet.origin_us != 0) {
+        ps2_stats_record(PS2_STAGE_TOTAL, now - port->tx.packet.origin_us);
+    }
+#else
+    (void)port;
+#endif
+}
+
+// The host wants the bus before the loaded byte is through: put that byte
+// and the rest of its packet back at the head of the queue, so whatever the
+// host asks for is answered first and the byte goes out again after it. If
+// the queue filled up meanwhile the byte stays loaded and restarts from
+// PHASE_START instead.
+static void ps2_tx_requeue(ps2_port_t *port) {
+    ps2_packet_t rest = port->tx.packet;
+    uint8_t from = port->tx.index - 1;
+    rest.len -= from;
+    memmove(rest.bytes, rest.bytes + from, rest.len);
+    if (ps2_queue_push_front(&port->queue, &rest)) {
+        port->tx.packet.len = 0;
+        port->tx.index = 0;
+        port->tx.phase = PS2_TX_PHASE_DONE;
+    } else {
+        port->tx.frame = ps2_tx_build_frame(port->tx.packet.bytes[port->tx.index - 1]);
+        port->tx.bit = 0;
+        port->tx.phase = PS2_TX_PHASE_START;
+    }
+}
+
+// Host pulled CLK low before the 11th clock: it is inhibiting or about to
+// send, and throws away the partial byte. Let go of the lines and send the
+// byte again once the host is done.
+static uint16_t ps2_tx_abort(ps2_port_t *port) {
+    ps2_data_high(port);
+    ps2_clk_high(port);
+    port->host_seen = true;
+    port->tx_aborts++;
+    ps2_tx_requeue(port);
+    if (port->tx.phase == PS2_TX_PHASE_START) {
+        return PS2_INHIBIT_POLL;
+    }
+    port->state = PS2_STATE_IDLE;
+    return 0;
+}
+
+// Advance the transmit engine by one phase.
+// Returns the delay in microseconds until the next tick, or 0 when done.
+static uint16_t ps2_tx_tick(ps2_port_t *port) {
+    const ps2_timing_profile_t *timing = port->timing;
+
+    switch (port->tx.phase) {
+        case PS2_TX_PHASE_START:
+            // Ensure idle state before starting
+            ps2_data_high(port);
+            ps2_clk_high(port);
+
+            // Host is inhibiting (CLK held low): keep the byte and retry
+            if (!ps2_clk_read(port)) {
+                port->host_seen = true;
+                return PS2_INHIBIT_POLL;
+            }
+            // Host request-to-send (DATA low, CLK released): receive first,
+            // this byte goes back to the queue behind the answer
+            if (!ps2_data_read(port)) {
+                ps2_tx_requeue(port);
+                return ps2_rx_begin(port);
+            }
+
+            port->tx.phase = PS2_TX_PHASE_SETUP;
+            return ps2_tx_in_burst(port) ? timing->burst_gap : timing->idle;
+
+        case PS2_TX_PHASE_SETUP:
+            // Read the clock back before every bit: low while we released
+            // it means the host is holding it
+            if (!ps2_clk_read(port)) {
+                return ps2_tx_abort(port);
+            }
+            // Set data line FIRST, while the clock is high. The frame is
+            // shifted out LSB first, so the bit on the wire is always bit 0.
+            if (port->tx.frame & 1) {
+                ps2_data_high(port);
+            } else {
+                ps2_data_low(port);
+            }
+            port->tx.frame >>= 1;
+            port->tx.phase = PS2_TX_PHASE_CLK_LOW;
+            return timing->setup;
+
+        case PS2_TX_PHASE_CLK_LOW:
+            if (!ps2_clk_read(port)) {
+                return ps2_tx_abort(port);
+            }
+            ps2_clk_low(port);
+            port->tx.phase = PS2_TX_PHASE_CLK_HIGH;
+            return timing->low;
+
+        case PS2_TX_PHASE_CLK_HIGH:
+            ps2_clk_high(port);
+            port->tx.bit++;
+            port->tx.phase = (port->tx.bit < 11) ? PS2_TX_PHASE_SETUP : PS2_TX_PHASE_GAP;
+            return timing->hold;
+
+        case PS2_TX_PHASE_GAP:
+            // Both clock and data must be high (idle) between bytes
+            ps2_data_high(port);
+            ps2_clk_high(port);
+            port->tx.phase = PS2_TX_PHASE_DONE;
+            port->tx_last_byte = port->tx.packet.bytes[port->tx.index - 1];
+            port->tx_bytes_sent++;
+            // Rest of a multi-byte sequence follows back to back
+            if (ps2_tx_burst_follows(port)) {
+                return timing->burst_gap;
+            }
+            ps2_tx_packet_done(port);
+            return timing->gap;
+
+        case PS2_TX_PHASE_DONE:
+        default:
+            return 0;
+    }
+}
+
+// =============================================================================
+// RECEIVE ENGINE (host-to-device)
+// =============================================================================
+// The host requests to send by holding CLK low, pulling DATA low (start bit)
+// and releasing CLK. The device then generates the clock: the host changes
+// DATA while CLK is low and we sample it while CLK is high. After the stop
+// bit we pull DATA low for one more clock pulse as the ACK bit.
+
+// Max extra clock pulses while waiting for a late stop bit
+#define PS2_RX_MAX_STOP_RETRIES 4
+
+static inline bool ps2_host_request_to_send(ps2_port_t *port) {
+    return ps2_clk_read(port) && !ps2_data_read(port);
+}
+
+// Switch the engine into receive mode. Returns the delay until the first tick.
+static uint16_t ps2_rx_begin(ps2_port_t *port) {
+    port->host_seen = true;
+    port->state = PS2_STATE_RECEIVING;
+    port->rx.phase = PS2_RX_PHASE_CLK_LOW;
+    port->rx.frame = 0;  // Start bit (0) already on the line
+    port->rx.bit = 0;
+    port->rx.stop_retries = 0;
+    return port->timing->setup;
+}
+
+static bool ps2_rx_frame_valid(uint16_t frame) {
+    uint8_t ones = 0;
+    for (uint8_t i = 1; i <= 9; i++) {
+        ones += (frame >> i) & 1;
+    }
+    return (ones & 1) == 1;  // Odd parity over data + parity bit
+}
+
+// Receive finished (or aborted). Go back to sending whatever is pending.
+static uint16_t ps2_rx_finish(ps2_port_t *port) {
+    ps2_data_high(port);
+    ps2_clk_high(port);
+    port->state = PS2_STATE_SENDING;
+    return port->timing->gap;
+}
+
+// Advance the receive engine by one phase.
+static uint16_t ps2_rx_tick(ps2_port_t *port) {
+    const ps2_timing_profile_t *timing = port->timing;
+
+    switch (port->rx.phase) {
+        case PS2_RX_PHASE_CLK_LOW:
+            ps2_clk_low(port);
+            port->rx.phase = PS2_RX_PHASE_CLK_HIGH;
+            return timing->low;
+
+        case PS2_RX_PHASE_CLK_HIGH:
+            ps2_clk_high(port);
+            port->rx.phase = PS2_RX_PHASE_SAMPLE;
+            return timing->hold;
+
+        case PS2_RX_PHASE_SAMPLE:
+            // Host pulled CLK low mid-frame: it gave up on this byte
+            if (!ps2_clk_read(port)) {
+                return ps2_rx_finish(port);
+            }
+
+            if (port->rx.bit < 10) {
+                port->rx.bit++;
+            }
+            if (ps2_data_read(port)) {
+                port->rx.frame |= (1 << port->rx.bit);
+            }
+
+            if (port->rx.bit < 10) {
+                port->rx.phase = PS2_RX_PHASE_CLK_LOW;
+            } else if (port->rx.frame & (1 << 10)) {
+                port->rx.phase = PS2_RX_PHASE_ACK;
+            } else if (port->rx.stop_retries++ < PS2_RX_MAX_STOP_RETRIES) {
+                // Stop bit not seen yet: keep clocking until DATA goes high
+                port->rx.phase = PS2_RX_PHASE_CLK_LOW;
+            } else {
+                port->rx_mailbox = PS2_RX_MAILBOX_FULL | PS2_RX_MAILBOX_ERROR;
+                return ps2_rx_finish(port);
+            }
+            return timing->setup;
+
+        case PS2_RX_PHASE_ACK:
+            ps2_data_low(port);
+            ps2_clk_low(port);
+            port->rx.phase = PS2_RX_PHASE_ACK_HIGH;
+            return timing->low;
+
+        case PS2_RX_PHASE_ACK_HIGH:
+            ps2_clk_high(port);
+            port->rx.phase = PS2_RX_PHASE_END;
+            return timing->hold;
+
+        case PS2_RX_PHASE_END:
+        default:
+            if (ps2_rx_frame_valid(port->rx.frame) && port->rx.stop_retries == 0) {
+                port->rx_mailbox = PS2_RX_MAILBOX_FULL | ((port->rx.frame >> 1) & 0xFF);
+            } else {
+                port->rx_mailbox = PS2_RX_MAILBOX_FULL | PS2_RX_MAILBOX_ERROR;
+            }
+            return ps2_rx_finish(port);
+    }
+}
+
+// Called on every timer tick. Chains straight into the next queued byte so
+// back-to-back bytes don't wait for the main loop.
+static uint16_t ps2_tick(ps2_port_t *port) {
+    switch (port->state) {
+        case PS2_STATE_RECEIVING:
+            return ps2_rx_tick(port);
+
+        case PS2_STATE_SENDING:
+            // A byte from the host is answered before anything else goes
+            // out: wait for the task to take it and queue the reply
+            if (port->tx.phase == PS2_TX_PHASE_DONE &&
+                ((port->rx_mailbox & PS2_RX_MAILBOX_FULL) || !ps2_tx_load_next(port))) {
+                port->state = PS2_STATE_IDLE;
+                return 0;
+            }
+            return ps2_tx_tick(port);
+
+        default:
+            return 0;
+    }
+}
+
+// =============================================================================
+// SCHEDULER
+// =============================================================================
+// Every port runs off one timer. An armed port has a deadline for its next
+// phase; the timer fires at the earliest deadline and advances every port
+// that is due in the same tick. The ports' clocks interleave edge by edge,
+// so a byte on one never waits for a byte on the other.
+
+#ifndef PS2_BUS_MAX_PORTS
+#define PS2_BUS_MAX_PORTS 2  // Keyboard and mouse
+#endif
+
+#ifndef PS2_TASK_BUDGET_US
+#define PS2_TASK_BUDGET_US 0  // Polled backend: busy time per task call, past the frame in flight
+#endif
+
+#if defined(PROTOCOL_CHIBIOS)
+#define PS2_BUS_LOCK()   chSysLock()
+#define PS2_BUS_UNLOCK() chSysUnlock()
+
+// Busy-wait on the system timer. wait_us() may sleep the thread, which is
+// illegal in an ISR or with the system locked; reading the timer is not.
+static void ps2_spin_until(uint32_t deadline) {
+    while ((int32_t)(ps2_micros() - deadline) < 0) {
+    }
+}
+#else
+#define PS2_BUS_LOCK()
+#define PS2_BUS_UNLOCK()
+#endif
+
+static ps2_port_t *ps2_ports[PS2_BUS_MAX_PORTS];
+static uint8_t ps2_port_count = 0;
+
+// Advance every port that is due. The next phase is timed from now, so a
+// late tick only ever stretches a phase. How late each edge is goes to the
+// latency statistics. Called with the lock held.
+static void ps2_sched_run_due(uint32_t now) {
+    for (uint8_t i = 0; i < ps2_port_count; i++) {
+        ps2_port_t *port = ps2_ports[i];
+        if (!port->armed || (int32_t)(now - port->deadline) < 0) {
+            continue;
+        }
+        ps2_stats_record(PS2_STAGE_EDGE, now - port->deadline);
+        uint16_t next_us = ps2_tick(port);
+        port->deadline = now + next_us;
+        port->armed = next_us != 0;
+    }
+}
+
+// Earliest deadline of any armed port, false if none is armed
+static bool ps2_sched_next(uint32_t *deadline) {
+    bool found = false;
+    for (uint8_t i = 0; i < ps2_port_count; i++) {
+        ps2_port_t *port = ps2_ports[i];
+        if (port->armed && (!found || (int32_t)(port->deadline - *deadline) < 0)) {
+            *deadline = port->deadline;
+            found = true;
+        }
+    }
+    return found;
+}
+
+#if defined(PROTOCOL_CHIBIOS)
+// ChibiOS virtual timer, callbacks run in ISR context. The timer is set
+// PS2_EDGE_LEAD_US early and the callback spins out the rest with
+// interrupts masked, so a USB interrupt that delays the callback by less
+// than that doesn't move the edge. 0 runs the phase whenever the callback
+// gets to it.
+#ifndef PS2_EDGE_LEAD_US
+#define PS2_EDGE_LEAD_US 3
+#endif
+
+static virtual_timer_t ps2_sched_timer;
+
+static void ps2_sched_callback(virtual_timer_t *vtp, void *arg);
+
+// Point the timer at the earliest deadline. Called with the lock held.
+static void ps2_sched_arm_i(uint32_t now) {
+    uint32_t deadline = 0;
+    chVTResetI(&ps2_sched_timer);
+    if (ps2_sched_next(&deadline)) {
+        int32_t delay = (int32_t)(deadline - now) - PS2_EDGE_LEAD_US;
+        chVTSetI(&ps2_sched_timer, TIME_US2I(delay > 0 ? delay : 1), ps2_sched_callback, NULL);
+    }
+}
+
+static void ps2_sched_callback(virtual_timer_t *vtp, void *arg) {
+    (void)vtp;
+    (void)arg;
+    chSysLockFromISR();
+    uint32_t now = ps2_micros();
+    uint32_t deadline = 0;
+    while (ps2_sched_next(&deadline) && (int32_t)(deadline - now) <= PS2_EDGE_LEAD_US) {
+        if ((int32_t)(deadline - now) > 0) {
+            ps2_spin_until(deadline);
+            now = deadline;
+        }
+        ps2_sched_run_due(now);
+    }
+    ps2_sched_arm_i(now);
+    chSysUnlockFromISR();
+}
+
+static void ps2_sched_init(void) {
+    static bool initialized = false;
+    if (!initialized) {
+        chVTObjectInit(&ps2_sched_timer);
+        initialized = true;
+    }
+}
+
+static inline void ps2_sched_poll(void) {}
+#else
+static inline void ps2_sched_init(void) {}
+
+// Inside a frame in either direction. A frame is never left half done
+// between polls: an inhibit that came and went unseen would leave the host
+// discarding the byte while we finish it.
+static bool ps2_sched_mid_frame(void) {
+    for (uint8_t i = 0; i < ps2_port_count; i++) {
+        ps2_port_t *port = ps2_ports[i];
+        if (port->state == PS2_STATE_RECEIVING ||
+            (port->state == PS2_STATE_SENDING && port->tx.phase >= PS2_TX_PHASE_SETUP &&
+             port->tx.phase <= PS2_TX_PHASE_CLK_HIGH)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Without a hardware timer, each call runs the ports for up to
+// PS2_TASK_BUDGET_US (longer to finish a frame), busy-waiting between their
+// deadlines. A late poll stretches a phase instead of collapsing several
+// edges together.
+static void ps2_sched_poll(void) {
+    uint32_t now = ps2_micros();
+    uint32_t deadline = 0;
+    if (!ps2_sched_next(&deadline) || (int32_t)(now - deadline) < 0) {
+        return;
+    }
+
+    uint32_t spent = 0;
+    while (true) {
+        ps2_sched_run_due(now);
+        if (!ps2_sched_next(&deadline)) {
+            return;
+        }
+        int32_t wait = (int32_t)(deadline - now);
+        if (wait <= 0) {
+            continue;
+        }
+        if (spent + wait > PS2_TASK_BUDGET_US && !ps2_sched_mid_frame()) {
+            // Leave the rest to the next call, timed from the clock it reads
+            uint32_t shift = ps2_micros() - now;
+            for (uint8_t i = 0; i < ps2_port_count; i++) {
+                ps2_ports[i]->deadline += shift;
+            }
+            return;
+        }
+        wait_us(wait);
+        spent += wait;
+        now = deadline;  // The clock only has millisecond resolution
+    }
+}
+#endif
+
+// Join the scheduler, or drop a frame still in flight on re-init
+static void ps2_sched_add(ps2_port_t *port) {
+    ps2_sched_init();
+
+    PS2_BUS_LOCK();
+    port->armed = false;
+    bool known = false;
+    for (uint8_t i = 0; i < ps2_port_count; i++) {
+        known |= ps2_ports[i] == port;
+    }
+    if (!known && ps2_port_count < PS2_BUS_MAX_PORTS) {
+        ps2_ports[ps2_port_count++] = port;
+        known = true;
+    }
+    PS2_BUS_UNLOCK();
+
+    if (!known) {
+        uprintf("[PS2] ERROR: more than %d ports, raise PS2_BUS_MAX_PORTS\n", PS2_BUS_MAX_PORTS);
+    }
+}
+
+// Run the first phase now and hand the rest to the scheduler
+// delay_us 0 runs the first phase now, anything else waits that long
+static void ps2_sched_start(ps2_port_t *port, uint16_t delay_us) {
+    PS2_BUS_LOCK();
+    if (!port->armed) {
+        uint32_t now = ps2_micros();
+        uint16_t next_us = delay_us ? delay_us : ps2_tick(port);
+        port->deadline = now + next_us;
+        port->armed = next_us != 0;
+#if defined(PROTOCOL_CHIBIOS)
+        if (port->armed) {
+            ps2_sched_arm_i(now);
+        }
+#endif
+    }
+    PS2_BUS_UNLOCK();
+}
+
+// Kick the engine if it is idle and the host or the queue has work for it
+static void ps2_engine_kick(ps2_port_t *port) {
+    if (port->state != PS2_STATE_IDLE) {
+        return;
+    }
+    if (ps2_host_request_to_send(port)) {
+        // The host only starts watching for our clock once it let go of
+        // it: the first low comes a setup time later, never straight away
+        ps2_sched_start(port, ps2_rx_begin(port));
+    } else if (ps2_tx_load_next(port)) {
+        port->state = PS2_STATE_SENDING;
+        ps2_sched_start(port, 0);
+    }
+}
+
+// =============================================================================
+// PORT API
+// =============================================================================
+
+void ps2_bus_init(ps2_port_t *port, uint8_t clk_pin, uint8_t data_pin) {
+    ps2_sched_add(port);
+
+    port->clk_pin = clk_pin;
+    port->data_pin = data_pin;
+
+    // Set pins as inputs with pullups
+#if PS2_GPIO_DIRECT
+    port->clk_mask = 1UL << clk_pin;
+    port->data_mask = 1UL << data_pin;
+    writePinLow(clk_pin);  // Latch stays low, the engine only flips the driver
+    writePinLow(data_pin);
+#endif
+    setPinInputHigh(clk_pin);
+    setPinInputHigh(data_pin);
+
+    if (!port->timing) {
+        port->timing = &ps2_timing_profiles[PS2_TIMING_SPEC_FAST];
+    }
+    port->state = PS2_STATE_IDLE;
+    port->tx.phase = PS2_TX_PHASE_DONE;
+    port->tx.packet.len = 0;
+    port->tx.index = 0;
+    port->tx_last_packet.len = 0;
+    port->tx_aborts = 0;
+    ps2_queue_clear(&port->queue);
+    port->rx_mailbox = 0;
+}
+
+void ps2_bus_service(ps2_port_t *port, void (*received)(uint16_t mailbox)) {
+    ps2_sched_poll();
+
+    // Counted here: the trace ring is only written from the main loop
+    uint8_t aborts = port->tx_aborts;
+    if (aborts) {
+        port->tx_aborts -= aborts;
+        PS2_TRACE_WARN(PS2_EV_TX_ABORT, aborts, 0, port->clk_pin);
+        while (aborts--) {
+            ps2_stats_count(PS2_COUNT_TX_ABORT);
+        }
+    }
+
+    uint16_t mailbox = port->rx_mailbox;
+    if (mailbox & PS2_RX_MAILBOX_FULL) {
+        port->rx_mailbox = 0;
+        received(mailbox);
+    }
+
+    ps2_engine_kick(port);
+}
+
+bool ps2_bus_is_idle(const ps2_port_t *port) {
+    return port->state == PS2_STATE_IDLE && ps2_queue_is_empty(&port->queue);
+}
+
+uint8_t ps2_bus_take_sent(ps2_port_t *port) {
+    uint8_t sent = port->tx_bytes_sent;
+    port->tx_bytes_sent -= sent;
+    return sent;
+}
+
+bool ps2_bus_resend(ps2_port_t *port, bool whole_packet) {
+    ps2_packet_t packet = {.len = 1, .priority = PS2_PRIO_RESPONSE};
+    PS2_BUS_LOCK();
+    if (whole_packet && port->tx_last_packet.len != 0) {
+        packet.len = port->tx_last_packet.len;
+        memcpy(packet.bytes, port->tx_last_packet.bytes, packet.len);
+    } else {
+        packet.bytes[0] = port->tx_last_byte;
+    }
+    bool queued = ps2_queue_push_front(&port->queue, &packet);
+    PS2_BUS_UNLOCK();
+    return queued;
+}
+
+// Time for a line to follow our pull resistor when nothing else drives it
+#ifndef PS2_PROBE_SETTLE_US
+#define PS2_PROBE_SETTLE_US 5
+#endif
+
+// Called with the lock held: a spin on ChibiOS, where wait_us() may sleep.
+// One tick more, as the first one may be nearly over.
+static void ps2_probe_settle(void) {
+#if defined(PROTOCOL_CHIBIOS)
+    ps2_spin_until(ps2_micros() + PS2_PROBE_SETTLE_US + 1);
+#else
+    wait_us(PS2_PROBE_SETTLE_US);
+#endif
+}
+
+bool ps2_bus_probe_host(ps2_port_t *port) {
+    bool seen = port->host_seen;
+    port->host_seen = false;
+    if (seen || !ps2_bus_is_idle(port) || port->armed) {
+        return true;
+    }
+
+    PS2_BUS_LOCK();
+    // Low against our pull-ups: the host is inhibiting or about to send
+    setPinInputHigh(port->clk_pin);
+    setPinInputHigh(port->data_pin);
+    ps2_probe_settle();
+    bool driven_low = !ps2_clk_read(port) || !ps2_data_read(port);
+
+    // High against our pull-downs: the host's pull-ups (an open port reads low)
+    setPinInputLow(port->clk_pin);
+    setPinInputLow(port->data_pin);
+    ps2_probe_settle();
+    bool pulled_up = ps2_clk_read(port) && ps2_data_read(port);
+
+    setPinInputHigh(port->clk_pin);
+    setPinInputHigh(port->data_pin);
+    PS2_BUS_UNLOCK();
+    return driven_low || pulled_up;
+}
@@ -0,0 +1,168 @@
+// ps2_bus.h - Device-side PS/2 wire engine, one instance per port
+//
+// A port owns its CLK/DATA pins, its send queue and the transmit and receive
+// state machines. The protocol on top (keyboard, mouse) pushes packets into
+// port->queue and calls ps2_bus_service() from its task; the engine clocks
+// them out and hands back what the host sends. One scheduler drives every
+// port from a single timer, so ports transmit at the same time.
+#ifndef PS2_BUS_H
+#define PS2_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ps2_queue.h"
+#include "quantum.h"
+
+#if defined(PROTOCOL_CHIBIOS)
+#include <ch.h>  // Virtual timer drives the scheduler
+#endif
+
+// RP2040: the engine drives CLK and DATA through the SIO registers, one
+// store per edge, instead of QMK's per-pin GPIO calls. 0 forces the QMK
+// calls (what every other target and the simulation use).
+#ifndef PS2_GPIO_DIRECT
+#if defined(MCU_RP)
+#define PS2_GPIO_DIRECT 1
+#else
+#define PS2_GPIO_DIRECT 0
+#endif
+#endif
+
+// PS/2 Responses (keyboard and mouse)
+#define PS2_ACK                    0xFA
+#define PS2_RESEND                 0xFE
+#define PS2_BAT_SUCCESS            0xAA
+#define PS2_BAT_FAIL               0xFC
+#define PS2_ECHO_RESPONSE          0xEE
+
+// Bus timing profiles, fastest first. The keyboard steps down one profile
+// when the host keeps asking for resends or sends garbled frames.
+typedef enum {
+    PS2_TIMING_SPEC_FAST,
+    PS2_TIMING_CONSERVATIVE,
+    PS2_TIMING_KVM_SAFE,
+    PS2_TIMING_PROFILE_COUNT
+} ps2_timing_profile_id_t;
+
+// All times in microseconds. A clock cycle is setup + low + hold: DATA changes
+// `hold` after the rising edge and must be stable `setup` before the falling
+// edge, so the clock high time is hold + setup.
+typedef struct {
+    const char *name;
+    uint8_t setup;       // DATA stable before CLK falls
+    uint8_t low;         // CLK low time
+    uint8_t hold;        // CLK high time before DATA may change
+    uint16_t idle;       // Lines released before a start bit
+    uint16_t gap;        // Lines released after a stop bit
+    uint16_t burst_gap;  // Idle between bytes of one sequence
+} ps2_timing_profile_t;
+
+// PS/2 State Machine
+typedef enum {
+    PS2_STATE_IDLE,
+    PS2_STATE_SENDING,
+    PS2_STATE_RECEIVING,
+    PS2_STATE_WAIT_RESPONSE
+} ps2_state_t;
+
+typedef enum {
+    PS2_TX_PHASE_START,     // Release lines, wait before start bit
+    PS2_TX_PHASE_SETUP,     // Put the next bit on DATA (clock high)
+    PS2_TX_PHASE_CLK_LOW,   // Falling edge - host samples DATA
+    PS2_TX_PHASE_CLK_HIGH,  // Rising edge - move on to the next bit
+    PS2_TX_PHASE_GAP,       // Frame done, hold idle before the next byte
+    PS2_TX_PHASE_DONE       // Byte fully on the wire
+} ps2_tx_phase_t;
+
+typedef enum {
+    PS2_RX_PHASE_CLK_LOW,   // Falling edge - host may change DATA
+    PS2_RX_PHASE_CLK_HIGH,  // Rising edge
+    PS2_RX_PHASE_SAMPLE,    // Middle of clock high - read DATA
+    PS2_RX_PHASE_ACK,       // Drive ACK bit and clock it
+    PS2_RX_PHASE_ACK_HIGH,  // Release clock after ACK pulse
+    PS2_RX_PHASE_END        // Release DATA and hand the byte over
+} ps2_rx_phase_t;
+
+// Byte received from the host, as handed to the service callback
+#define PS2_RX_MAILBOX_FULL  0x100
+#define PS2_RX_MAILBOX_ERROR 0x200  // Bad parity or no stop bit
+
+typedef struct {
+    uint8_t clk_pin;
+    uint8_t data_pin;
+#if PS2_GPIO_DIRECT
+    uint32_t clk_mask;   // 1 << pin, worked out once in ps2_bus_init()
+    uint32_t data_mask;
+#endif
+    bool timed;  // Feeds the keystroke latency statistics
+
+    volatile ps2_state_t state;
+    const ps2_timing_profile_t *volatile timing;
+    ps2_queue_t queue;
+
+    struct {
+        ps2_tx_phase_t phase;
+        uint16_t frame;       // Bits of the frame still to send, next in bit 0
+        uint8_t bit;          // Index of the bit currently on the wire (0-10)
+        ps2_packet_t packet;  // Sequence being sent
+        uint8_t index;        // Next byte of the packet to send
+        uint32_t started_us;  // When the packet left the queue (latency stats)
+    } tx;
+
+    struct {
+        ps2_rx_phase_t phase;
+        uint16_t frame;       // Start, data, parity and stop bits, LSB first
+        uint8_t bit;          // Index of the last sampled bit (0 = start)
+        uint8_t stop_retries;
+    } rx;
+
+    volatile uint16_t rx_mailbox;    // Received byte until the task takes it
+    volatile uint8_t tx_last_byte;   // For answering a host Resend (0xFE)
+    ps2_packet_t tx_last_packet;     // Last packet completed, same purpose
+    volatile uint8_t tx_bytes_sent;  // Since the last ps2_bus_take_sent()
+    volatile uint8_t tx_aborts;      // Bytes the host cut off, not yet counted
+
+    // Scheduler: when the next phase of this port is due
+    volatile uint32_t deadline;
+    volatile bool armed;
+
+    volatile bool host_seen;  // Host inhibited or sent to us since the last probe
+} ps2_port_t;
+
+// Microsecond clock for deadlines (wraps every ~71 minutes, so compare with
+// (int32_t)(a - b)). Without ChibiOS only the millisecond timer exists.
+static inline uint32_t ps2_micros(void) {
+#if defined(PROTOCOL_CHIBIOS)
+    return TIME_I2US(chVTGetSystemTimeX());  // 1MHz system timer on the RP2040
+#else
+    return timer_read32() * 1000UL;
+#endif
+}
+
+// Release both lines and reset the port: any frame in flight and every
+// queued packet is dropped
+void ps2_bus_init(ps2_port_t *port, uint8_t clk_pin, uint8_t data_pin);
+void ps2_bus_set_timing(ps2_port_t *port, ps2_timing_profile_id_t profile);
+
+// Keep the bus moving: advance the polled backend (every port), pass a byte
+// the host sent to received (if any), then start the engine if there is work
+void ps2_bus_service(ps2_port_t *port, void (*received)(uint16_t mailbox));
+
+// Nothing on the wire and nothing queued
+bool ps2_bus_is_idle(const ps2_port_t *port);
+
+// Bytes completed since the last call
+uint8_t ps2_bus_take_sent(ps2_port_t *port);
+
+// Answer a host Resend (0xFE): queue the last byte sent again, or with
+// whole_packet the whole packet it ended, ahead of anything else pending.
+// False if the queue is full.
+bool ps2_bus_resend(ps2_port_t *port, bool whole_packet);
+
+// Whether a host is connected: it inhibited or talked to us since the last
+// call, holds a line low, or its pull-ups keep the lines high against ours
+// pulled down. Only probes the lines while the port is idle; a busy port
+// counts as connected.
+bool ps2_bus_probe_host(ps2_port_t *port);
+
+#endif // PS2_BUS_H
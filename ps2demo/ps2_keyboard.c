@@ -1,111 +1,100 @@
 // ps2_keyboard.c - FIXED VERSION with better media key debugging
 #include "ps2_keyboard.h"
+#include "ps2_bus.h"
+#include "ps2_mouse.h"
+#include "ps2_queue.h"
+#include "ps2_trace.h"
+#include "ps2_stats.h"
 #include "quantum.h"  // QMK main header with GPIO functions
 
 #include "report.h"  // For report_keyboard_t, etc.
-
-// Timing (in microseconds)
-#define PS2_CLK_HALF_PERIOD 50  // 50us = 10kHz clock (was 40us = 12.5kHz)
-#define PS2_INTER_BYTE_DELAY 2  // 2ms delay between bytes
-
-// Previous keyboard report to detect key changes device
-static report_keyboard_t previous_report = {0};
-
-// Configuration
-static uint8_t ps2_clk_pin;
-static uint8_t ps2_data_pin;
+#include <string.h>
+
+// Host errors (resend requests, framing errors) tolerated before stepping
+// down a profile, and clean bytes that clear the error count again
+#define PS2_TIMING_ERROR_LIMIT   3
+#define PS2_TIMING_ERROR_WINDOW  64
+
+// Clean bytes in a row that prove a profile, and clean bytes before trying
+// one profile faster again (doubled after every try that failed, up to
+// 1 << PS2_TIMING_PROBE_MAX_SHIFT times)
+#define PS2_TIMING_PROVEN_BYTES    1024
+#define PS2_TIMING_PROBE_BYTES     4096
+#define PS2_TIMING_PROBE_MAX_SHIFT 6
+
+static ps2_timing_profile_id_t ps2_timing_id = PS2_TIMING_SPEC_FAST;
+static ps2_timing_profile_id_t ps2_timing_saved = PS2_TIMING_SPEC_FAST;  // In EEPROM
+static uint8_t ps2_timing_errors = 0;
+static uint32_t ps2_timing_clean_bytes = 0;  // Since the last host error
+static uint8_t ps2_timing_probe_shift = 0;   // Failed tries one profile faster
+static bool ps2_timing_probing = false;      // Stepped up, not proven yet
+
+// The keyboard's bus: pins, send queue and wire engine
+ps2_port_t ps2_keyboard_port = {.timed = true};
 
 // State variables
-static ps2_state_t ps2_state = PS2_STATE_IDLE;
 static bool ps2_enabled = true;
+static bool ps2_host_present = true;  // Host detection saw a host on the port
 static ps2_led_state_t ps2_leds = {0};
+static ps2_scancode_set_t ps2_scancode_set = PS2_SCANCODE_SET_2;
 
-// Special key send functions
-bool ps2_keyboard_send_printscreen_make(void);
-bool ps2_keyboard_send_printscreen_break(void);
-bool ps2_keyboard_send_pause(void);  // Pause only sends on make, no break!
-bool ps2_keyboard_send_raw_byte(uint8_t byte);
+// Keys only go out to a host that is there and hasn't disabled us (0xF5).
+// Changes meanwhile stay in the host key model until resync.
+static inline bool ps2_keys_flow(void) {
+    return ps2_enabled && ps2_host_present;
+}
 
-// Send buffer
-#define PS2_SEND_BUFFER_SIZE 32
-static uint8_t send_buffer[PS2_SEND_BUFFER_SIZE];
-static uint8_t send_buffer_head = 0;
-static uint8_t send_buffer_tail = 0;
+// Set 3 per-key attributes (0xF7-0xFD), indexed by Set 3 make code
+#define PS2_SET3_TYPEMATIC  0x01
+#define PS2_SET3_BREAK      0x02
+#define PS2_SET3_DEFAULT    (PS2_SET3_TYPEMATIC | PS2_SET3_BREAK)
+static uint8_t ps2_set3_attributes[256];
 
-// Previous media key to handle repeats
-static uint16_t previous_media_key = 0;
+// Sequence send functions (whole sequence queued or nothing)
+static bool ps2_send_make(ps2_mapping_t mapping, ps2_priority_t priority, uint8_t flags, uint8_t keycode);
+static bool ps2_send_break(ps2_mapping_t mapping, uint8_t flags, uint8_t keycode);
+bool ps2_keyboard_send_raw_byte(uint8_t byte);
+static void ps2_send_deferred(void);
 
-// Convert Consumer Control usage code to PS/2 scancode
-static ps2_mapping_t consumer_to_ps2_scancode(uint16_t usage) {
-    for (size_t i = 0; i < PS2_CONSUMER_MAPPINGS_SIZE; i++) {
-        if (ps2_consumer_mappings[i].usage_code == usage) {
-            return ps2_consumer_mappings[i].mapping;
-        }
-    }
-    // Unknown consumer control code
-    uprintf("[PS2] UNMAPPED consumer control: 0x%04X\n", usage);
-    return (ps2_mapping_t){0, false, PS2_KEY_NORMAL};
-}
+// Consumer and system keys (see EXTRA KEYS below)
+static bool ps2_extra_is_key(uint8_t keycode);
+static void ps2_extra_want(void);
+static void ps2_extra_forget(void);
+static void ps2_extra_clear(void);
+static void ps2_extra_meter(void);
+
+// Host key state model (see HOST KEY STATE below)
+static void ps2_key_state_flush(void);
+static void ps2_key_state_forget(void);
+static void ps2_key_state_release_all(void);
 
 // Convert QMK keycode to PS/2 scancode
 ps2_mapping_t qmk_to_ps2_scancode(uint16_t keycode) {
-    // FIXED: Check basic keycodes in main lookup table
-    // Only use the lookup table if keycode is within bounds AND < 256
-    if (keycode < 0x100 && keycode < PS2_SCANCODE_LOOKUP_SIZE) {
-        ps2_mapping_t mapping = ps2_scancode_lookup[keycode];
-        if (mapping.scancode != 0) {
-            return mapping;
-        }
-    }
-
-    // Check extended keys (media, system, F13-F24)
-    // This handles all keycodes >= 0x100 and any unmapped basic keys
-    for (size_t i = 0; i < PS2_EXTENDED_KEYS_SIZE; i++) {
-        if (ps2_extended_keys[i].qmk_keycode == keycode) {
-            return ps2_extended_keys[i].mapping;
-        }
+    ps2_mapping_t mapping = ps2_scancode_for_keycode(ps2_scancode_set, keycode);
+    if (mapping.scancode == 0) {
+        // Unknown keycode - log it for debugging
+        PS2_TRACE_WARN(PS2_EV_UNMAPPED_KEYCODE, keycode, 0, 0);
     }
-
-    // Unknown keycode - log it for debugging
-    uprintf("[PS2] UNMAPPED keycode: 0x%04X\n", keycode);
-    return (ps2_mapping_t){0, false, PS2_KEY_NORMAL};
+    return mapping;
 }
 
-typedef struct {
-    uint8_t mod_bit;
-    uint8_t scancode;
-    bool needs_e0;
-    ps2_special_key_type_t special_type;
-} ps2_modifier_mapping_t;
-
-static const ps2_modifier_mapping_t modifier_mappings[] = {
-    {0x01, PS2_LCTRL, false, PS2_KEY_NORMAL},   // MOD_LCTL
-    {0x02, PS2_LSHIFT, false, PS2_KEY_NORMAL},  // MOD_LSFT
-    {0x04, PS2_LALT, false, PS2_KEY_NORMAL},    // MOD_LALT
-    {0x08, PS2_LGUI, true, PS2_KEY_NORMAL},     // MOD_LGUI (needs E0)
-    {0x10, PS2_RCTRL, true, PS2_KEY_NORMAL},    // MOD_RCTL (needs E0)
-    {0x20, PS2_RSHIFT, false, PS2_KEY_NORMAL},  // MOD_RSFT
-    {0x40, PS2_RALT, true, PS2_KEY_NORMAL},     // MOD_RALT (needs E0)
-    {0x80, PS2_RGUI, true, PS2_KEY_NORMAL},     // MOD_RGUI (needs E0)
-};
-
 // Typematic state (Needed because PS/2 device must handle repeats itself unlike USB)
 static struct {
     uint16_t keycode;       // Which QMK keycode is held
     bool active;            // Is typematic armed?
-    uint32_t press_time;    // When key was first pressed
-    uint32_t last_repeat;   // When we last sent a repeat
-    uint16_t delay_ms;      // Delay before repeating starts
-    uint16_t rate_ms;       // Time between repeats
+    uint32_t next_us;       // Deadline of the next repeat (ps2_micros())
+    uint32_t delay_us;      // Delay before repeating starts
+    uint32_t period_us;     // Time between repeats
     ps2_mapping_t mapping;  // Full mapping info (scancode + E0 prefix flag)
+    uint8_t setting;        // Last Set Typematic argument
 } typematic_state = {
     .keycode = 0,
     .active = false,
-    .press_time = 0,
-    .last_repeat = 0,
-    .delay_ms = 500,  // Default 500ms delay
-    .rate_ms = 33,     // Default ~30Hz repeat rate
-    .mapping = {0, false, PS2_KEY_NORMAL}
+    .next_us = 0,
+    .delay_us = 500000,    // PS2_TYPEMATIC_DEFAULT: 500ms delay
+    .period_us = 33333,    // ...and 30 repeats per second
+    .mapping = {0, false, PS2_KEY_NORMAL},
+    .setting = PS2_TYPEMATIC_DEFAULT
 };
 
 void ps2_keyboard_typematic_arm(uint16_t keycode, uint8_t scancode) {
@@ -121,8 +110,7 @@ void ps2_keyboard_typematic_arm(uint16_t keycode, uint8_t scancode) {
 
     typematic_state.keycode = keycode;
     typematic_state.active = true;
-    typematic_state.press_time = timer_read32();
-    typematic_state.last_repeat = timer_read32();
+    typematic_state.next_us = ps2_micros() + typematic_state.delay_us;
 
     // Store the complete mapping to preserve E0 prefix info
     typematic_state.mapping = qmk_to_ps2_scancode(keycode);
@@ -143,189 +131,382 @@ void ps2_keyboard_typematic_disable(void) {
     typematic_state.mapping.special_type = PS2_KEY_NORMAL;
 }
 
+// Repeat period (us) for each 5-bit rate value of the Set Typematic (0xF3)
+// byte, period = (8 + A) * 2^B / 240s with A = bits 0-2, B = bits 3-4
+static const uint32_t typematic_period_us[32] = {
+     33333,  37500,  41667,  45833,  50000,  54167,  58333,  62500,
+     66667,  75000,  83333,  91667, 100000, 108333, 116667, 125000,
+    133333, 150000, 166667, 183333, 200000, 216667, 233333, 250000,
+    266667, 300000, 333333, 366667, 400000, 433333, 466667, 500000,
+};
+
+// Apply a Set Typematic argument: bits 0-4 rate, bits 5-6 delay (250ms steps)
+static void ps2_keyboard_typematic_configure(uint8_t value) {
+    typematic_state.setting = value;
+    typematic_state.period_us = typematic_period_us[value & 0x1F];
+    typematic_state.delay_us = (((value >> 5) & 0x03) + 1) * 250000UL;
+}
+
+uint8_t ps2_keyboard_get_typematic(void) {
+    return typematic_state.setting;
+}
+
 void ps2_keyboard_typematic_task(void) {
     if (!typematic_state.active) return;
 
-    uint32_t now = timer_read32();
-    uint32_t held_time = now - typematic_state.press_time;
+    uint32_t now = ps2_micros();
+    if ((int32_t)(now - typematic_state.next_us) < 0) return;
 
-    // Has initial delay passed?
-    if (held_time >= typematic_state.delay_ms) {
-        uint32_t since_repeat = now - typematic_state.last_repeat;
+    // The next deadline counts from this one, not from when the loop got
+    // here, so a late loop doesn't stretch the period. More than a whole
+    // period late (a long stall) skips the missed repeats instead of
+    // sending them as a burst.
+    typematic_state.next_us += typematic_state.period_us;
+    if ((int32_t)(now - typematic_state.next_us) >= 0) {
+        typematic_state.next_us = now + typematic_state.period_us;
+    }
 
-        // Time for another repeat?
-        if (since_repeat >= typematic_state.rate_ms) {
-            uprintf("[PS2] Typematic repeat: keycode=0x%04X, scancode=0x%02X%s\n",
-                    typematic_state.keycode, typematic_state.mapping.scancode,
-                    typematic_state.mapping.needs_e0_prefix ? ", E0 prefix" : "");
+    // Set 3 keys can have repeat turned off
+    if (ps2_scancode_set == PS2_SCANCODE_SET_3 &&
+        !(ps2_set3_attributes[typematic_state.mapping.scancode] & PS2_SET3_TYPEMATIC)) {
+        return;
+    }
 
-            if (typematic_state.mapping.needs_e0_prefix) {
-                ps2_keyboard_send_key_make(PS2_PREFIX_E0);
-            }
-            ps2_keyboard_send_key_make(typematic_state.mapping.scancode);
-            typematic_state.last_repeat = now;
-        }
+    // One repeat waiting at a time: while the bus is backed up, more would
+    // only pile up and arrive after the key is released
+    if (ps2_queue_has_pending(&ps2_keyboard_port.queue, PS2_PRIO_REPEAT)) {
+        return;
     }
-}
 
-// Helper functions using QMK GPIO API
-static inline void ps2_clk_high(void) {
-    setPinInput(ps2_clk_pin);  // Release to pullup (high-Z with pullup)
+    PS2_TRACE_DEBUG(PS2_EV_REPEAT, typematic_state.keycode, typematic_state.mapping.scancode,
+                    typematic_state.mapping.needs_e0_prefix);
+
+    ps2_send_make(typematic_state.mapping, PS2_PRIO_REPEAT, 0, KC_NO);
 }
 
-static inline void ps2_clk_low(void) {
-    writePinLow(ps2_clk_pin);
-    setPinOutput(ps2_clk_pin);
+// =============================================================================
+// TIMING PROFILE SELECTION
+// =============================================================================
+// A profile that carried PS2_TIMING_PROVEN_BYTES without a host error is
+// stored in the keyboard's EEPROM word, and the keyboard starts there. A
+// step down is only stored once the slower profile proved itself, and a
+// quiet host gets the next faster profile tried now and then, so one noisy
+// moment doesn't slow a host down for good.
+
+static void ps2_timing_select(ps2_timing_profile_id_t profile) {
+    ps2_timing_id = profile;
+    ps2_bus_set_timing(&ps2_keyboard_port, profile);
+    ps2_timing_errors = 0;
+    ps2_timing_clean_bytes = 0;
+    uprintf("[PS2] Timing profile: %s\n", ps2_keyboard_port.timing->name);
 }
 
-static inline void ps2_data_high(void) {
-    setPinInput(ps2_data_pin);  // Release to pullup (high-Z with pullup)
+void ps2_keyboard_set_timing_profile(ps2_timing_profile_id_t profile) {
+    if (profile >= PS2_TIMING_PROFILE_COUNT) {
+        return;
+    }
+    ps2_timing_probing = false;
+    ps2_timing_select(profile);
 }
 
-static inline void ps2_data_low(void) {
-    writePinLow(ps2_data_pin);
-    setPinOutput(ps2_data_pin);
+ps2_timing_profile_id_t ps2_keyboard_get_timing_profile(void) {
+    return ps2_timing_id;
 }
 
-static inline bool ps2_clk_read(void) {
-    return readPin(ps2_clk_pin);
+// Host asked for a resend or sent a garbled frame
+static void ps2_timing_note_error(void) {
+    ps2_timing_clean_bytes = 0;
+    if (++ps2_timing_errors < PS2_TIMING_ERROR_LIMIT) {
+        return;
+    }
+    if (ps2_timing_probing) {
+        uprintf("[PS2] Faster profile failed, going back\n");
+        ps2_timing_probing = false;
+        if (ps2_timing_probe_shift < PS2_TIMING_PROBE_MAX_SHIFT) {
+            ps2_timing_probe_shift++;
+        }
+        ps2_timing_select(ps2_timing_id + 1);
+    } else if (ps2_timing_id + 1 < PS2_TIMING_PROFILE_COUNT) {
+        uprintf("[PS2] Too many host errors, slowing down\n");
+        ps2_timing_select(ps2_timing_id + 1);
+    }
+    ps2_timing_errors = 0;
 }
 
-static inline bool ps2_data_read(void) {
-    return readPin(ps2_data_pin);
+// Bytes went out without complaint
+static void ps2_timing_note_sent(uint8_t count) {
+    if (count == 0) {
+        return;
+    }
+    ps2_timing_clean_bytes += count;
+    if (ps2_timing_clean_bytes >= PS2_TIMING_ERROR_WINDOW) {
+        ps2_timing_errors = 0;
+    }
+
+    if (ps2_timing_clean_bytes >= PS2_TIMING_PROVEN_BYTES) {
+        ps2_timing_probing = false;
+        if (ps2_timing_saved != ps2_timing_id) {
+            ps2_timing_saved = ps2_timing_id;
+            eeconfig_update_kb(ps2_timing_id);
+            uprintf("[PS2] Timing profile %s saved\n", ps2_keyboard_port.timing->name);
+        }
+    }
+
+    if (ps2_timing_id > 0 && ps2_timing_clean_bytes >= ((uint32_t)PS2_TIMING_PROBE_BYTES << ps2_timing_probe_shift)) {
+        uprintf("[PS2] Host quiet, trying a faster profile\n");
+        ps2_timing_probing = true;
+        ps2_timing_select(ps2_timing_id - 1);
+    }
 }
 
-static bool ps2_send_byte(uint8_t data) {
-    uint8_t parity = 1;
+// A new host, or one that reset, gets the full chance at faster profiles
+static void ps2_timing_host_changed(void) {
+    ps2_timing_probe_shift = 0;
+}
 
-    // Ensure idle state before starting
-    ps2_data_high();
-    ps2_clk_high();
-    wait_us(100);  // Wait for idle
+// =============================================================================
+// SCANCODE SET SELECTION
+// =============================================================================
+// Set 2 is the power-on default; Reset and Set Defaults return to it.
 
-    // Start bit (data low, then clock pulse)
-    ps2_data_low();
-    wait_us(PS2_CLK_HALF_PERIOD * 2);  // Data setup time
+ps2_scancode_set_t ps2_keyboard_get_scancode_set(void) {
+    return ps2_scancode_set;
+}
 
-    ps2_clk_low();
-    wait_us(PS2_CLK_HALF_PERIOD * 2);  // Clock low period
-    ps2_clk_high();
-    wait_us(PS2_CLK_HALF_PERIOD * 2);  // Clock high period
+void ps2_keyboard_set_scancode_set(ps2_scancode_set_t set) {
+    if (set < PS2_SCANCODE_SET_1 || set > PS2_SCANCODE_SET_3) {
+        return;
+    }
+    if (set != ps2_scancode_set) {
+        uprintf("[PS2] Switching to scancode set %d\n", set);
+    }
+    ps2_scancode_set = set;
 
-    // Data bits (LSB first)
-    for (int i = 0; i < 8; i++) {
-        // Set data line FIRST
-        if (data & (1 << i)) {
-            ps2_data_high();
-            parity ^= 1;
-        } else {
-            ps2_data_low();
-        }
-        wait_us(PS2_CLK_HALF_PERIOD * 2);  // Data setup time
+    // A held key's mapping belongs to the old set
+    typematic_state.active = false;
+}
 
-        // Then toggle clock
-        ps2_clk_low();
-        wait_us(PS2_CLK_HALF_PERIOD * 2);
-        ps2_clk_high();
-        wait_us(PS2_CLK_HALF_PERIOD * 2);
+// Command responses (ACK, ID, BAT...) go out ahead of queued scancodes so
+// they land inside the host's 20ms response window
+static bool ps2_send_response(uint8_t byte) {
+    ps2_packet_t packet = {.len = 1, .priority = PS2_PRIO_RESPONSE, .bytes = {byte}};
+    if (!ps2_queue_push(&ps2_keyboard_port.queue, &packet)) {
+        PS2_TRACE_WARN(PS2_EV_RESPONSE_DROPPED, 0, 0, byte);
+        ps2_stats_count(PS2_COUNT_RESPONSE_DROPPED);
+        return false;
     }
+    return true;
+}
 
-    // Parity bit (odd parity)
-    if (parity) {
-        ps2_data_high();
-    } else {
-        ps2_data_low();
+// Commands that take an argument byte park here until it arrives
+static uint8_t ps2_pending_command = 0;
+
+// Set 3 attribute a 0xF7-0xFD command assigns
+static uint8_t ps2_set3_attribute_for(uint8_t cmd) {
+    switch (cmd) {
+        case PS2_CMD_SET_ALL_TYPEMATIC:
+        case PS2_CMD_SET_KEY_TYPEMATIC:
+            return PS2_SET3_TYPEMATIC;
+        case PS2_CMD_SET_ALL_MAKE_BREAK:
+        case PS2_CMD_SET_KEY_MAKE_BREAK:
+            return PS2_SET3_BREAK;
+        case PS2_CMD_SET_ALL_MAKE:
+        case PS2_CMD_SET_KEY_MAKE:
+            return 0;
+        default:
+            return PS2_SET3_DEFAULT;
     }
-    wait_us(PS2_CLK_HALF_PERIOD * 2);  // Data setup time
+}
+
+static void ps2_set3_set_all(uint8_t attributes) {
+    memset(ps2_set3_attributes, attributes, sizeof(ps2_set3_attributes));
+}
+
+static void ps2_handle_command(uint8_t cmd);
 
-    ps2_clk_low();
-    wait_us(PS2_CLK_HALF_PERIOD * 2);
-    ps2_clk_high();
-    wait_us(PS2_CLK_HALF_PERIOD * 2);
+static void ps2_handle_argument(uint8_t cmd, uint8_t arg) {
+    switch (cmd) {
+        // LED bits: 0 = Scroll Lock, 1 = Num Lock, 2 = Caps Lock
+        case PS2_CMD_SET_LEDS:
+            ps2_leds.scroll_lock = (arg >> 0) & 1;
+            ps2_leds.num_lock = (arg >> 1) & 1;
+            ps2_leds.caps_lock = (arg >> 2) & 1;
+            ps2_send_response(PS2_ACK);
+            PS2_TRACE_INFO(PS2_EV_LEDS, 0, 0, arg);
+            break;
 
-    // Stop bit - data MUST be high
-    ps2_data_high();
-    wait_us(PS2_CLK_HALF_PERIOD * 2);
+        // Bit 7 must be clear, the rest encodes rate and delay
+        case PS2_CMD_SET_TYPEMATIC:
+            if (arg & 0x80) {
+                ps2_send_response(PS2_RESEND);
+                ps2_pending_command = cmd;
+                return;
+            }
+            ps2_keyboard_typematic_configure(arg);
+            ps2_send_response(PS2_ACK);
+            PS2_TRACE_INFO(PS2_EV_TYPEMATIC_SET, 0, 0, arg);
+            break;
 
-    ps2_clk_low();
-    wait_us(PS2_CLK_HALF_PERIOD * 2);
-    ps2_clk_high();
-    wait_us(PS2_CLK_HALF_PERIOD * 2);
+        // 0 queries the current set, 1-3 select one
+        case PS2_CMD_SET_SCANCODE_SET:
+            if (arg > 3) {
+                ps2_send_response(PS2_RESEND);
+                ps2_pending_command = cmd;
+                return;
+            }
+            ps2_send_response(PS2_ACK);
+            if (arg == 0) {
+                ps2_send_response(ps2_scancode_set);
+            } else {
+                ps2_keyboard_set_scancode_set(arg);
+            }
+            break;
 
-    // CRITICAL: Long inter-byte delay
-    // Both clock and data must be high (idle) for sufficient time
-    ps2_data_high();
-    ps2_clk_high();
-    wait_us(300);  // Much longer inter-byte delay (minimum 300us)
+        // One Set 3 key per byte; the list runs until the next command byte
+        case PS2_CMD_SET_KEY_TYPEMATIC:
+        case PS2_CMD_SET_KEY_MAKE_BREAK:
+        case PS2_CMD_SET_KEY_MAKE:
+            ps2_set3_attributes[arg] = ps2_set3_attribute_for(cmd);
+            ps2_send_response(PS2_ACK);
+            ps2_pending_command = cmd;
+            break;
 
-    return true;
+        default:
+            break;
+    }
 }
 
 static void ps2_handle_command(uint8_t cmd) {
+    // Argument byte for a previous command. A command byte (0xED and up) in
+    // its place aborts the pending command and is handled on its own.
+    if (ps2_pending_command != 0) {
+        uint8_t pending = ps2_pending_command;
+        ps2_pending_command = 0;
+        if (cmd < PS2_CMD_SET_LEDS) {
+            ps2_handle_argument(pending, cmd);
+            return;
+        }
+    }
+
     switch (cmd) {
+        // Wait for the LED data byte
         case PS2_CMD_SET_LEDS:
-            // Wait for LED data byte (will be implemented when needed)
+            ps2_send_response(PS2_ACK);
+            ps2_pending_command = cmd;
             break;
 
         // Echo back
         case PS2_CMD_ECHO:
-            ps2_send_byte(PS2_ECHO_RESPONSE);
+            ps2_send_response(PS2_ECHO_RESPONSE);
             break;
 
-        // For now, we only support Set 2
+        // Wait for the set number (or 0 to query)
         case PS2_CMD_SET_SCANCODE_SET:
-            ps2_send_byte(PS2_ACK);
+            ps2_send_response(PS2_ACK);
+            ps2_pending_command = cmd;
+            break;
+
+        // Wait for the rate/delay byte
+        case PS2_CMD_SET_TYPEMATIC:
+            ps2_send_response(PS2_ACK);
+            ps2_pending_command = cmd;
             break;
 
         // Respond with keyboard ID (AB 83)
         case PS2_CMD_IDENTIFY:
-            ps2_send_byte(PS2_ACK);
-            wait_ms(PS2_INTER_BYTE_DELAY);
-            ps2_send_byte(0xAB);
-            wait_ms(PS2_INTER_BYTE_DELAY);
-            ps2_send_byte(0x83);
+            ps2_send_response(PS2_ACK);
+            ps2_send_response(0xAB);
+            ps2_send_response(0x83);
             break;
 
-        // Enable/Disable commands
+        // Enable: clears the output buffer, then the host gets whatever
+        // key changes it missed while we were disabled
         case PS2_CMD_ENABLE:
+            ps2_key_state_flush();
             ps2_enabled = true;
-            ps2_send_byte(PS2_ACK);
+            ps2_send_response(PS2_ACK);
+            ps2_keyboard_resync();
             break;
 
-        // Disables keyboard sending
+        // Disables keyboard sending. Key changes from now on are held back
+        // by the host key state model until the next Enable.
         case PS2_CMD_DISABLE:
+            ps2_key_state_flush();
             ps2_enabled = false;
-            ps2_send_byte(PS2_ACK);
+            typematic_state.active = false;
+            ps2_send_response(PS2_ACK);
+            break;
+
+        // Set 3 attributes for every key
+        case PS2_CMD_SET_ALL_TYPEMATIC:
+        case PS2_CMD_SET_ALL_MAKE_BREAK:
+        case PS2_CMD_SET_ALL_MAKE:
+        case PS2_CMD_SET_ALL_DEFAULT:
+            ps2_set3_set_all(ps2_set3_attribute_for(cmd));
+            ps2_send_response(PS2_ACK);
             break;
 
-        // Set Defaults command
+        // Set 3 attributes for the keys that follow
+        case PS2_CMD_SET_KEY_TYPEMATIC:
+        case PS2_CMD_SET_KEY_MAKE_BREAK:
+        case PS2_CMD_SET_KEY_MAKE:
+            ps2_send_response(PS2_ACK);
+            ps2_pending_command = cmd;
+            break;
+
+        // Set Defaults command: typematic, key attributes and Set 2
         case PS2_CMD_SET_DEFAULTS:
-            ps2_send_byte(PS2_ACK);
+            ps2_keyboard_typematic_configure(PS2_TYPEMATIC_DEFAULT);
+            ps2_set3_set_all(PS2_SET3_DEFAULT);
+            ps2_keyboard_set_scancode_set(PS2_SCANCODE_SET_2);
+            ps2_send_response(PS2_ACK);
+            break;
+
+        // Host missed our last byte: count it against the timing profile
+        // and send the byte again, ahead of the rest of its sequence
+        case PS2_CMD_RESEND:
+            ps2_stats_count(PS2_COUNT_HOST_RESEND);
+            ps2_timing_note_error();
+            if (!ps2_bus_resend(&ps2_keyboard_port, false)) {
+                PS2_TRACE_WARN(PS2_EV_RESPONSE_DROPPED, 0, 0, ps2_keyboard_port.tx_last_byte);
+                ps2_stats_count(PS2_COUNT_RESPONSE_DROPPED);
+            }
             break;
 
-        // Reset command
+        // Reset command. The host forgets every held key, so after BAT
+        // the keys still down are pressed again.
         case PS2_CMD_RESET:
-            ps2_send_byte(PS2_ACK);
-            wait_ms(PS2_INTER_BYTE_DELAY);
-            ps2_send_byte(PS2_BAT_SUCCESS);
+            ps2_key_state_flush();
+            ps2_key_state_forget();
+            ps2_timing_host_changed();
+            ps2_enabled = true;
+            ps2_keyboard_typematic_configure(PS2_TYPEMATIC_DEFAULT);
+            ps2_set3_set_all(PS2_SET3_DEFAULT);
+            ps2_keyboard_set_scancode_set(PS2_SCANCODE_SET_2);
+            ps2_leds = (ps2_led_state_t){0};
+            ps2_send_response(PS2_ACK);
+            ps2_send_response(PS2_BAT_SUCCESS);
+            ps2_keyboard_resync();
             break;
 
         default:
-            ps2_send_byte(PS2_RESEND);
+            ps2_send_response(PS2_RESEND);
             break;
     }
 }
 
 void ps2_keyboard_init(uint8_t clk_pin, uint8_t data_pin) {
-    ps2_clk_pin = clk_pin;
-    ps2_data_pin = data_pin;
-
-    // Set pins as inputs with pullups
-    setPinInputHigh(ps2_clk_pin);
-    setPinInputHigh(ps2_data_pin);
+    // Roll the host model back over whatever was still queued before the
+    // port drops it
+    ps2_key_state_flush();
+    ps2_bus_init(&ps2_keyboard_port, clk_pin, data_pin);
 
     ps2_enabled = true;
-    ps2_state = PS2_STATE_IDLE;
+    ps2_timing_saved = eeconfig_read_kb() % PS2_TIMING_PROFILE_COUNT;
+    ps2_keyboard_set_timing_profile(ps2_timing_saved);
+    ps2_pending_command = 0;
+    ps2_scancode_set = PS2_SCANCODE_SET_2;
+    ps2_set3_set_all(PS2_SET3_DEFAULT);
 
     // Initialize LED state
     ps2_leds.caps_lock = 0;
@@ -333,109 +514,266 @@ void ps2_keyboard_init(uint8_t clk_pin, uint8_t data_pin) {
     ps2_leds.scroll_lock = 0;
 
     uprintf("[PS2] Device initialized on CLK=%d, DATA=%d\n", clk_pin, data_pin);
+
+    // Start from nothing held; a host that still holds keys from before a
+    // re-init gets them released
+    ps2_key_state_release_all();
+    ps2_keyboard_resync();
 }
 
-bool ps2_keyboard_send_printscreen_make(void) {
-    // PrintScreen make: E0 12 E0 7C
-    ps2_keyboard_send_raw_byte(PS2_PREFIX_E0);
-    ps2_keyboard_send_raw_byte(0x12);
-    ps2_keyboard_send_raw_byte(PS2_PREFIX_E0);
-    ps2_keyboard_send_raw_byte(PS2_PSCREEN);
-    return true;
+void ps2_keyboard_set_host_present(bool present) {
+    if (present == ps2_host_present) return;
+    ps2_host_present = present;
+
+    if (present) {
+        // As a keyboard that was just plugged in: self-test passed, then
+        // whatever QMK holds right now
+        uprintf("[PS2] Keyboard host connected\n");
+        ps2_key_state_forget();
+        ps2_timing_host_changed();
+        ps2_send_response(PS2_BAT_SUCCESS);
+        ps2_keyboard_resync();
+    } else {
+        // Nobody to send to: drop the backlog, stop repeating, and assume
+        // the next host holds nothing
+        uprintf("[PS2] Keyboard host gone\n");
+        ps2_key_state_flush();
+        ps2_key_state_forget();
+        ps2_keyboard_typematic_disable();
+    }
 }
 
-bool ps2_keyboard_send_printscreen_break(void) {
-    // PrintScreen break: E0 F0 7C E0 F0 12
-    ps2_keyboard_send_raw_byte(PS2_PREFIX_E0);
-    ps2_keyboard_send_raw_byte(PS2_PREFIX_F0);
-    ps2_keyboard_send_raw_byte(PS2_PSCREEN);
-    ps2_keyboard_send_raw_byte(PS2_PREFIX_E0);
-    ps2_keyboard_send_raw_byte(PS2_PREFIX_F0);
-    ps2_keyboard_send_raw_byte(0x12);
-    return true;
+// Hand a byte received from the host to the command handler
+static void ps2_rx_dispatch(uint16_t mailbox) {
+    if (mailbox & PS2_RX_MAILBOX_ERROR) {
+        PS2_TRACE_WARN(PS2_EV_HOST_FRAME_ERROR, 0, 0, 0);
+        ps2_stats_count(PS2_COUNT_FRAME_ERROR);
+        ps2_timing_note_error();
+        ps2_send_response(PS2_RESEND);
+        return;
+    }
+
+    PS2_TRACE_INFO(PS2_EV_HOST_COMMAND, 0, 0, mailbox & 0xFF);
+    ps2_handle_command(mailbox & 0xFF);
 }
 
-bool ps2_keyboard_send_pause(void) {
-    // Pause make: E1 14 77 E1 F0 14 F0 77
-    // Pause has NO break code - only sends on make!
-    ps2_keyboard_send_raw_byte(PS2_PREFIX_E1);
-    ps2_keyboard_send_raw_byte(0x14);
-    ps2_keyboard_send_raw_byte(PS2_PAUSE);
-    ps2_keyboard_send_raw_byte(PS2_PREFIX_E1);
-    ps2_keyboard_send_raw_byte(PS2_PREFIX_F0);
-    ps2_keyboard_send_raw_byte(0x14);
-    ps2_keyboard_send_raw_byte(PS2_PREFIX_F0);
-    ps2_keyboard_send_raw_byte(PS2_PAUSE);
-    return true;
+// Keep the bus moving: notice host requests, hand over received commands
+// and restart the engine if it went idle with work queued
+static void ps2_keyboard_service(void) {
+    ps2_bus_service(&ps2_keyboard_port, ps2_rx_dispatch);
 }
 
-static bool ps2_buffer_has_space(uint8_t needed) {
-    uint8_t used;
-    if (send_buffer_head >= send_buffer_tail) {
-        used = send_buffer_head - send_buffer_tail;
-    } else {
-        used = PS2_SEND_BUFFER_SIZE - (send_buffer_tail - send_buffer_head);
+uint8_t ps2_keyboard_task(void) {
+    // A repeat that is due gets queued first so the kick below starts it now
+    ps2_keyboard_typematic_task();
+
+    // Never blocks: the timer moves bytes on and off the wire
+    ps2_keyboard_service();
+
+    // Then keys that waited for queue space
+    ps2_send_deferred();
+
+    // Then the next consumer/system key event, if the queue has drained
+    ps2_extra_meter();
+
+    // Console output only while neither bus has anything to do
+    if (ps2_bus_is_idle(&ps2_keyboard_port) && ps2_mouse_is_idle()) {
+        ps2_trace_drain(PS2_TRACE_DRAIN_BATCH);
     }
-    return (PS2_SEND_BUFFER_SIZE - used) >= needed;
+
+    // Report how many bytes went out since the last call
+    uint8_t sent = ps2_bus_take_sent(&ps2_keyboard_port);
+    ps2_timing_note_sent(sent);
+    return sent;
 }
 
-void ps2_keyboard_task(void) {
-    if (send_buffer_head != send_buffer_tail) {
-        uint8_t byte = send_buffer[send_buffer_tail];
-        if (ps2_send_byte(byte)) {
-            send_buffer_tail = (send_buffer_tail + 1) % PS2_SEND_BUFFER_SIZE;
-        }
-    }
+static inline void ps2_packet_add(ps2_packet_t *packet, uint8_t byte) {
+    packet->bytes[packet->len++] = byte;
+}
 
-    ps2_keyboard_typematic_task();
+static inline uint16_t ps2_mapping_key(ps2_mapping_t mapping) {
+    return mapping.scancode | (mapping.needs_e0_prefix ? 0x100 : 0);
 }
 
-bool ps2_keyboard_send_raw_byte(uint8_t byte) {
-    uint8_t next_head = (send_buffer_head + 1) % PS2_SEND_BUFFER_SIZE;
-    if (next_head == send_buffer_tail) {
-        uprintf("[PS2] WARNING: Send buffer full! Dropping byte 0x%02X\n", byte);
+// Slots key events leave free so command responses (up to ACK + BAT for a
+// Reset) always fit
+#define PS2_QUEUE_RESPONSE_RESERVE 2
+
+static inline bool ps2_queue_has_room(void) {
+    return ps2_queue_free(&ps2_keyboard_port.queue) > PS2_QUEUE_RESPONSE_RESERVE;
+}
+
+// Keystroke start for packets queued while a report is being handled
+static uint32_t ps2_report_origin = 0;
+
+// Queue a whole sequence. Key events only take a slot while the response
+// reserve stays free; when they don't fit the caller keeps them (see
+// ps2_key_state_send), anything else is lost.
+static bool ps2_queue_sequence(ps2_packet_t *packet) {
+    ps2_stats_counter_t dropped = packet->priority == PS2_PRIO_REPEAT ? PS2_COUNT_REPEAT_DROPPED : PS2_COUNT_KEY_DROPPED;
+
+#if PS2_STATS_ENABLE
+    packet->origin_us = ps2_report_origin;
+#endif
+
+    bool room = packet->priority == PS2_PRIO_REPEAT || ps2_queue_has_room();
+    if (room && ps2_queue_push(&ps2_keyboard_port.queue, packet)) {
+        return true;
+    }
+    if (!room && packet->keycode != KC_NO) {
         return false;
     }
 
-    send_buffer[send_buffer_head] = byte;
-    send_buffer_head = next_head;
-
-    return true;
+    PS2_TRACE_WARN(PS2_EV_QUEUE_FULL, packet->priority, 0, packet->bytes[packet->len - 1]);
+    ps2_stats_count(dropped);
+    return false;
 }
 
-bool ps2_keyboard_send_key_make(uint8_t scancode) {
-    if (!ps2_enabled) return false;
+// =============================================================================
+// SCANCODE SET ENCODERS
+// =============================================================================
+// Each appends the make or break sequence for mapping (a mapping in its own
+// set) to packet. They return false when the key sends nothing, e.g. Pause
+// on release or a Set 3 make-only key.
+
+// Set 1: break = make | 0x80
+static bool ps2_encode_set1(ps2_packet_t *packet, ps2_mapping_t mapping, bool make) {
+    switch (mapping.special_type) {
+        case PS2_KEY_PRINTSCREEN:
+            // PrintScreen: E0 2A E0 37, break E0 B7 E0 AA
+            ps2_packet_add(packet, PS2_PREFIX_E0);
+            ps2_packet_add(packet, make ? 0x2A : 0xB7);
+            ps2_packet_add(packet, PS2_PREFIX_E0);
+            ps2_packet_add(packet, make ? 0x37 : 0xAA);
+            return true;
+
+        case PS2_KEY_PAUSE:
+            // Pause make: E1 1D 45 E1 9D C5, no break
+            if (!make) return false;
+            ps2_packet_add(packet, PS2_PREFIX_E1);
+            ps2_packet_add(packet, 0x1D);
+            ps2_packet_add(packet, 0x45);
+            ps2_packet_add(packet, PS2_PREFIX_E1);
+            ps2_packet_add(packet, 0x9D);
+            ps2_packet_add(packet, 0xC5);
+            return true;
 
-    uint8_t next_head = (send_buffer_head + 1) % PS2_SEND_BUFFER_SIZE;
-    if (next_head == send_buffer_tail) {
-        // Buffer full - this shouldn't happen in normal use!
-        uprintf("[PS2] WARNING: Send buffer full! Dropping scancode 0x%02X\n", scancode);
-        return false; // Buffer full
+        default:
+            if (!make && mapping.special_type == PS2_KEY_MAKE_ONLY) return false;
+            if (mapping.needs_e0_prefix) {
+                ps2_packet_add(packet, PS2_PREFIX_E0);
+            }
+            ps2_packet_add(packet, make ? mapping.scancode : mapping.scancode | 0x80);
+            return true;
     }
+}
+
+// Set 2: break = F0 + make, after any E0 prefix
+static bool ps2_encode_set2(ps2_packet_t *packet, ps2_mapping_t mapping, bool make) {
+    switch (mapping.special_type) {
+        case PS2_KEY_PRINTSCREEN:
+            if (make) {
+                // PrintScreen make: E0 12 E0 7C
+                ps2_packet_add(packet, PS2_PREFIX_E0);
+                ps2_packet_add(packet, 0x12);
+                ps2_packet_add(packet, PS2_PREFIX_E0);
+                ps2_packet_add(packet, PS2_PSCREEN);
+            } else {
+                // PrintScreen break: E0 F0 7C E0 F0 12
+                ps2_packet_add(packet, PS2_PREFIX_E0);
+                ps2_packet_add(packet, PS2_PREFIX_F0);
+                ps2_packet_add(packet, PS2_PSCREEN);
+                ps2_packet_add(packet, PS2_PREFIX_E0);
+                ps2_packet_add(packet, PS2_PREFIX_F0);
+                ps2_packet_add(packet, 0x12);
+            }
+            return true;
+
+        case PS2_KEY_PAUSE:
+            // Pause has NO break code - only sends on make!
+            if (!make) return false;
+            // Pause make: E1 14 77 E1 F0 14 F0 77
+            ps2_packet_add(packet, PS2_PREFIX_E1);
+            ps2_packet_add(packet, 0x14);
+            ps2_packet_add(packet, PS2_PAUSE);
+            ps2_packet_add(packet, PS2_PREFIX_E1);
+            ps2_packet_add(packet, PS2_PREFIX_F0);
+            ps2_packet_add(packet, 0x14);
+            ps2_packet_add(packet, PS2_PREFIX_F0);
+            ps2_packet_add(packet, PS2_PAUSE);
+            return true;
 
-    send_buffer[send_buffer_head] = scancode;
-    send_buffer_head = next_head;
+        default:
+            if (!make && mapping.special_type == PS2_KEY_MAKE_ONLY) return false;
+            if (mapping.needs_e0_prefix) {
+                ps2_packet_add(packet, PS2_PREFIX_E0);
+            }
+            if (!make) {
+                ps2_packet_add(packet, PS2_PREFIX_F0);
+            }
+            ps2_packet_add(packet, mapping.scancode);
+            return true;
+    }
+}
 
+// Set 3: one byte per make, F0 + code per break, never a prefix. Keys the
+// host made make-only send no break at all.
+static bool ps2_encode_set3(ps2_packet_t *packet, ps2_mapping_t mapping, bool make) {
+    if (!make) {
+        if (!(ps2_set3_attributes[mapping.scancode] & PS2_SET3_BREAK)) return false;
+        ps2_packet_add(packet, PS2_PREFIX_F0);
+    }
+    ps2_packet_add(packet, mapping.scancode);
     return true;
 }
 
-bool ps2_keyboard_send_key_break(uint8_t scancode) {
-    if (!ps2_enabled) return false;
+static bool ps2_encode(ps2_packet_t *packet, ps2_mapping_t mapping, bool make) {
+    if (mapping.scancode == 0) return false;
 
-    // Send break prefix (0xF0) then scancode
-    uint8_t next_head = (send_buffer_head + 1) % PS2_SEND_BUFFER_SIZE;
-    if (next_head == send_buffer_tail) return false;
+    switch (ps2_scancode_set) {
+        case PS2_SCANCODE_SET_1:
+            return ps2_encode_set1(packet, mapping, make);
+        case PS2_SCANCODE_SET_3:
+            return ps2_encode_set3(packet, mapping, make);
+        default:
+            return ps2_encode_set2(packet, mapping, make);
+    }
+}
 
-    send_buffer[send_buffer_head] = PS2_PREFIX_F0;
-    send_buffer_head = next_head;
+// Queue the complete make sequence for a key. keycode tags the packet for
+// the host key state model (KC_NO for untracked sends such as repeats).
+static bool ps2_send_make(ps2_mapping_t mapping, ps2_priority_t priority, uint8_t flags, uint8_t keycode) {
+    if (!ps2_keys_flow()) return false;
 
-    next_head = (send_buffer_head + 1) % PS2_SEND_BUFFER_SIZE;
-    if (next_head == send_buffer_tail) return false;
+    ps2_packet_t packet = {.priority = priority, .flags = flags, .keycode = keycode, .key = ps2_mapping_key(mapping)};
+    if (!ps2_encode(&packet, mapping, true)) {
+        return true;
+    }
+    return ps2_queue_sequence(&packet);
+}
 
-    send_buffer[send_buffer_head] = scancode;
-    send_buffer_head = next_head;
+// Queue the complete break sequence for a key
+static bool ps2_send_break(ps2_mapping_t mapping, uint8_t flags, uint8_t keycode) {
+    if (!ps2_keys_flow()) return false;
 
-    return true;
+    ps2_packet_t packet = {.priority = PS2_PRIO_BREAK, .flags = flags | PS2_PACKET_RELEASE, .keycode = keycode, .key = ps2_mapping_key(mapping)};
+    if (!ps2_encode(&packet, mapping, false)) {
+        return true;
+    }
+    return ps2_queue_sequence(&packet);
+}
+
+bool ps2_keyboard_send_raw_byte(uint8_t byte) {
+    ps2_packet_t packet = {.len = 1, .priority = PS2_PRIO_MAKE, .bytes = {byte}};
+    return ps2_queue_sequence(&packet);
+}
+
+bool ps2_keyboard_send_key_make(uint8_t scancode) {
+    return ps2_send_make((ps2_mapping_t){scancode, false, PS2_KEY_NORMAL}, PS2_PRIO_MAKE, 0, KC_NO);
+}
+
+bool ps2_keyboard_send_key_break(uint8_t scancode) {
+    return ps2_send_break((ps2_mapping_t){scancode, false, PS2_KEY_NORMAL}, 0, KC_NO);
 }
 
 ps2_led_state_t ps2_keyboard_get_leds(void) {
@@ -451,189 +789,445 @@ static uint8_t ps2_keyboard_leds(void) {
     return (leds.caps_lock << 1) | (leds.num_lock) | (leds.scroll_lock << 2);
 }
 
-static void ps2_send_keyboard(report_keyboard_t *report) {
-    if (report->keys[0] != 0 || report->keys[1] != 0) {
-        uprintf("[PS2] Report contains keys: ");
-        for (int i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
-            if (report->keys[i] != 0) {
-                uprintf("0x%02X ", report->keys[i]);
-            }
-        }
-        uprintf("\n");
-    }
-
-    // Handle modifier changes
-    uint8_t mod_changes = previous_report.mods ^ report->mods;
-
-    if (mod_changes) {
-        for (uint8_t i = 0; i < 8; i++) {
-            const ps2_modifier_mapping_t *mapping = &modifier_mappings[i];
-
-            if (mod_changes & mapping->mod_bit) {
-                bool is_pressed = report->mods & mapping->mod_bit;
-
-                if (is_pressed) {
-                    uprintf("[PS2] Modifier pressed: 0x%02X (scancode: 0x%02X%s)\n",
-                            mapping->mod_bit, mapping->scancode,
-                            mapping->needs_e0 ? ", E0 prefix" : "");
-                    if (mapping->needs_e0) {
-                        ps2_keyboard_send_key_make(PS2_PREFIX_E0);
-                    }
-                    ps2_keyboard_send_key_make(mapping->scancode);
-                // ... inside ps2_send_keyboard ...
-                } else {
-                    uprintf("[PS2] Modifier released: 0x%02X (scancode: 0x%02X%s)\n",
-                            mapping->mod_bit, mapping->scancode,
-                            mapping->needs_e0 ? ", E0 prefix" : "");
-
-                    // Corrected Release Sequence for Extended Modifiers
-                    if (mapping->needs_e0) {
-                        ps2_keyboard_send_raw_byte(PS2_PREFIX_E0);
-                    }
-                    ps2_keyboard_send_key_break(mapping->scancode);
-                }
-            }
-        }
+// =============================================================================
+// HOST KEY STATE
+// =============================================================================
+// ps2_keys_host models exactly what the host thinks is held: one bit per QMK
+// keycode whose make was queued with no break after it. ps2_keys_wanted is
+// what QMK's latest reports hold. Every report only updates ps2_keys_wanted;
+// the makes and breaks that go out are the diff between the two. A change
+// that can't be queued or backlogged (bus disabled, backlog full) leaves its bit
+// different, so the next sync sends it instead of the host ending up with a
+// stuck or ghost key. Modifiers are the KC_LEFT_CTRL..KC_RIGHT_GUI bits and
+// consumer and system keys use the keycode of the same key (see EXTRA KEYS
+// below).
+
+#define PS2_KEY_WORDS 8  // 256 keycodes
+#define PS2_MODS_WORD (KC_LEFT_CTRL / 32)
+#define PS2_MODS_SHIFT (KC_LEFT_CTRL % 32)
+
+static uint32_t ps2_keys_wanted[PS2_KEY_WORDS];
+static uint32_t ps2_keys_host[PS2_KEY_WORDS];
+static uint32_t ps2_keys_flushed[PS2_KEY_WORDS];
+
+static inline bool ps2_key_bit(const uint32_t *keys, uint8_t keycode) {
+    return keys[keycode / 32] & (1UL << (keycode % 32));
+}
+
+static inline bool ps2_key_is_modifier(uint8_t keycode) {
+    return keycode >= KC_LEFT_CTRL && keycode <= KC_RIGHT_GUI;
+}
+
+static inline void ps2_key_bit_set(uint32_t *keys, uint8_t keycode, bool on) {
+    if (on) {
+        keys[keycode / 32] |= 1UL << (keycode % 32);
+    } else {
+        keys[keycode / 32] &= ~(1UL << (keycode % 32));
     }
+}
 
-    // Handle regular key releases
-    for (int i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
-        uint8_t prev_keycode = previous_report.keys[i];
-        bool still_pressed = false;
+// Queue the make or break for one key. Returns false when it doesn't fit.
+static bool ps2_key_state_queue(uint8_t keycode, ps2_mapping_t mapping, bool make) {
+    bool modifier = ps2_key_is_modifier(keycode);
 
-        if (prev_keycode == 0) continue;
+    if (!make) {
+        ps2_keyboard_typematic_stop(keycode);
+        return ps2_send_break(mapping, modifier ? PS2_PACKET_MODIFIER : 0, keycode);
+    }
 
-        for (int j = 0; j < KEYBOARD_REPORT_KEYS; j++) {
-            if (report->keys[j] == prev_keycode) {
-                still_pressed = true;
-                break;
-            }
+    // Modifier changes are never reordered against other keys
+    bool queued = modifier ? ps2_send_make(mapping, PS2_PRIO_BREAK, PS2_PACKET_MODIFIER, keycode)
+                           : ps2_send_make(mapping, PS2_PRIO_MAKE, 0, keycode);
+    // Media keys don't repeat in PS/2
+    if (queued && !ps2_extra_is_key(keycode)) {
+        ps2_keyboard_typematic_arm(keycode, mapping.scancode);
+    }
+    return queued;
+}
+
+// Key events that found the queue full wait in the backlog, oldest first,
+// and the task moves them into the queue as the engine makes room. QMK never
+// waits for the bus, and SEND_STRING and macros still reach the host intact
+// at the wire rate. Each entry is one make or break, so the default holds
+// about 1500 characters of mixed-case text; past that, keys are left in the
+// host model's diff and sent by a resync once there is room (the host ends
+// up holding the right keys, but repeated taps of one key may merge).
+#ifndef PS2_BACKLOG_SIZE
+#define PS2_BACKLOG_SIZE 4096
+#endif
+
+#if PS2_BACKLOG_SIZE < 1 || PS2_BACKLOG_SIZE > 65535
+#error "PS2_BACKLOG_SIZE must be between 1 and 65535"
+#endif
+
+#define PS2_BACKLOG_RELEASE 0x100  // Entry is a break (else a make)
+
+static uint16_t ps2_backlog[PS2_BACKLOG_SIZE];  // keycode | PS2_BACKLOG_RELEASE
+static uint16_t ps2_backlog_tail = 0;           // Oldest entry
+static uint16_t ps2_backlog_count = 0;
+
+// Keys past a full backlog are left in the diff for a resync
+static bool ps2_resync_pending = false;
+
+// Move backlogged events into the queue, oldest first, while they fit
+static void ps2_backlog_drain(void) {
+    while (ps2_backlog_count > 0) {
+        uint8_t keycode = ps2_backlog[ps2_backlog_tail] & 0xFF;
+        bool make = !(ps2_backlog[ps2_backlog_tail] & PS2_BACKLOG_RELEASE);
+        if (!ps2_key_state_queue(keycode, qmk_to_ps2_scancode(keycode), make)) {
+            return;
         }
+        ps2_backlog_tail = (ps2_backlog_tail + 1) % PS2_BACKLOG_SIZE;
+        ps2_backlog_count--;
+    }
+}
 
-        if (!still_pressed) {
-            ps2_mapping_t mapping = qmk_to_ps2_scancode(prev_keycode);
-            if (mapping.scancode != 0) {
-                if (mapping.special_type == PS2_KEY_PRINTSCREEN) {
-                    ps2_keyboard_send_printscreen_break();
-                    continue;
-                }
-
-                if (mapping.special_type == PS2_KEY_PAUSE) {
-                    continue;
-                }
-
-                uprintf("[PS2] Key released: keycode=0x%04X, scancode=0x%02X%s\n",
-                        prev_keycode, mapping.scancode,
-                        mapping.needs_e0_prefix ? ", E0 prefix" : "");
-                if (mapping.needs_e0_prefix) {
-                    ps2_keyboard_send_key_make(PS2_PREFIX_E0);
-                }
-                ps2_keyboard_send_key_break(mapping.scancode);
-                ps2_keyboard_typematic_stop(prev_keycode);
-            }
+// Send the make or break for one key and record it in the host model. Once
+// anything is backlogged, later events go behind it so the host gets them
+// in order.
+static void ps2_key_state_send(uint8_t keycode, bool make) {
+    // The extra key meter may ask for what the host already has
+    if (ps2_key_bit(ps2_keys_host, keycode) == make) return;
+    if (!ps2_keys_flow()) return;
+
+    ps2_mapping_t mapping = qmk_to_ps2_scancode(keycode);
+    PS2_TRACE_DEBUG(ps2_key_is_modifier(keycode) ? (make ? PS2_EV_MOD_PRESS : PS2_EV_MOD_RELEASE)
+                                                 : (make ? PS2_EV_KEY_PRESS : PS2_EV_KEY_RELEASE),
+                    keycode, mapping.scancode, mapping.needs_e0_prefix);
+
+    ps2_backlog_drain();
+    if (ps2_backlog_count == 0 && ps2_key_state_queue(keycode, mapping, make)) {
+        ps2_key_bit_set(ps2_keys_host, keycode, make);
+        return;
+    }
+
+    // QMK let go: no more repeats, even before the break goes out
+    if (!make) {
+        ps2_keyboard_typematic_stop(keycode);
+    }
+
+    if (ps2_backlog_count < PS2_BACKLOG_SIZE) {
+        ps2_backlog[(ps2_backlog_tail + ps2_backlog_count) % PS2_BACKLOG_SIZE] = keycode | (make ? 0 : PS2_BACKLOG_RELEASE);
+        ps2_backlog_count++;
+        ps2_key_bit_set(ps2_keys_host, keycode, make);
+        return;
+    }
+
+    // Left in the diff for the task
+    PS2_TRACE_WARN(PS2_EV_BACKLOG_FULL, keycode, 0, make);
+    ps2_stats_count(PS2_COUNT_KEY_DEFERRED);
+    ps2_resync_pending = true;
+}
+
+// Send the keys in bits (one word of the bitmap) as makes or breaks
+static void ps2_key_state_send_word(uint8_t word, uint32_t bits, bool make) {
+    while (bits) {
+        uint8_t bit = __builtin_ctz(bits);
+        bits &= bits - 1;
+        ps2_key_state_send(word * 32 + bit, make);
+    }
+}
+
+// Bring the host in line with ps2_keys_wanted: modifier changes first, then
+// releases, then presses, as one burst. Each word costs a compare; only the
+// keys that differ cost more.
+void ps2_keyboard_resync(void) {
+    if (!ps2_keys_flow()) return;
+
+    uint32_t mods_mask = 0xFFUL << PS2_MODS_SHIFT;
+    uint32_t mods_changed = (ps2_keys_wanted[PS2_MODS_WORD] ^ ps2_keys_host[PS2_MODS_WORD]) & mods_mask;
+    while (mods_changed) {
+        uint8_t bit = __builtin_ctz(mods_changed);
+        mods_changed &= mods_changed - 1;
+        uint8_t keycode = PS2_MODS_WORD * 32 + bit;
+        ps2_key_state_send(keycode, ps2_key_bit(ps2_keys_wanted, keycode));
+    }
+
+    for (uint8_t word = 0; word < PS2_KEY_WORDS; word++) {
+        uint32_t mask = word == PS2_MODS_WORD ? ~mods_mask : ~0UL;
+        ps2_key_state_send_word(word, ps2_keys_host[word] & ~ps2_keys_wanted[word] & mask, false);
+    }
+    for (uint8_t word = 0; word < PS2_KEY_WORDS; word++) {
+        uint32_t mask = word == PS2_MODS_WORD ? ~mods_mask : ~0UL;
+        ps2_key_state_send_word(word, ps2_keys_wanted[word] & ~ps2_keys_host[word] & mask, true);
+    }
+}
+
+// The oldest dropped event for a key tells what the host last saw of it:
+// a make it never got, or a break it never got
+static void ps2_key_state_unsend_event(uint8_t keycode, bool make) {
+    if (keycode == KC_NO || ps2_key_bit(ps2_keys_flushed, keycode)) return;
+
+    ps2_key_bit_set(ps2_keys_flushed, keycode, true);
+    ps2_key_bit_set(ps2_keys_host, keycode, !make);
+}
+
+static void ps2_key_state_unsend(const ps2_packet_t *packet) {
+    ps2_key_state_unsend_event(packet->keycode, !(packet->flags & PS2_PACKET_RELEASE));
+}
+
+// Clear the output buffer and the backlog behind it, rolling the model back
+// over what was dropped
+static void ps2_key_state_flush(void) {
+    memset(ps2_keys_flushed, 0, sizeof(ps2_keys_flushed));
+    ps2_queue_flush(&ps2_keyboard_port.queue, ps2_key_state_unsend);
+    for (uint16_t i = 0; i < ps2_backlog_count; i++) {
+        uint16_t entry = ps2_backlog[(ps2_backlog_tail + i) % PS2_BACKLOG_SIZE];
+        ps2_key_state_unsend_event(entry & 0xFF, !(entry & PS2_BACKLOG_RELEASE));
+    }
+    ps2_backlog_count = 0;
+}
+
+// Backlogged keys and those left in the diff go out once the engine made room
+static void ps2_send_deferred(void) {
+    ps2_backlog_drain();
+    if (ps2_resync_pending && ps2_backlog_count == 0 && ps2_queue_has_room()) {
+        ps2_resync_pending = false;
+        ps2_keyboard_resync();
+    }
+}
+
+// Drop the backlog and send only what the host is missing now
+void ps2_keyboard_catch_up(void) {
+    ps2_key_state_flush();
+    ps2_keyboard_resync();
+}
+
+// Host was reset and holds nothing. Presses it never saw are not worth
+// replaying to a different host (or the same one after a reset).
+static void ps2_key_state_forget(void) {
+    memset(ps2_keys_host, 0, sizeof(ps2_keys_host));
+    ps2_backlog_count = 0;
+    ps2_extra_forget();
+}
+
+// QMK holds nothing (its reports were cleared)
+static void ps2_key_state_release_all(void) {
+    memset(ps2_keys_wanted, 0, sizeof(ps2_keys_wanted));
+    ps2_extra_clear();
+}
+
+// Replace the keyboard part of ps2_keys_wanted, keeping the extra keys
+static void ps2_key_state_want(const uint8_t *bits, uint8_t bits_len, uint8_t mods) {
+    memset(ps2_keys_wanted, 0, sizeof(ps2_keys_wanted));
+    memcpy(ps2_keys_wanted, bits, bits_len);
+    ps2_keys_wanted[PS2_MODS_WORD] |= (uint32_t)mods << PS2_MODS_SHIFT;
+    ps2_extra_want();
+}
+
+// =============================================================================
+// EXTRA KEYS
+// =============================================================================
+// Consumer and system keys. An encoder turns a volume knob into a make and a
+// break per detent, faster than the bus can carry them, and QMK may hold a
+// consumer and a system usage at once. Each key gets a slot that counts the
+// presses QMK reported; the meter turns the count into make/break pairs one
+// event at a time, at most every PS2_EXTRA_INTERVAL_US and only while the
+// queue is nearly empty. A fast spin becomes a backlog that drains at bus
+// pace: every detent arrives, QMK never waits for it, and typing keeps the
+// queue to itself. The meter owns these keys' bits in ps2_keys_wanted.
+
+#ifndef PS2_EXTRA_SLOTS
+#define PS2_EXTRA_SLOTS 8
+#endif
+
+// Set 2 Volume Up is E0 32 / E0 F0 32: a pair takes ~5 ms at 12 kHz, so
+// 4 ms per event leaves the bus idle about a third of the time
+#ifndef PS2_EXTRA_INTERVAL_US
+#define PS2_EXTRA_INTERVAL_US 4000
+#endif
+
+typedef struct {
+    uint8_t keycode;   // KC_NO = free slot
+    bool held;         // QMK's report still holds it
+    bool down;         // Its bit in ps2_keys_wanted
+    uint16_t presses;  // Reported presses whose make hasn't gone out
+} ps2_extra_key_t;
+
+static ps2_extra_key_t ps2_extra_keys[PS2_EXTRA_SLOTS];
+static uint8_t ps2_extra_report_keys[2];  // Usage held per report: system, consumer
+static uint8_t ps2_extra_turn = 0;        // Slot the meter looks at first
+static uint32_t ps2_extra_next_us = 0;    // Earliest time of the next event
+
+static ps2_extra_key_t *ps2_extra_find(uint8_t keycode) {
+    for (uint8_t i = 0; i < PS2_EXTRA_SLOTS; i++) {
+        if (ps2_extra_keys[i].keycode == keycode) {
+            return &ps2_extra_keys[i];
         }
     }
+    return NULL;
+}
 
-    // Handle regular key presses
-    for (int i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
-        uint8_t keycode = report->keys[i];
-        bool was_pressed = false;
+static bool ps2_extra_is_key(uint8_t keycode) {
+    return keycode != KC_NO && ps2_extra_find(keycode) != NULL;
+}
 
-        if (keycode == 0) continue;
+static void ps2_extra_press(uint8_t keycode) {
+    ps2_extra_key_t *key = ps2_extra_find(keycode);
+    if (key == NULL) {
+        key = ps2_extra_find(KC_NO);
+        if (key == NULL) {
+            PS2_TRACE_WARN(PS2_EV_EXTRA_FULL, keycode, 0, 0);
+            ps2_stats_count(PS2_COUNT_KEY_DROPPED);
+            return;
+        }
+        *key = (ps2_extra_key_t){.keycode = keycode};
+    }
+    key->held = true;
+    if (key->presses < UINT16_MAX) {
+        key->presses++;
+    }
+}
 
-        for (int j = 0; j < KEYBOARD_REPORT_KEYS; j++) {
-            if (previous_report.keys[j] == keycode) {
-                was_pressed = true;
-                break;
-            }
+static void ps2_extra_release(uint8_t keycode) {
+    ps2_extra_key_t *key = ps2_extra_find(keycode);
+    if (key != NULL) {
+        key->held = false;
+    }
+}
+
+// Put the keys the meter has down back into a freshly built ps2_keys_wanted
+static void ps2_extra_want(void) {
+    for (uint8_t i = 0; i < PS2_EXTRA_SLOTS; i++) {
+        if (ps2_extra_keys[i].keycode != KC_NO && ps2_extra_keys[i].down) {
+            ps2_key_bit_set(ps2_keys_wanted, ps2_extra_keys[i].keycode, true);
         }
+    }
+}
 
-        if (!was_pressed) {
-            ps2_mapping_t mapping = qmk_to_ps2_scancode(keycode);
-            if (mapping.scancode != 0) {
-                if (mapping.special_type == PS2_KEY_PRINTSCREEN) {
-                    ps2_keyboard_send_printscreen_make();
-                    continue;
-                }
-
-                if (mapping.special_type == PS2_KEY_PAUSE) {
-                    ps2_keyboard_send_pause();
-                    continue;
-                }
-
-                uprintf("[PS2] Key pressed: keycode=0x%04X, scancode=0x%02X%s\n",
-                        keycode, mapping.scancode,
-                        mapping.needs_e0_prefix ? ", E0 prefix" : "");
-                if (mapping.needs_e0_prefix) {
-                    ps2_keyboard_send_key_make(PS2_PREFIX_E0);
-                }
-                ps2_keyboard_send_key_make(mapping.scancode);
-                ps2_keyboard_typematic_arm(keycode, mapping.scancode);
-            }
+// Drop the backlog; keys QMK still holds stay held
+static void ps2_extra_forget(void) {
+    for (uint8_t i = 0; i < PS2_EXTRA_SLOTS; i++) {
+        ps2_extra_keys[i].presses = 0;
+    }
+}
+
+static void ps2_extra_clear(void) {
+    memset(ps2_extra_keys, 0, sizeof(ps2_extra_keys));
+    memset(ps2_extra_report_keys, 0, sizeof(ps2_extra_report_keys));
+}
+
+// Next event for a slot: the break of a press the host has (once QMK let go,
+// or to make room for the next press), else the make of a counted press.
+// Returns false when the slot has nothing to send, freeing it if it's done.
+static bool ps2_extra_next_event(ps2_extra_key_t *key, bool *make) {
+    if (key->keycode == KC_NO) return false;
+
+    if (key->down) {
+        *make = false;
+        return !key->held || key->presses > 0;
+    }
+    if (key->presses > 0) {
+        *make = true;
+        return true;
+    }
+    if (!key->held && !ps2_key_bit(ps2_keys_host, key->keycode)) {
+        key->keycode = KC_NO;
+    }
+    return false;
+}
+
+// Send at most one extra key event, if the bus has room for it. Runs after
+// every extra report and from ps2_keyboard_task().
+static void ps2_extra_meter(void) {
+    if (!ps2_keys_flow()) return;
+    if (ps2_queue_free(&ps2_keyboard_port.queue) < PS2_QUEUE_SIZE - 1) return;
+    uint32_t now = ps2_micros();
+    if ((int32_t)(now - ps2_extra_next_us) < 0) return;
+
+    for (uint8_t n = 0; n < PS2_EXTRA_SLOTS; n++) {
+        uint8_t i = (ps2_extra_turn + n) % PS2_EXTRA_SLOTS;
+        ps2_extra_key_t *key = &ps2_extra_keys[i];
+        bool make;
+        if (!ps2_extra_next_event(key, &make)) continue;
+
+        key->down = make;
+        if (make) {
+            key->presses--;
         }
+        ps2_key_bit_set(ps2_keys_wanted, key->keycode, make);
+        ps2_key_state_send(key->keycode, make);
+
+        // Keys take turns, so one knob can't hold back another's break
+        ps2_extra_turn = (i + 1) % PS2_EXTRA_SLOTS;
+        ps2_extra_next_us = now + PS2_EXTRA_INTERVAL_US;
+        return;
     }
+}
+
+// Reports are timed from arrival until their last sequence is queued. The
+// packets they queue carry the keystroke start for the end-to-end figure.
+static uint32_t ps2_report_begin(void) {
+    uint32_t now = ps2_stats_now();
+    ps2_report_origin = ps2_stats_report(now);
+    return now;
+}
+
+static void ps2_report_end(uint32_t start) {
+    ps2_stats_record(PS2_STAGE_DIFF, ps2_stats_now() - start);
+    ps2_report_origin = 0;
+}
 
-    previous_report = *report;
+static void ps2_send_keyboard(report_keyboard_t *report) {
+    uint32_t start = ps2_report_begin();
+    uint8_t bits[PS2_KEY_WORDS * 4] = {0};
+    uint8_t held = 0;
+
+    for (int i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report->keys[i] != 0) {
+            bits[report->keys[i] / 8] |= 1 << (report->keys[i] % 8);
+            held++;
+        }
+    }
+    PS2_TRACE_DEBUG(PS2_EV_REPORT, held, 0, report->mods);
+    ps2_key_state_want(bits, sizeof(bits), report->mods);
+    ps2_keyboard_resync();
+    ps2_report_end(start);
 }
 
+// Bit n of the NKRO bitmap is keycode n, the same layout as the model
 static void ps2_send_nkro(report_nkro_t *report) {
-    // Not implemented
+    uint32_t start = ps2_report_begin();
+    ps2_key_state_want(report->bits, sizeof(report->bits), report->mods);
+    ps2_keyboard_resync();
+    ps2_report_end(start);
 }
 
+// Mouse reports go to the mouse port, which has its own host connection
 static void ps2_send_mouse(report_mouse_t *report) {
-    // Not implemented
+    ps2_mouse_report(report);
 }
 
-// Handle media/consumer keys - FIXED VERSION
+// Consumer and system reports each hold one usage; a change releases the
+// old key and counts a press of the new one for the meter (see EXTRA KEYS)
 static void ps2_send_extra(report_extra_t *report) {
-    uint16_t current_media_key = 0;
-
-    if (report->report_id == REPORT_ID_CONSUMER) {
-        current_media_key = report->usage;
-        uprintf("[PS2] Extra key report: usage=0x%04X\n", current_media_key);
-    }
-
-    if (current_media_key != previous_media_key) {
-        // 1. Handle Release (Break)
-        if (previous_media_key != 0) {
-            // USE CONSUMER MAPPING for consumer control codes
-            ps2_mapping_t mapping = consumer_to_ps2_scancode(previous_media_key);
-            // Ensure space for: E0 (prefix) + F0 (break) + Scancode = 3 bytes
-            if (mapping.scancode != 0 && ps2_buffer_has_space(3)) {
-                uprintf("[PS2] Media key RELEASE: usage=0x%04X, scancode=0x%02X%s\n",
-                        previous_media_key, mapping.scancode,
-                        mapping.needs_e0_prefix ? ", E0 prefix" : "");
-                if (mapping.needs_e0_prefix) {
-                    ps2_keyboard_send_raw_byte(PS2_PREFIX_E0);
-                }
-                ps2_keyboard_send_key_break(mapping.scancode);
-            } else if (mapping.scancode == 0) {
-                uprintf("[PS2] WARNING: Previous consumer code 0x%04X has no PS/2 mapping!\n", previous_media_key);
-            }
-        }
+    bool system = report->report_id == REPORT_ID_SYSTEM;
+    if (!system && report->report_id != REPORT_ID_CONSUMER) {
+        return;
+    }
+    uint32_t start = ps2_report_begin();
 
-        // 2. Handle Press (Make)
-        if (current_media_key != 0) {
-            // USE CONSUMER MAPPING for consumer control codes
-            ps2_mapping_t mapping = consumer_to_ps2_scancode(current_media_key);
-            // Ensure space for: E0 (prefix) + Scancode = 2 bytes
-            if (mapping.scancode != 0 && ps2_buffer_has_space(2)) {
-                uprintf("[PS2] Media key PRESS: usage=0x%04X, scancode=0x%02X%s\n",
-                        current_media_key, mapping.scancode,
-                        mapping.needs_e0_prefix ? ", E0 prefix" : "");
-                if (mapping.needs_e0_prefix) {
-                    ps2_keyboard_send_raw_byte(PS2_PREFIX_E0);
-                }
-                ps2_keyboard_send_key_make(mapping.scancode);
-
-                // NOTE: We do NOT call ps2_keyboard_typematic_arm() here
-                // because media keys should not repeat in PS/2.
-            } else if (mapping.scancode == 0) {
-                uprintf("[PS2] WARNING: Current consumer code 0x%04X has no PS/2 mapping!\n", current_media_key);
-            }
+    uint8_t keycode = system ? ps2_keycode_for_system_usage(report->usage)
+                             : ps2_keycode_for_usage(report->usage);
+    PS2_TRACE_DEBUG(PS2_EV_EXTRA, report->usage, keycode, report->report_id);
+    if (report->usage != 0 && keycode == KC_NO) {
+        PS2_TRACE_WARN(PS2_EV_UNMAPPED_USAGE, report->usage, 0, report->report_id);
+    }
+
+    uint8_t *held = &ps2_extra_report_keys[system ? 0 : 1];
+    if (keycode != *held) {
+        if (*held != KC_NO) {
+            ps2_extra_release(*held);
+        }
+        *held = keycode;
+        if (keycode != KC_NO) {
+            ps2_extra_press(keycode);
         }
-        previous_media_key = current_media_key;
     }
+    ps2_report_end(start);
+
+    // Metered events are paced, not keystroke latency
+    ps2_extra_meter();
 }
 
 // Create the driver struct
@@ -644,9 +1238,3 @@ host_driver_t ps2_keyboard_host_driver = {
     .send_mouse = ps2_send_mouse,
     .send_extra = ps2_send_extra,
 };
-
-// Keep ps2_handle_command available for future host-to-device implementation
-// Mark as used to avoid compiler warnings
-void __attribute__((used)) ps2_device_process_host_command(uint8_t cmd) {
-    ps2_handle_command(cmd);
-}
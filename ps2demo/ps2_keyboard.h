@@ -5,11 +5,13 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "ps2_scancodes.h"
+#include "ps2_bus.h"
 #include "host_driver.h"    // For host_driver_t
 
 extern host_driver_t ps2_keyboard_host_driver;  // Declare the PS/2 driver
 extern ps2_special_key_type_t ps2_key_type; // Declare modifier mappings
 extern ps2_mapping_t qmk_to_ps2_scancode(uint16_t keycode); // Declare mapping function
+extern ps2_port_t ps2_keyboard_port;  // Keyboard bus (queue stats read it)
 
 // PS/2 Commands from host
 #define PS2_CMD_SET_LEDS           0xED
@@ -20,35 +22,18 @@ extern ps2_mapping_t qmk_to_ps2_scancode(uint16_t keycode); // Declare mapping f
 #define PS2_CMD_ENABLE             0xF4
 #define PS2_CMD_DISABLE            0xF5
 #define PS2_CMD_SET_DEFAULTS       0xF6
+#define PS2_CMD_SET_ALL_TYPEMATIC  0xF7  // Set 3 key attributes: all keys...
+#define PS2_CMD_SET_ALL_MAKE_BREAK 0xF8
+#define PS2_CMD_SET_ALL_MAKE       0xF9
+#define PS2_CMD_SET_ALL_DEFAULT    0xFA  // ...typematic + make/break
+#define PS2_CMD_SET_KEY_TYPEMATIC  0xFB  // ...or a list of Set 3 keys
+#define PS2_CMD_SET_KEY_MAKE_BREAK 0xFC
+#define PS2_CMD_SET_KEY_MAKE       0xFD
 #define PS2_CMD_RESEND             0xFE
 #define PS2_CMD_RESET              0xFF
 
-// PS/2 Responses
-#define PS2_ACK                    0xFA
-#define PS2_RESEND                 0xFE
-#define PS2_BAT_SUCCESS            0xAA
-#define PS2_BAT_FAIL               0xFC
-#define PS2_ECHO_RESPONSE          0xEE
-
-/* NOT IN USE!
-// Scancode Sets (imlemented only Set 2 for now)
-typedef enum {
-    PS2_SCANCODE_SET_1 = 1,
-    PS2_SCANCODE_SET_2 = 2,
-    PS2_SCANCODE_SET_3 = 3
-} ps2_scancode_set_t;
-
-uint8_t ps2_keyboard_get_scancode_set(void);
-void ps2_keyboard_set_scancode_set(ps2_scancode_set_t set);
-*/
-
-// PS/2 State Machine
-typedef enum {
-    PS2_STATE_IDLE,
-    PS2_STATE_SENDING,
-    PS2_STATE_RECEIVING,
-    PS2_STATE_WAIT_RESPONSE
-} ps2_state_t;
+// Set Typematic argument applied by Set Defaults / Reset (500ms, ~30cps)
+#define PS2_TYPEMATIC_DEFAULT      0x20
 
 typedef struct {
     uint8_t scroll_lock : 1;
@@ -59,15 +44,32 @@ typedef struct {
 
 // PS/2 Keyboard Device functions (all renamed)
 void ps2_keyboard_init(uint8_t clk_pin, uint8_t data_pin);
-void ps2_keyboard_task(void);
+uint8_t ps2_keyboard_task(void);  // Returns bytes sent since last call
 bool ps2_keyboard_send_key_make(uint8_t scancode);
 bool ps2_keyboard_send_key_break(uint8_t scancode);
 ps2_led_state_t ps2_keyboard_get_leds(void);
 bool ps2_keyboard_is_enabled(void);
+void ps2_keyboard_set_timing_profile(ps2_timing_profile_id_t profile);
+ps2_timing_profile_id_t ps2_keyboard_get_timing_profile(void);
+ps2_scancode_set_t ps2_keyboard_get_scancode_set(void);
+void ps2_keyboard_set_scancode_set(ps2_scancode_set_t set);
+
+// Send whatever makes/breaks the host is missing to match the keys QMK
+// holds. Runs after every report and whenever the bus is enabled again.
+void ps2_keyboard_resync(void);
+
+// Same, but first drop every queued key sequence: the host skips straight
+// to the current state instead of replaying a stale burst
+void ps2_keyboard_catch_up(void);
+
+// Host detection: a new host gets the BAT and the keys held; without one
+// nothing is queued
+void ps2_keyboard_set_host_present(bool present);
 
 // Typematic functions (renamed)
 void ps2_keyboard_typematic_task(void);
 void ps2_keyboard_typematic_arm(uint16_t keycode, uint8_t scancode);
 void ps2_keyboard_typematic_stop(uint16_t keycode);
 void ps2_keyboard_typematic_disable(void);
+uint8_t ps2_keyboard_get_typematic(void);  // Last Set Typematic argument
 #endif // PS2_DEVICE_H
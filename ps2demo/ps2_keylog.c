@@ -0,0 +1,128 @@
+// ps2_keylog.c - Timestamped key event log for replay on the host
+//
+// Recording is an append of a few bytes per event; nothing is printed until
+// the log is stopped, and then only while both buses are idle, a line at a
+// time.
+#include "ps2_keylog.h"
+#include "ps2_keyboard.h"
+#include "ps2_mouse.h"
+#include "kb.h"
+#include <string.h>
+
+#if PS2_KEYLOG_ENABLE
+
+static uint8_t keylog_buf[PS2_KEYLOG_SIZE];
+static uint16_t keylog_len = 0;
+static uint16_t keylog_printed = 0;  // Bytes of a stopped log already printed
+static uint16_t keylog_events = 0;
+static uint16_t keylog_lost = 0;     // Events that didn't fit
+static bool keylog_on = false;
+static bool keylog_printing = false;
+
+// Matrix scan of the last event, and whether it is still going on
+static uint32_t keylog_scan_us = 0;
+static bool keylog_scan_open = false;
+
+void ps2_keylog_start(void) {
+    ps2_timing_profile_id_t profile = ps2_keyboard_get_timing_profile();
+
+    memcpy(keylog_buf, PS2_KEYLOG_MAGIC, 4);
+    keylog_buf[4] = PS2_KEYLOG_VERSION;
+    keylog_buf[5] = ps2_keyboard_get_scancode_set();
+    keylog_buf[6] = ps2_keyboard_get_typematic();
+    keylog_buf[7] = profile | (is_usb_mode() ? PS2_KEYLOG_USB_MODE : 0);
+    keylog_len = PS2_KEYLOG_HEADER_SIZE;
+    keylog_events = 0;
+    keylog_lost = 0;
+    keylog_printing = false;
+    keylog_scan_us = ps2_micros();
+    keylog_scan_open = false;
+    keylog_on = true;
+    uprintf("[PS2] Key log recording\n");
+}
+
+void ps2_keylog_stop(void) {
+    if (!keylog_on) {
+        return;
+    }
+    keylog_on = false;
+    keylog_printed = 0;
+    keylog_printing = true;
+    uprintf("[PS2] Key log: %u events in %u bytes, %u lost\n", keylog_events, keylog_len, keylog_lost);
+}
+
+bool ps2_keylog_recording(void) {
+    return keylog_on;
+}
+
+void ps2_keylog_event(uint16_t keycode, bool pressed) {
+    if (!keylog_on) {
+        return;
+    }
+    if (keylog_len + PS2_KEYLOG_RECORD_MAX > PS2_KEYLOG_SIZE) {
+        if (keylog_lost < UINT16_MAX) {
+            keylog_lost++;
+        }
+        return;
+    }
+
+    // The first event of a scan carries the time since the previous scan
+    // (never 0, which marks the same scan)
+    uint32_t delta = 0;
+    if (!keylog_scan_open) {
+        uint32_t now = ps2_micros();
+        delta = now - keylog_scan_us;
+        if (delta == 0) {
+            delta = 1;
+        } else if (delta > 0x7FFFFFFF) {
+            delta = 0x7FFFFFFF;
+        }
+        keylog_scan_us = now;
+        keylog_scan_open = true;
+    }
+
+    uint32_t head = delta << 1 | pressed;
+    do {
+        uint8_t byte = head & 0x7F;
+        head >>= 7;
+        keylog_buf[keylog_len++] = byte | (head ? 0x80 : 0);
+    } while (head);
+    keylog_buf[keylog_len++] = keycode & 0xFF;
+    keylog_buf[keylog_len++] = keycode >> 8;
+    keylog_events++;
+}
+
+void ps2_keylog_task(void) {
+    keylog_scan_open = false;
+
+    if (!keylog_printing || !ps2_bus_is_idle(&ps2_keyboard_port) || !ps2_mouse_is_idle()) {
+        return;
+    }
+
+    // "PS2K 50533...": the log as it sits in the buffer
+    uint16_t end = keylog_printed + PS2_KEYLOG_LINE;
+    if (end > keylog_len) {
+        end = keylog_len;
+    }
+    char line[5 + PS2_KEYLOG_LINE * 2 + 2];
+    char *p = line + 5;
+    memcpy(line, "PS2K ", 5);
+    for (uint16_t i = keylog_printed; i < end; i++) {
+        static const char hex[] = "0123456789ABCDEF";
+        *p++ = hex[keylog_buf[i] >> 4];
+        *p++ = hex[keylog_buf[i] & 0xF];
+    }
+    *p++ = '\n';
+    *p = '\0';
+    uprintf("%s", line);
+
+    keylog_printed = end;
+    keylog_printing = keylog_printed < keylog_len;
+}
+
+const uint8_t *ps2_keylog_data(uint16_t *len) {
+    *len = keylog_len;
+    return keylog_buf;
+}
+
+#endif
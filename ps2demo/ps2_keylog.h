@@ -0,0 +1,81 @@
+// ps2_keylog.h - Timestamped key event log for replay on the host
+//
+// Records every process_record_kb() event into a RAM buffer while the
+// PS2_KEYLOG key has it switched on; pressing the key again prints the
+// buffer to the console as "PS2K <hex>" lines. sim/replay (repo root) feeds
+// the log back through the driver on the virtual clock, so a session typed
+// on the real keyboard becomes a repeatable test case.
+//
+// Format (little endian):
+//
+//   "PS2K" version set typematic profile   8 byte header
+//   varint head, uint16 keycode            one record per event
+//
+// set is the scancode set, typematic the last Set Typematic argument and
+// profile the bus timing profile when recording started (bit 7 set: USB
+// mode). head is LEB128 of (delta << 1 | pressed), delta the microseconds
+// from the previous event's matrix scan to this one's, or 0 for another
+// event from the same scan.
+#ifndef PS2_KEYLOG_H
+#define PS2_KEYLOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// On by default when there is a console to print the log to
+#ifndef PS2_KEYLOG_ENABLE
+#ifdef CONSOLE_ENABLE
+#define PS2_KEYLOG_ENABLE 1
+#else
+#define PS2_KEYLOG_ENABLE 0
+#endif
+#endif
+
+// Buffer size in bytes, header included (3-7 bytes per event, ~5 typing)
+#ifndef PS2_KEYLOG_SIZE
+#define PS2_KEYLOG_SIZE 8192
+#endif
+
+// Bytes per console line
+#ifndef PS2_KEYLOG_LINE
+#define PS2_KEYLOG_LINE 32
+#endif
+
+#define PS2_KEYLOG_MAGIC       "PS2K"
+#define PS2_KEYLOG_VERSION     1
+#define PS2_KEYLOG_HEADER_SIZE 8
+#define PS2_KEYLOG_USB_MODE    0x80  // In the profile byte
+#define PS2_KEYLOG_RECORD_MAX  7     // 5 byte head + keycode
+
+#if PS2_KEYLOG_ENABLE
+// Clear the buffer and record from now on
+void ps2_keylog_start(void);
+
+// Stop recording and print the log, a line per ps2_keylog_task() call
+void ps2_keylog_stop(void);
+
+bool ps2_keylog_recording(void);
+
+// A process_record_kb() event. Dropped (and counted) once the buffer is full.
+void ps2_keylog_event(uint16_t keycode, bool pressed);
+
+// Once per main loop, after the matrix scan: closes the scan and prints the
+// next line of a stopped log while both buses are idle
+void ps2_keylog_task(void);
+
+// The log recorded so far (or last), header first
+const uint8_t *ps2_keylog_data(uint16_t *len);
+#else
+static inline void ps2_keylog_start(void) {}
+static inline void ps2_keylog_stop(void) {}
+static inline bool ps2_keylog_recording(void) {
+    return false;
+}
+static inline void ps2_keylog_event(uint16_t keycode, bool pressed) {
+    (void)keycode;
+    (void)pressed;
+}
+static inline void ps2_keylog_task(void) {}
+#endif
+
+#endif // PS2_KEYLOG_H
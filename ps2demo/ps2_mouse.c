@@ -0,0 +1,461 @@
+// ps2_mouse.c - PS/2 mouse device on its own port
+//
+// Speaks the standard 3-byte protocol plus the IntelliMouse extensions hosts
+// probe for (wheel, buttons 4/5). QMK's mouse reports are added up and sent
+// as one packet per sample period the host asked for, so a fast pointing
+// device never floods the bus and nothing it reports is lost.
+#include "ps2_mouse.h"
+#include "ps2_bus.h"
+#include "ps2_trace.h"
+#include "quantum.h"
+#include <string.h>
+
+typedef enum {
+    PS2_MOUSE_MODE_STREAM,  // Packets at the sample rate while enabled
+    PS2_MOUSE_MODE_REMOTE,  // Packets only on Read Data (0xEB)
+    PS2_MOUSE_MODE_WRAP     // Echo every byte back (diagnostics)
+} ps2_mouse_mode_t;
+
+// Movement held back before it is clamped, in quarter counts: twice what
+// one packet can carry
+#define PS2_MOUSE_MOTION_LIMIT (2 * 255 * 4)
+#define PS2_MOUSE_WHEEL_LIMIT  16
+
+ps2_port_t ps2_mouse_port;
+
+static struct {
+    ps2_mouse_mode_t mode;
+    ps2_mouse_mode_t wrap_return;  // Mode to go back to when wrap mode ends
+    bool reporting;                // Stream packets enabled (0xF4)
+    bool scaling_2_1;
+    uint8_t resolution;            // 0-3: 1, 2, 4 or 8 counts/mm
+    uint8_t sample_rate;           // Packets per second in stream mode
+    uint8_t id;
+    uint8_t rates[3];              // Last three sample rates, newest last
+    uint8_t pending_command;       // Waiting for its argument byte
+} ps2_mouse;
+
+// Movement not sent yet. x and y are in quarter counts at the current
+// resolution so QMK's counts (taken as 4/mm, the default resolution) survive
+// a lower one without rounding away slow movement.
+static struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    uint8_t buttons;
+    bool buttons_changed;
+    uint32_t next_us;  // Earliest time the next stream packet may go out
+} ps2_mouse_motion;
+
+static void ps2_mouse_respond(uint8_t byte) {
+    ps2_packet_t packet = {.len = 1, .priority = PS2_PRIO_RESPONSE, .bytes = {byte}};
+    if (!ps2_queue_push(&ps2_mouse_port.queue, &packet)) {
+        PS2_TRACE_WARN(PS2_EV_RESPONSE_DROPPED, 0, 0, byte);
+    }
+}
+
+// =============================================================================
+// MOVEMENT PACKETS
+// =============================================================================
+
+static inline int16_t ps2_mouse_clamp(int32_t value, int16_t limit) {
+    return value > limit ? limit : value < -limit ? -limit : value;
+}
+
+static bool ps2_mouse_motion_pending(void) {
+    return ps2_mouse_motion.buttons_changed || ps2_mouse_motion.z != 0 ||
+           ps2_mouse_motion.x >= 4 || ps2_mouse_motion.x <= -4 ||
+           ps2_mouse_motion.y >= 4 || ps2_mouse_motion.y <= -4;
+}
+
+// Counters restart from zero, buttons stay as they are
+static void ps2_mouse_motion_clear(void) {
+    ps2_mouse_motion.x = 0;
+    ps2_mouse_motion.y = 0;
+    ps2_mouse_motion.z = 0;
+    ps2_mouse_motion.buttons_changed = false;
+}
+
+// Whole counts one packet can carry; the rest stays for the next one
+static int16_t ps2_mouse_take(int16_t *quarters) {
+    int16_t count = ps2_mouse_clamp(*quarters / 4, 255);
+    *quarters -= count * 4;
+    return count;
+}
+
+// 2:1 scaling: small movements stay small, larger ones are doubled
+static int16_t ps2_mouse_scale(int16_t count) {
+    static const uint8_t scaled[6] = {0, 1, 1, 3, 6, 9};
+    int16_t magnitude = count < 0 ? -count : count;
+    magnitude = magnitude < 6 ? scaled[magnitude] : magnitude * 2;
+    if (magnitude > 255) {
+        magnitude = 255;
+    }
+    return count < 0 ? -magnitude : magnitude;
+}
+
+// Byte 1: Y overflow, X overflow, Y sign, X sign, 1, middle, right, left.
+// The overflow bits stay clear: movement past 255 waits for the next packet.
+static void ps2_mouse_build(ps2_packet_t *packet, bool stream) {
+    int16_t x = ps2_mouse_take(&ps2_mouse_motion.x);
+    int16_t y = ps2_mouse_take(&ps2_mouse_motion.y);
+    uint8_t buttons = ps2_mouse_motion.buttons;
+
+    // Scaling never applies to Read Data
+    if (stream && ps2_mouse.scaling_2_1) {
+        x = ps2_mouse_scale(x);
+        y = ps2_mouse_scale(y);
+    }
+
+    packet->len = 0;
+    packet->bytes[packet->len++] = 0x08 | (buttons & 0x07) | (x < 0 ? 0x10 : 0) | (y < 0 ? 0x20 : 0);
+    packet->bytes[packet->len++] = x & 0xFF;
+    packet->bytes[packet->len++] = y & 0xFF;
+
+    if (ps2_mouse.id != PS2_MOUSE_ID_STANDARD) {
+        int8_t z = ps2_mouse_clamp(ps2_mouse_motion.z, 7);
+        ps2_mouse_motion.z -= z;
+        if (ps2_mouse.id == PS2_MOUSE_ID_FIVE_BUTTON) {
+            // Byte 4: 0, 0, button 5, button 4, Z (4 bits)
+            packet->bytes[packet->len++] = (z & 0x0F) | ((buttons & 0x18) << 1);
+        } else {
+            packet->bytes[packet->len++] = z;
+        }
+    } else {
+        ps2_mouse_motion.z = 0;
+    }
+    ps2_mouse_motion.buttons_changed = false;
+
+    PS2_TRACE_DEBUG(PS2_EV_MOUSE_PACKET, (uint16_t)x, (uint16_t)y, buttons);
+}
+
+static void ps2_mouse_send_motion(ps2_priority_t priority, bool stream) {
+    ps2_packet_t packet = {.priority = priority};
+    ps2_mouse_build(&packet, stream);
+    if (!ps2_queue_push(&ps2_mouse_port.queue, &packet)) {
+        PS2_TRACE_WARN(PS2_EV_QUEUE_FULL, priority, 0, packet.bytes[0]);
+    }
+}
+
+// Stream mode: at most one packet per sample period, on a fixed grid so a
+// late main loop doesn't slow the rate down
+static void ps2_mouse_stream_task(void) {
+    if (ps2_mouse.mode != PS2_MOUSE_MODE_STREAM || !ps2_mouse.reporting || !ps2_mouse_motion_pending()) {
+        return;
+    }
+
+    uint32_t now = ps2_micros();
+    if ((int32_t)(now - ps2_mouse_motion.next_us) < 0) {
+        return;
+    }
+
+    // One packet waiting at a time: movement meanwhile goes into the next
+    // one instead of queueing up stale positions
+    if (ps2_queue_has_pending(&ps2_mouse_port.queue, PS2_PRIO_MAKE)) {
+        return;
+    }
+
+    uint32_t period = 1000000UL / ps2_mouse.sample_rate;
+    ps2_mouse_motion.next_us += period;
+    if ((int32_t)(now - ps2_mouse_motion.next_us) >= 0) {
+        ps2_mouse_motion.next_us = now + period;
+    }
+    ps2_mouse_send_motion(PS2_PRIO_MAKE, true);
+}
+
+static void ps2_mouse_motion_add(int32_t x, int32_t y, int32_t z, uint8_t buttons) {
+    if (ps2_mouse.mode == PS2_MOUSE_MODE_WRAP ||
+        (ps2_mouse.mode == PS2_MOUSE_MODE_STREAM && !ps2_mouse.reporting)) {
+        return;
+    }
+
+    // A click shorter than the sample period: send the press before the
+    // release overwrites it
+    if (buttons != ps2_mouse_motion.buttons && ps2_mouse_motion.buttons_changed &&
+        ps2_mouse.mode == PS2_MOUSE_MODE_STREAM) {
+        ps2_mouse_send_motion(PS2_PRIO_MAKE, true);
+    }
+
+    int32_t scale = 1 << ps2_mouse.resolution;
+    ps2_mouse_motion.x = ps2_mouse_clamp(ps2_mouse_motion.x + x * scale, PS2_MOUSE_MOTION_LIMIT);
+    ps2_mouse_motion.y = ps2_mouse_clamp(ps2_mouse_motion.y + y * scale, PS2_MOUSE_MOTION_LIMIT);
+    ps2_mouse_motion.z = ps2_mouse_clamp(ps2_mouse_motion.z + z, PS2_MOUSE_WHEEL_LIMIT);
+    if (buttons != ps2_mouse_motion.buttons) {
+        ps2_mouse_motion.buttons = buttons;
+        ps2_mouse_motion.buttons_changed = true;
+    }
+}
+
+// QMK: Y grows downwards and V upwards; PS/2: Y grows upwards and Z downwards
+void ps2_mouse_report(const report_mouse_t *report) {
+    ps2_mouse_motion_add(report->x, -(int32_t)report->y, -(int32_t)report->v, report->buttons);
+}
+
+void ps2_mouse_send_packet(int8_t x, int8_t y, uint8_t buttons) {
+    ps2_mouse_motion_add(x, y, 0, buttons);
+}
+
+// =============================================================================
+// COMMAND HANDLING
+// =============================================================================
+
+static void ps2_mouse_set_defaults(void) {
+    ps2_mouse.reporting = false;
+    ps2_mouse.scaling_2_1 = false;
+    ps2_mouse.resolution = 2;
+    ps2_mouse.sample_rate = 100;
+    ps2_mouse_motion_clear();
+}
+
+// Reset: defaults, stream mode and the plain 3-byte protocol
+static void ps2_mouse_reset(void) {
+    ps2_mouse_set_defaults();
+    ps2_mouse.mode = PS2_MOUSE_MODE_STREAM;
+    ps2_mouse.id = PS2_MOUSE_ID_STANDARD;
+    ps2_mouse.pending_command = 0;
+    memset(ps2_mouse.rates, 0, sizeof(ps2_mouse.rates));
+}
+
+static bool ps2_mouse_rates_are(uint8_t a, uint8_t b, uint8_t c) {
+    return ps2_mouse.rates[0] == a && ps2_mouse.rates[1] == b && ps2_mouse.rates[2] == c;
+}
+
+// The IntelliMouse knock: sample rates 200, 100, 80 turn the wheel on, then
+// 200, 200, 80 the extra buttons. Hosts check the result with Get Device ID.
+static void ps2_mouse_note_rate(uint8_t rate) {
+    ps2_mouse.rates[0] = ps2_mouse.rates[1];
+    ps2_mouse.rates[1] = ps2_mouse.rates[2];
+    ps2_mouse.rates[2] = rate;
+
+    uint8_t id = ps2_mouse.id;
+    if (id == PS2_MOUSE_ID_STANDARD && ps2_mouse_rates_are(200, 100, 80)) {
+        id = PS2_MOUSE_ID_WHEEL;
+    } else if (id == PS2_MOUSE_ID_WHEEL && ps2_mouse_rates_are(200, 200, 80)) {
+        id = PS2_MOUSE_ID_FIVE_BUTTON;
+    }
+    if (id != ps2_mouse.id) {
+        ps2_mouse.id = id;
+        PS2_TRACE_INFO(PS2_EV_MOUSE_ID, 0, 0, id);
+    }
+}
+
+static bool ps2_mouse_rate_valid(uint8_t rate) {
+    switch (rate) {
+        case 10:
+        case 20:
+        case 40:
+        case 60:
+        case 80:
+        case 100:
+        case 200:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Bit 6 remote mode, 5 enabled, 4 2:1 scaling, 2 left, 1 middle, 0 right
+static uint8_t ps2_mouse_status(void) {
+    uint8_t buttons = ps2_mouse_motion.buttons;
+    return (ps2_mouse.mode == PS2_MOUSE_MODE_REMOTE ? 0x40 : 0) | (ps2_mouse.reporting ? 0x20 : 0) |
+           (ps2_mouse.scaling_2_1 ? 0x10 : 0) | ((buttons & 0x01) << 2) | ((buttons & 0x04) >> 1) |
+           ((buttons & 0x02) >> 1);
+}
+
+static void ps2_mouse_handle_argument(uint8_t cmd, uint8_t arg) {
+    switch (cmd) {
+        case PS2_MOUSE_CMD_SET_SAMPLE_RATE:
+            if (!ps2_mouse_rate_valid(arg)) {
+                ps2_mouse_respond(PS2_RESEND);
+                ps2_mouse.pending_command = cmd;
+                return;
+            }
+            ps2_mouse.sample_rate = arg;
+            ps2_mouse_motion_clear();
+            ps2_mouse_respond(PS2_ACK);
+            ps2_mouse_note_rate(arg);
+            break;
+
+        case PS2_MOUSE_CMD_SET_RESOLUTION:
+            if (arg > 3) {
+                ps2_mouse_respond(PS2_RESEND);
+                ps2_mouse.pending_command = cmd;
+                return;
+            }
+            ps2_mouse.resolution = arg;
+            ps2_mouse_motion_clear();
+            ps2_mouse_respond(PS2_ACK);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void ps2_mouse_handle_command(uint8_t cmd) {
+    // Argument byte for a previous command. A command byte in its place
+    // aborts the pending command and is handled on its own.
+    if (ps2_mouse.pending_command != 0) {
+        uint8_t pending = ps2_mouse.pending_command;
+        ps2_mouse.pending_command = 0;
+        if (cmd < PS2_MOUSE_CMD_SET_SCALING_1_1) {
+            ps2_mouse_handle_argument(pending, cmd);
+            return;
+        }
+    }
+
+    switch (cmd) {
+        case PS2_MOUSE_CMD_SET_SCALING_1_1:
+            ps2_mouse.scaling_2_1 = false;
+            ps2_mouse_respond(PS2_ACK);
+            break;
+
+        case PS2_MOUSE_CMD_SET_SCALING_2_1:
+            ps2_mouse.scaling_2_1 = true;
+            ps2_mouse_respond(PS2_ACK);
+            break;
+
+        // Wait for the resolution / sample rate byte
+        case PS2_MOUSE_CMD_SET_RESOLUTION:
+        case PS2_MOUSE_CMD_SET_SAMPLE_RATE:
+            ps2_mouse_respond(PS2_ACK);
+            ps2_mouse.pending_command = cmd;
+            break;
+
+        case PS2_MOUSE_CMD_STATUS_REQUEST:
+            ps2_mouse_respond(PS2_ACK);
+            ps2_mouse_respond(ps2_mouse_status());
+            ps2_mouse_respond(ps2_mouse.resolution);
+            ps2_mouse_respond(ps2_mouse.sample_rate);
+            break;
+
+        case PS2_MOUSE_CMD_SET_STREAM_MODE:
+        case PS2_MOUSE_CMD_SET_REMOTE_MODE:
+            ps2_mouse.mode = cmd == PS2_MOUSE_CMD_SET_STREAM_MODE ? PS2_MOUSE_MODE_STREAM : PS2_MOUSE_MODE_REMOTE;
+            ps2_mouse_motion_clear();
+            ps2_mouse_respond(PS2_ACK);
+            break;
+
+        // One packet right behind the ACK, in any mode
+        case PS2_MOUSE_CMD_READ_DATA:
+            ps2_mouse_respond(PS2_ACK);
+            ps2_mouse_send_motion(PS2_PRIO_RESPONSE, false);
+            ps2_mouse_motion_clear();
+            break;
+
+        case PS2_MOUSE_CMD_SET_WRAP_MODE:
+            ps2_mouse.wrap_return = ps2_mouse.mode;
+            ps2_mouse.mode = PS2_MOUSE_MODE_WRAP;
+            ps2_mouse_motion_clear();
+            ps2_mouse_respond(PS2_ACK);
+            break;
+
+        case PS2_MOUSE_CMD_RESET_WRAP_MODE:
+            if (ps2_mouse.mode == PS2_MOUSE_MODE_WRAP) {
+                ps2_mouse.mode = ps2_mouse.wrap_return;
+            }
+            ps2_mouse_respond(PS2_ACK);
+            break;
+
+        case PS2_MOUSE_CMD_GET_DEVICE_ID:
+            ps2_mouse_motion_clear();
+            ps2_mouse_respond(PS2_ACK);
+            ps2_mouse_respond(ps2_mouse.id);
+            break;
+
+        case PS2_MOUSE_CMD_ENABLE:
+        case PS2_MOUSE_CMD_DISABLE:
+            ps2_mouse.reporting = cmd == PS2_MOUSE_CMD_ENABLE;
+            ps2_mouse_motion_clear();
+            ps2_mouse_respond(PS2_ACK);
+            break;
+
+        case PS2_MOUSE_CMD_SET_DEFAULTS:
+            ps2_mouse_set_defaults();
+            ps2_mouse_respond(PS2_ACK);
+            break;
+
+        // A mouse resends its whole last packet, not just the last byte
+        case PS2_MOUSE_CMD_RESEND:
+            if (!ps2_bus_resend(&ps2_mouse_port, true)) {
+                PS2_TRACE_WARN(PS2_EV_RESPONSE_DROPPED, 0, 0, ps2_mouse_port.tx_last_byte);
+            }
+            break;
+
+        // Self test passed, then the device ID
+        case PS2_MOUSE_CMD_RESET:
+            ps2_mouse_reset();
+            ps2_mouse_respond(PS2_ACK);
+            ps2_mouse_respond(PS2_BAT_SUCCESS);
+            ps2_mouse_respond(PS2_MOUSE_ID_STANDARD);
+            break;
+
+        default:
+            ps2_mouse_respond(PS2_RESEND);
+            break;
+    }
+}
+
+// Byte from the host. It interrupts whatever the mouse had queued: pending
+// movement packets are dropped, command responses are kept.
+static void ps2_mouse_received(uint16_t mailbox) {
+    if (mailbox & PS2_RX_MAILBOX_ERROR) {
+        PS2_TRACE_WARN(PS2_EV_HOST_FRAME_ERROR, 0, 0, 0);
+        ps2_mouse_respond(PS2_RESEND);
+        return;
+    }
+
+    uint8_t byte = mailbox & 0xFF;
+    PS2_TRACE_INFO(PS2_EV_MOUSE_COMMAND, 0, 0, byte);
+
+    // Wrap mode echoes everything except the two ways out of it
+    if (ps2_mouse.mode == PS2_MOUSE_MODE_WRAP && byte != PS2_MOUSE_CMD_RESET &&
+        byte != PS2_MOUSE_CMD_RESET_WRAP_MODE) {
+        ps2_mouse_respond(byte);
+        return;
+    }
+
+    if (byte != PS2_MOUSE_CMD_RESEND) {
+        ps2_queue_flush(&ps2_mouse_port.queue, NULL);
+    }
+    ps2_mouse_handle_command(byte);
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+void ps2_mouse_init(uint8_t clk_pin, uint8_t data_pin) {
+    ps2_bus_init(&ps2_mouse_port, clk_pin, data_pin);
+    ps2_mouse_reset();
+    ps2_mouse_motion.buttons = 0;
+    ps2_mouse_motion.next_us = ps2_micros();
+
+    uprintf("[PS2] Mouse initialized on CLK=%d, DATA=%d\n", clk_pin, data_pin);
+
+    // Power-on self test result, as a mouse that was just plugged in sends
+    ps2_mouse_respond(PS2_BAT_SUCCESS);
+    ps2_mouse_respond(PS2_MOUSE_ID_STANDARD);
+}
+
+void ps2_mouse_task(void) {
+    // A packet that is due gets queued first so the service below starts it
+    ps2_mouse_stream_task();
+    ps2_bus_service(&ps2_mouse_port, ps2_mouse_received);
+}
+
+bool ps2_mouse_is_idle(void) {
+    return ps2_bus_is_idle(&ps2_mouse_port);
+}
+
+void ps2_mouse_set_host_present(bool present) {
+    ps2_queue_flush(&ps2_mouse_port.queue, NULL);
+    ps2_mouse_reset();
+    if (present) {
+        uprintf("[PS2] Mouse host connected\n");
+        ps2_mouse_respond(PS2_BAT_SUCCESS);
+        ps2_mouse_respond(PS2_MOUSE_ID_STANDARD);
+    } else {
+        uprintf("[PS2] Mouse host gone\n");
+    }
+}
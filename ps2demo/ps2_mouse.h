@@ -1,9 +1,56 @@
-// ps2_mouse.h
+// ps2_mouse.h - PS/2 mouse device on its own port
 #ifndef PS2_MOUSE_H
 #define PS2_MOUSE_H
 
+#include <stdint.h>
+#include <stdbool.h>
+#include "report.h"  // For report_mouse_t
+#include "ps2_bus.h"
+
+extern ps2_port_t ps2_mouse_port;  // Mouse bus (host detection probes it)
+
+// PS/2 Commands from host (mouse only; Reset, Resend, Set Defaults, Enable,
+// Disable and Set Sample Rate share their codes with the keyboard)
+#define PS2_MOUSE_CMD_SET_SCALING_1_1  0xE6
+#define PS2_MOUSE_CMD_SET_SCALING_2_1  0xE7
+#define PS2_MOUSE_CMD_SET_RESOLUTION   0xE8
+#define PS2_MOUSE_CMD_STATUS_REQUEST   0xE9
+#define PS2_MOUSE_CMD_SET_STREAM_MODE  0xEA
+#define PS2_MOUSE_CMD_READ_DATA        0xEB
+#define PS2_MOUSE_CMD_RESET_WRAP_MODE  0xEC
+#define PS2_MOUSE_CMD_SET_WRAP_MODE    0xEE
+#define PS2_MOUSE_CMD_SET_REMOTE_MODE  0xF0
+#define PS2_MOUSE_CMD_GET_DEVICE_ID    0xF2
+#define PS2_MOUSE_CMD_SET_SAMPLE_RATE  0xF3
+#define PS2_MOUSE_CMD_ENABLE           0xF4
+#define PS2_MOUSE_CMD_DISABLE          0xF5
+#define PS2_MOUSE_CMD_SET_DEFAULTS     0xF6
+#define PS2_MOUSE_CMD_RESEND           0xFE
+#define PS2_MOUSE_CMD_RESET            0xFF
+
+// Device IDs: plain 3-byte mouse, IntelliMouse (wheel) and IntelliMouse
+// Explorer (wheel + buttons 4/5), unlocked by sample rate sequences
+#define PS2_MOUSE_ID_STANDARD          0x00
+#define PS2_MOUSE_ID_WHEEL             0x03
+#define PS2_MOUSE_ID_FIVE_BUTTON       0x04
+
+// Release the lines, power-on self test (sends AA 00) and wait for the host
 void ps2_mouse_init(uint8_t clk_pin, uint8_t data_pin);
+
+// Keep the mouse bus moving and send a movement packet when one is due.
+// Call from the main loop while in PS/2 mode.
 void ps2_mouse_task(void);
-void ps2_mouse_send_packet(int8_t x, int8_t y, uint8_t buttons);
+
+// Movement from QMK. Reports are added up and sent as one packet per
+// sample period the host asked for.
+void ps2_mouse_report(const report_mouse_t *report);
+void ps2_mouse_send_packet(int8_t x, int8_t y, uint8_t buttons);  // PS/2 directions (Y up)
+
+// Nothing on the wire and nothing queued
+bool ps2_mouse_is_idle(void);
+
+// Host detection: a new host gets the BAT, a lost one takes the mouse back
+// to its power-on state
+void ps2_mouse_set_host_present(bool present);
 
 #endif // PS2_MOUSE_H
@@ -0,0 +1,233 @@
+// ps2_queue.c - Packet-level PS/2 send queue
+//
+// Each priority class has a list of packets in send order, and the engine
+// takes the head of the highest class that has any. A packet may not
+// overtake anything of the same or a higher priority, anything for the same
+// key, or any modifier change (moving a key across a modifier change would
+// change what the host types). Everything else it jumps, so e.g. a key
+// release is not stuck behind a run of presses, and a command response only
+// waits for other responses. The class order breaks that rule only for a
+// release or modifier change that arrives while the make list holds
+// something it may not overtake; it goes to the end of the make list
+// instead. Counts of what the make list holds decide that, so every push
+// and pop takes the same few steps under the lock however full the queue is.
+#include "ps2_queue.h"
+#include "quantum.h"
+#include <string.h>
+
+#if defined(PROTOCOL_CHIBIOS)
+#include <ch.h>
+#define PS2_QUEUE_LOCK()   chSysLock()
+#define PS2_QUEUE_UNLOCK() chSysUnlock()
+#else
+#define PS2_QUEUE_LOCK()
+#define PS2_QUEUE_UNLOCK()
+#endif
+
+static inline uint8_t queue_key_slot(uint16_t key) {
+    return (uint8_t)(key ^ (key >> 8));
+}
+
+// Where a packet goes: its own class, unless the make list holds something
+// it may not overtake. Then it waits at the end of the make list, which
+// also keeps everything that may not overtake it behind it.
+static ps2_priority_t queue_list_for(const ps2_queue_t *queue, const ps2_packet_t *packet) {
+    if (packet->priority != PS2_PRIO_BREAK || queue->lists[PS2_PRIO_MAKE].count == 0) {
+        return packet->priority;
+    }
+    if ((packet->flags & PS2_PACKET_MODIFIER) || queue->make_demoted || queue->make_modifiers) {
+        return PS2_PRIO_MAKE;
+    }
+    if (packet->key != 0 && queue->make_keys[queue_key_slot(packet->key)]) {
+        return PS2_PRIO_MAKE;
+    }
+    return PS2_PRIO_BREAK;
+}
+
+// Count a packet in or out of the make list
+static void queue_make_list_note(ps2_queue_t *queue, const ps2_packet_t *packet, int8_t delta) {
+    if (packet->priority < PS2_PRIO_MAKE) {
+        queue->make_demoted += delta;
+    }
+    if (packet->flags & PS2_PACKET_MODIFIER) {
+        queue->make_modifiers += delta;
+    }
+    if (packet->key != 0) {
+        queue->make_keys[queue_key_slot(packet->key)] += delta;
+    }
+}
+
+// Take a slot off the free list and fill it. The queue must not be full.
+static ps2_queue_index_t queue_slot_take(ps2_queue_t *queue, const ps2_packet_t *packet) {
+    ps2_queue_index_t slot = queue->free;
+    queue->free = queue->next[slot];
+    queue->packets[slot] = *packet;
+    queue->pending[packet->priority]++;
+    queue->count++;
+    if (queue->count > queue->high_water) {
+        queue->high_water = queue->count;
+    }
+    return slot;
+}
+
+// Hand a whole list's slots back (its packets are no longer counted)
+static void queue_list_release(ps2_queue_t *queue, const ps2_queue_list_t *list) {
+    if (list->count == 0) {
+        return;
+    }
+    queue->next[list->tail] = queue->free;
+    queue->free = list->head;
+}
+
+void ps2_queue_clear(ps2_queue_t *queue) {
+    PS2_QUEUE_LOCK();
+    memset(queue->lists, 0, sizeof(queue->lists));
+    memset(queue->pending, 0, sizeof(queue->pending));
+    memset(queue->make_keys, 0, sizeof(queue->make_keys));
+    queue->make_demoted = 0;
+    queue->make_modifiers = 0;
+    for (ps2_queue_index_t slot = 0; slot < PS2_QUEUE_SIZE - 1; slot++) {
+        queue->next[slot] = slot + 1;
+    }
+    queue->free = 0;
+    queue->count = 0;
+    PS2_QUEUE_UNLOCK();
+}
+
+void ps2_queue_flush(ps2_queue_t *queue, void (*discarded)(const ps2_packet_t *packet)) {
+    ps2_queue_list_t dropped[3];  // Break, make and repeat lists
+
+    // Unhook the lists; their slots stay out of use until handed back below
+    PS2_QUEUE_LOCK();
+    for (uint8_t i = 0; i < 3; i++) {
+        dropped[i] = queue->lists[PS2_PRIO_BREAK + i];
+        queue->lists[PS2_PRIO_BREAK + i].count = 0;
+        queue->count -= dropped[i].count;
+    }
+    queue->pending[PS2_PRIO_BREAK] -= dropped[0].count + queue->make_demoted;
+    queue->pending[PS2_PRIO_MAKE] -= dropped[1].count - queue->make_demoted;
+    queue->pending[PS2_PRIO_REPEAT] -= dropped[2].count;
+    queue->make_demoted = 0;
+    queue->make_modifiers = 0;
+    PS2_QUEUE_UNLOCK();
+
+    // Only the main loop pushes, and the engine pops nothing from the
+    // (now empty) make list, so the per-key counts can be cleared unlocked
+    memset(queue->make_keys, 0, sizeof(queue->make_keys));
+    for (uint8_t i = 0; i < 3 && discarded; i++) {
+        ps2_queue_index_t slot = dropped[i].head;
+        for (ps2_queue_index_t n = 0; n < dropped[i].count; n++) {
+            discarded(&queue->packets[slot]);
+            slot = queue->next[slot];
+        }
+    }
+
+    PS2_QUEUE_LOCK();
+    for (uint8_t i = 0; i < 3; i++) {
+        queue_list_release(queue, &dropped[i]);
+    }
+    PS2_QUEUE_UNLOCK();
+}
+
+bool ps2_queue_push(ps2_queue_t *queue, const ps2_packet_t *packet) {
+    if (packet->len == 0 || packet->len > PS2_PACKET_MAX_BYTES || packet->priority > PS2_PRIO_REPEAT) {
+        return false;
+    }
+
+    PS2_QUEUE_LOCK();
+
+    // Pending repeats go stale as soon as any key changes state
+    if (packet->priority == PS2_PRIO_BREAK || packet->priority == PS2_PRIO_MAKE) {
+        ps2_queue_list_t *repeats = &queue->lists[PS2_PRIO_REPEAT];
+        queue_list_release(queue, repeats);
+        queue->count -= repeats->count;
+        queue->pending[PS2_PRIO_REPEAT] -= repeats->count;
+        repeats->count = 0;
+    }
+
+    if (queue->count >= PS2_QUEUE_SIZE) {
+        PS2_QUEUE_UNLOCK();
+        return false;
+    }
+
+    ps2_queue_list_t *list = &queue->lists[queue_list_for(queue, packet)];
+    ps2_queue_index_t slot = queue_slot_take(queue, packet);
+#if PS2_STATS_ENABLE
+    queue->packets[slot].queued_us = ps2_stats_now();
+#endif
+    if (list == &queue->lists[PS2_PRIO_MAKE]) {
+        queue_make_list_note(queue, packet, 1);
+    }
+    if (list->count == 0) {
+        list->head = slot;
+    } else {
+        queue->next[list->tail] = slot;
+    }
+    list->tail = slot;
+    list->count++;
+    PS2_QUEUE_UNLOCK();
+
+    return true;
+}
+
+bool ps2_queue_pop(ps2_queue_t *queue, ps2_packet_t *packet) {
+    if (queue->count == 0) {
+        return false;
+    }
+
+    ps2_priority_t priority = PS2_PRIO_RESPONSE;
+    while (queue->lists[priority].count == 0) {
+        priority++;
+    }
+    ps2_queue_list_t *list = &queue->lists[priority];
+    ps2_queue_index_t slot = list->head;
+    *packet = queue->packets[slot];
+    list->head = queue->next[slot];
+    list->count--;
+
+    if (priority == PS2_PRIO_MAKE) {
+        queue_make_list_note(queue, packet, -1);
+    }
+    queue->pending[packet->priority]--;
+    queue->next[slot] = queue->free;
+    queue->free = slot;
+    queue->count--;
+    return true;
+}
+
+// Goes to the head of the response list, which is sent before anything else
+bool ps2_queue_push_front(ps2_queue_t *queue, const ps2_packet_t *packet) {
+    if (queue->count >= PS2_QUEUE_SIZE) {
+        return false;
+    }
+    ps2_queue_list_t *list = &queue->lists[PS2_PRIO_RESPONSE];
+    ps2_queue_index_t slot = queue_slot_take(queue, packet);
+    if (list->count == 0) {
+        list->tail = slot;
+    } else {
+        queue->next[slot] = list->head;
+    }
+    list->head = slot;
+    list->count++;
+    return true;
+}
+
+bool ps2_queue_is_empty(const ps2_queue_t *queue) {
+    return queue->count == 0;
+}
+
+bool ps2_queue_has_pending(ps2_queue_t *queue, ps2_priority_t priority) {
+    return priority <= PS2_PRIO_REPEAT && queue->pending[priority] != 0;
+}
+
+ps2_queue_index_t ps2_queue_free(const ps2_queue_t *queue) {
+    return PS2_QUEUE_SIZE - queue->count;
+}
+
+ps2_queue_index_t ps2_queue_high_water(const ps2_queue_t *queue) {
+    return queue->high_water;
+}
+
+void ps2_queue_reset_high_water(ps2_queue_t *queue) {
+    queue->high_water = queue->count;
+}
@@ -0,0 +1,104 @@
+// ps2_queue.h - Packet-level PS/2 send queue
+#ifndef PS2_QUEUE_H
+#define PS2_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ps2_stats.h"
+
+// Pause (E1 14 77 E1 F0 14 F0 77) is the longest sequence
+#define PS2_PACKET_MAX_BYTES 8
+
+// Number of packets the queue holds. Each one is a whole sequence, so 64
+// covers a full report change with room to spare; key events that don't fit
+// wait in the keyboard's backlog rather than drop, so this only sets how far
+// ahead of it the engine can run.
+#ifndef PS2_QUEUE_SIZE
+#define PS2_QUEUE_SIZE 64
+#endif
+
+#if PS2_QUEUE_SIZE < 4 || PS2_QUEUE_SIZE > 65535
+#error "PS2_QUEUE_SIZE must be between 4 and 65535"
+#endif
+
+typedef uint16_t ps2_queue_index_t;
+
+// Priority classes, highest first
+typedef enum {
+    PS2_PRIO_RESPONSE,  // Command responses (ACK, ID, BAT...)
+    PS2_PRIO_BREAK,     // Key releases and modifier changes
+    PS2_PRIO_MAKE,      // Key presses
+    PS2_PRIO_REPEAT     // Typematic repeats
+} ps2_priority_t;
+
+// Packet flags
+#define PS2_PACKET_MODIFIER 0x01  // Changes the meaning of other keys
+#define PS2_PACKET_RELEASE  0x02  // Break (not make) for keycode
+
+// One complete scancode sequence. It is queued and sent back to back; if the
+// host cuts a byte off, the engine puts the rest back at the head of the
+// queue, so the host still sees every byte once and in order.
+typedef struct {
+    uint8_t len;
+    uint8_t priority;   // ps2_priority_t
+    uint8_t flags;
+    uint8_t keycode;    // QMK keycode it makes/breaks, KC_NO = untracked
+    uint16_t key;       // Key identity (scancode | E0 << 8), 0 = none
+    uint8_t bytes[PS2_PACKET_MAX_BYTES];
+#if PS2_STATS_ENABLE
+    uint32_t origin_us; // Keystroke start (ps2_stats_now()), 0 = none
+    uint32_t queued_us; // Set by ps2_queue_push()
+#endif
+} ps2_packet_t;
+
+// One send-order list of packets per priority class. A packet that may not
+// overtake something in the make list goes to the end of that list instead
+// of its own (see ps2_queue.c).
+typedef struct {
+    ps2_queue_index_t head;   // Next to send
+    ps2_queue_index_t tail;   // Newest
+    ps2_queue_index_t count;
+} ps2_queue_list_t;
+
+// Key identities are hashed to a byte to count the make list's packets per
+// key. Two keys sharing a count only ever keep a packet in order needlessly.
+#define PS2_QUEUE_KEY_SLOTS 256
+
+// One queue per port. Only ever touched through the functions below.
+typedef struct {
+    ps2_packet_t packets[PS2_QUEUE_SIZE];
+    ps2_queue_index_t next[PS2_QUEUE_SIZE];   // Following slot in its list
+    ps2_queue_list_t lists[PS2_PRIO_REPEAT + 1];
+    ps2_queue_index_t free;                   // Unused slots, linked by next
+    volatile ps2_queue_index_t count;
+    ps2_queue_index_t pending[PS2_PRIO_REPEAT + 1];  // Packets per priority
+    ps2_queue_index_t make_demoted;           // Make list: higher-priority packets
+    ps2_queue_index_t make_modifiers;         // Make list: modifier changes
+    ps2_queue_index_t make_keys[PS2_QUEUE_KEY_SLOTS];  // Make list: packets per key
+    ps2_queue_index_t high_water;
+} ps2_queue_t;
+
+void ps2_queue_clear(ps2_queue_t *queue);
+
+// Drop every queued packet except command responses and packets the engine
+// put back. discarded (may be NULL) is called for each one in send order,
+// with the queue unlocked.
+void ps2_queue_flush(ps2_queue_t *queue, void (*discarded)(const ps2_packet_t *packet));
+bool ps2_queue_push(ps2_queue_t *queue, const ps2_packet_t *packet);
+bool ps2_queue_is_empty(const ps2_queue_t *queue);
+bool ps2_queue_has_pending(ps2_queue_t *queue, ps2_priority_t priority);  // Any packet of this class queued?
+ps2_queue_index_t ps2_queue_free(const ps2_queue_t *queue);
+
+// Deepest the queue has been since the last reset
+ps2_queue_index_t ps2_queue_high_water(const ps2_queue_t *queue);
+void ps2_queue_reset_high_water(ps2_queue_t *queue);
+
+// Transmit engine side: must be called with the bus lock held (or from the
+// timer callback)
+bool ps2_queue_pop(ps2_queue_t *queue, ps2_packet_t *packet);
+
+// Put a packet the engine took back in front of everything else. Fails only
+// if the queue filled up in the meantime.
+bool ps2_queue_push_front(ps2_queue_t *queue, const ps2_packet_t *packet);
+
+#endif // PS2_QUEUE_H
@@ -0,0 +1,611 @@
+// ps2_scancode_tables_gen.h - Dense scancode lookup tables
+// GENERATED by gen_scancodes.py from ps2_keys.def - do not edit
+// Only ps2_scancodes.c includes this file.
+#ifndef PS2_SCANCODE_TABLES_GEN_H
+#define PS2_SCANCODE_TABLES_GEN_H
+
+// QMK keycode -> packed Set 2 entry (see ps2_scancodes.h)
+static const uint8_t ps2_set2_table[256] = {
+    [KC_A]                = 0x1C,  // A
+    [KC_B]                = 0x32,  // B
+    [KC_C]                = 0x21,  // C
+    [KC_D]                = 0x23,  // D
+    [KC_E]                = 0x24,  // E
+    [KC_F]                = 0x2B,  // F
+    [KC_G]                = 0x34,  // G
+    [KC_H]                = 0x33,  // H
+    [KC_I]                = 0x43,  // I
+    [KC_J]                = 0x3B,  // J
+    [KC_K]                = 0x42,  // K
+    [KC_L]                = 0x4B,  // L
+    [KC_M]                = 0x3A,  // M
+    [KC_N]                = 0x31,  // N
+    [KC_O]                = 0x44,  // O
+    [KC_P]                = 0x4D,  // P
+    [KC_Q]                = 0x15,  // Q
+    [KC_R]                = 0x2D,  // R
+    [KC_S]                = 0x1B,  // S
+    [KC_T]                = 0x2C,  // T
+    [KC_U]                = 0x3C,  // U
+    [KC_V]                = 0x2A,  // V
+    [KC_W]                = 0x1D,  // W
+    [KC_X]                = 0x22,  // X
+    [KC_Y]                = 0x35,  // Y
+    [KC_Z]                = 0x1A,  // Z
+    [KC_1]                = 0x16,  // 1
+    [KC_2]                = 0x1E,  // 2
+    [KC_3]                = 0x26,  // 3
+    [KC_4]                = 0x25,  // 4
+    [KC_5]                = 0x2E,  // 5
+    [KC_6]                = 0x36,  // 6
+    [KC_7]                = 0x3D,  // 7
+    [KC_8]                = 0x3E,  // 8
+    [KC_9]                = 0x46,  // 9
+    [KC_0]                = 0x45,  // 0
+    [KC_F1]               = 0x05,  // F1
+    [KC_F2]               = 0x06,  // F2
+    [KC_F3]               = 0x04,  // F3
+    [KC_F4]               = 0x0C,  // F4
+    [KC_F5]               = 0x03,  // F5
+    [KC_F6]               = 0x0B,  // F6
+    [KC_F7]               = 0x81,  // F7
+    [KC_F8]               = 0x0A,  // F8
+    [KC_F9]               = 0x01,  // F9
+    [KC_F10]              = 0x09,  // F10
+    [KC_F11]              = 0x78,  // F11
+    [KC_F12]              = 0x07,  // F12
+    [KC_F13]              = 0x08,  // F13
+    [KC_F14]              = 0x10,  // F14
+    [KC_F15]              = 0x18,  // F15
+    [KC_F16]              = 0x20,  // F16
+    [KC_F17]              = 0x28,  // F17
+    [KC_F18]              = 0x30,  // F18
+    [KC_F19]              = 0x38,  // F19
+    [KC_F20]              = 0x40,  // F20
+    [KC_F21]              = 0x48,  // F21
+    [KC_F22]              = 0x50,  // F22
+    [KC_F23]              = 0x57,  // F23
+    [KC_F24]              = 0x5F,  // F24
+    [KC_GRAVE]            = 0x0E,  // GRAVE
+    [KC_MINUS]            = 0x4E,  // MINUS
+    [KC_EQUAL]            = 0x55,  // EQUAL
+    [KC_LBRC]             = 0x54,  // LBRACKET
+    [KC_RBRC]             = 0x5B,  // RBRACKET
+    [KC_BSLS]             = 0x5D,  // BACKSLASH
+    [KC_SCLN]             = 0x4C,  // SEMICOLON
+    [KC_QUOTE]            = 0x52,  // QUOTE
+    [KC_COMMA]            = 0x41,  // COMMA
+    [KC_DOT]              = 0x49,  // DOT
+    [KC_SLASH]            = 0x4A,  // SLASH
+    [KC_ESCAPE]           = 0x76,  // ESC
+    [KC_BSPC]             = 0x66,  // BACKSPACE
+    [KC_TAB]              = 0x0D,  // TAB
+    [KC_CAPS]             = 0x58,  // CAPS
+    [KC_ENTER]            = 0x5A,  // ENTER
+    [KC_SPACE]            = 0x29,  // SPACE
+    [KC_LCTL]             = 0x14,  // LCTRL
+    [KC_LSFT]             = 0x12,  // LSHIFT
+    [KC_LALT]             = 0x11,  // LALT
+    [KC_LGUI]             = 0x9F,  // LGUI
+    [KC_RCTL]             = 0x94,  // RCTRL
+    [KC_RSFT]             = 0x59,  // RSHIFT
+    [KC_RALT]             = 0x91,  // RALT
+    [KC_RGUI]             = 0xA7,  // RGUI
+    [KC_APPLICATION]      = 0xAF,  // MENU
+    [KC_INSERT]           = 0xF0,  // INSERT
+    [KC_HOME]             = 0xEC,  // HOME
+    [KC_PGUP]             = 0xFD,  // PGUP
+    [KC_DELETE]           = 0xF1,  // DELETE
+    [KC_END]              = 0xE9,  // END
+    [KC_PGDN]             = 0xFA,  // PGDN
+    [KC_UP]               = 0xF5,  // UP
+    [KC_DOWN]             = 0xF2,  // DOWN
+    [KC_LEFT]             = 0xEB,  // LEFT
+    [KC_RIGHT]            = 0xF4,  // RIGHT
+    [KC_NUM]              = 0x77,  // NUMLOCK
+    [KC_KP_SLASH]         = 0xCA,  // KP_SLASH
+    [KC_KP_ASTERISK]      = 0x7C,  // KP_ASTERISK
+    [KC_KP_MINUS]         = 0x7B,  // KP_MINUS
+    [KC_KP_PLUS]          = 0x79,  // KP_PLUS
+    [KC_KP_ENTER]         = 0xDA,  // KP_ENTER
+    [KC_KP_DOT]           = 0x71,  // KP_DOT
+    [KC_KP_0]             = 0x70,  // KP_0
+    [KC_KP_1]             = 0x69,  // KP_1
+    [KC_KP_2]             = 0x72,  // KP_2
+    [KC_KP_3]             = 0x7A,  // KP_3
+    [KC_KP_4]             = 0x6B,  // KP_4
+    [KC_KP_5]             = 0x73,  // KP_5
+    [KC_KP_6]             = 0x74,  // KP_6
+    [KC_KP_7]             = 0x6C,  // KP_7
+    [KC_KP_8]             = 0x75,  // KP_8
+    [KC_KP_9]             = 0x7D,  // KP_9
+    [KC_SCRL]             = 0x7E,  // SCROLL
+    [KC_PSCR]             = 0x82,  // PSCREEN
+    [KC_PAUSE]            = 0x83,  // PAUSE
+    [KC_AUDIO_MUTE]       = 0xA3,  // MUTE
+    [KC_AUDIO_VOL_UP]     = 0xB2,  // VOLUMEUP
+    [KC_AUDIO_VOL_DOWN]   = 0xA1,  // VOLUMEDOWN
+    [KC_MEDIA_NEXT_TRACK] = 0xCD,  // MEDIA_NEXT
+    [KC_MEDIA_PREV_TRACK] = 0x95,  // MEDIA_PREV
+    [KC_MEDIA_STOP]       = 0xBB,  // MEDIA_STOP
+    [KC_MEDIA_PLAY_PAUSE] = 0xB4,  // MEDIA_PLAY
+    [KC_MEDIA_SELECT]     = 0xD0,  // MEDIA_SELECT
+    [KC_WWW_SEARCH]       = 0x90,  // WWW_SEARCH
+    [KC_WWW_HOME]         = 0xBA,  // WWW_HOME
+    [KC_WWW_BACK]         = 0xB8,  // WWW_BACK
+    [KC_WWW_FORWARD]      = 0xB0,  // WWW_FORWARD
+    [KC_WWW_STOP]         = 0xA8,  // WWW_STOP
+    [KC_WWW_REFRESH]      = 0xA0,  // WWW_REFRESH
+    [KC_WWW_FAVORITES]    = 0x98,  // WWW_FAVORITES
+    [KC_MAIL]             = 0xC8,  // APP_MAIL
+    [KC_CALCULATOR]       = 0xAB,  // APP_CALC
+    [KC_MY_COMPUTER]      = 0xC0,  // APP_MYCOMP
+    [KC_SYSTEM_POWER]     = 0xB7,  // POWER
+    [KC_SYSTEM_SLEEP]     = 0xBF,  // SLEEP
+    [KC_SYSTEM_WAKE]      = 0xDE,  // WAKE
+    [KC_INT1]             = 0x51,  // INTL1
+    [KC_INT2]             = 0x13,  // INTL2
+    [KC_INT3]             = 0x6A,  // INTL3
+    [KC_INT4]             = 0x64,  // INTL4
+    [KC_INT5]             = 0x67,  // INTL5
+    [KC_INT6]             = 0x13,  // INTL6
+    [KC_LNG1]             = 0x84,  // LANG1
+    [KC_LNG2]             = 0x85,  // LANG2
+    [KC_LNG3]             = 0x63,  // LANG3
+    [KC_LNG4]             = 0x64,  // LANG4
+    [KC_LNG5]             = 0x67,  // LANG5
+};
+
+// Set 2 entries that do not fit the packed format
+static const ps2_mapping_t ps2_set2_escapes[PS2_SET2_ESCAPES] = {
+    [1] = {PS2_F7, false, PS2_KEY_NORMAL},
+    [2] = {PS2_PSCREEN, false, PS2_KEY_PRINTSCREEN},
+    [3] = {PS2_PAUSE, false, PS2_KEY_PAUSE},
+    [4] = {PS2_LANG1, false, PS2_KEY_MAKE_ONLY},
+    [5] = {PS2_LANG2, false, PS2_KEY_MAKE_ONLY},
+};
+
+// QMK keycode -> packed Set 1 entry (see ps2_scancodes.h)
+static const uint8_t ps2_set1_table[256] = {
+    [KC_A]                = 0x1E,  // A
+    [KC_B]                = 0x30,  // B
+    [KC_C]                = 0x2E,  // C
+    [KC_D]                = 0x20,  // D
+    [KC_E]                = 0x12,  // E
+    [KC_F]                = 0x21,  // F
+    [KC_G]                = 0x22,  // G
+    [KC_H]                = 0x23,  // H
+    [KC_I]                = 0x17,  // I
+    [KC_J]                = 0x24,  // J
+    [KC_K]                = 0x25,  // K
+    [KC_L]                = 0x26,  // L
+    [KC_M]                = 0x32,  // M
+    [KC_N]                = 0x31,  // N
+    [KC_O]                = 0x18,  // O
+    [KC_P]                = 0x19,  // P
+    [KC_Q]                = 0x10,  // Q
+    [KC_R]                = 0x13,  // R
+    [KC_S]                = 0x1F,  // S
+    [KC_T]                = 0x14,  // T
+    [KC_U]                = 0x16,  // U
+    [KC_V]                = 0x2F,  // V
+    [KC_W]                = 0x11,  // W
+    [KC_X]                = 0x2D,  // X
+    [KC_Y]                = 0x15,  // Y
+    [KC_Z]                = 0x2C,  // Z
+    [KC_1]                = 0x02,  // 1
+    [KC_2]                = 0x03,  // 2
+    [KC_3]                = 0x04,  // 3
+    [KC_4]                = 0x05,  // 4
+    [KC_5]                = 0x06,  // 5
+    [KC_6]                = 0x07,  // 6
+    [KC_7]                = 0x08,  // 7
+    [KC_8]                = 0x09,  // 8
+    [KC_9]                = 0x0A,  // 9
+    [KC_0]                = 0x0B,  // 0
+    [KC_F1]               = 0x3B,  // F1
+    [KC_F2]               = 0x3C,  // F2
+    [KC_F3]               = 0x3D,  // F3
+    [KC_F4]               = 0x3E,  // F4
+    [KC_F5]               = 0x3F,  // F5
+    [KC_F6]               = 0x40,  // F6
+    [KC_F7]               = 0x41,  // F7
+    [KC_F8]               = 0x42,  // F8
+    [KC_F9]               = 0x43,  // F9
+    [KC_F10]              = 0x44,  // F10
+    [KC_F11]              = 0x57,  // F11
+    [KC_F12]              = 0x58,  // F12
+    [KC_F13]              = 0x64,  // F13
+    [KC_F14]              = 0x65,  // F14
+    [KC_F15]              = 0x66,  // F15
+    [KC_F16]              = 0x67,  // F16
+    [KC_F17]              = 0x68,  // F17
+    [KC_F18]              = 0x69,  // F18
+    [KC_F19]              = 0x6A,  // F19
+    [KC_F20]              = 0x6B,  // F20
+    [KC_F21]              = 0x6C,  // F21
+    [KC_F22]              = 0x6D,  // F22
+    [KC_F23]              = 0x6E,  // F23
+    [KC_F24]              = 0x76,  // F24
+    [KC_GRAVE]            = 0x29,  // GRAVE
+    [KC_MINUS]            = 0x0C,  // MINUS
+    [KC_EQUAL]            = 0x0D,  // EQUAL
+    [KC_LBRC]             = 0x1A,  // LBRACKET
+    [KC_RBRC]             = 0x1B,  // RBRACKET
+    [KC_BSLS]             = 0x2B,  // BACKSLASH
+    [KC_SCLN]             = 0x27,  // SEMICOLON
+    [KC_QUOTE]            = 0x28,  // QUOTE
+    [KC_COMMA]            = 0x33,  // COMMA
+    [KC_DOT]              = 0x34,  // DOT
+    [KC_SLASH]            = 0x35,  // SLASH
+    [KC_ESCAPE]           = 0x01,  // ESC
+    [KC_BSPC]             = 0x0E,  // BACKSPACE
+    [KC_TAB]              = 0x0F,  // TAB
+    [KC_CAPS]             = 0x3A,  // CAPS
+    [KC_ENTER]            = 0x1C,  // ENTER
+    [KC_SPACE]            = 0x39,  // SPACE
+    [KC_LCTL]             = 0x1D,  // LCTRL
+    [KC_LSFT]             = 0x2A,  // LSHIFT
+    [KC_LALT]             = 0x38,  // LALT
+    [KC_LGUI]             = 0xDB,  // LGUI
+    [KC_RCTL]             = 0x9D,  // RCTRL
+    [KC_RSFT]             = 0x36,  // RSHIFT
+    [KC_RALT]             = 0xB8,  // RALT
+    [KC_RGUI]             = 0xDC,  // RGUI
+    [KC_APPLICATION]      = 0xDD,  // MENU
+    [KC_INSERT]           = 0xD2,  // INSERT
+    [KC_HOME]             = 0xC7,  // HOME
+    [KC_PGUP]             = 0xC9,  // PGUP
+    [KC_DELETE]           = 0xD3,  // DELETE
+    [KC_END]              = 0xCF,  // END
+    [KC_PGDN]             = 0xD1,  // PGDN
+    [KC_UP]               = 0xC8,  // UP
+    [KC_DOWN]             = 0xD0,  // DOWN
+    [KC_LEFT]             = 0xCB,  // LEFT
+    [KC_RIGHT]            = 0xCD,  // RIGHT
+    [KC_NUM]              = 0x45,  // NUMLOCK
+    [KC_KP_SLASH]         = 0xB5,  // KP_SLASH
+    [KC_KP_ASTERISK]      = 0x37,  // KP_ASTERISK
+    [KC_KP_MINUS]         = 0x4A,  // KP_MINUS
+    [KC_KP_PLUS]          = 0x4E,  // KP_PLUS
+    [KC_KP_ENTER]         = 0x9C,  // KP_ENTER
+    [KC_KP_DOT]           = 0x53,  // KP_DOT
+    [KC_KP_0]             = 0x52,  // KP_0
+    [KC_KP_1]             = 0x4F,  // KP_1
+    [KC_KP_2]             = 0x50,  // KP_2
+    [KC_KP_3]             = 0x51,  // KP_3
+    [KC_KP_4]             = 0x4B,  // KP_4
+    [KC_KP_5]             = 0x4C,  // KP_5
+    [KC_KP_6]             = 0x4D,  // KP_6
+    [KC_KP_7]             = 0x47,  // KP_7
+    [KC_KP_8]             = 0x48,  // KP_8
+    [KC_KP_9]             = 0x49,  // KP_9
+    [KC_SCRL]             = 0x46,  // SCROLL
+    [KC_PSCR]             = 0x81,  // PSCREEN
+    [KC_PAUSE]            = 0x82,  // PAUSE
+    [KC_AUDIO_MUTE]       = 0xA0,  // MUTE
+    [KC_AUDIO_VOL_UP]     = 0xB0,  // VOLUMEUP
+    [KC_AUDIO_VOL_DOWN]   = 0xAE,  // VOLUMEDOWN
+    [KC_MEDIA_NEXT_TRACK] = 0x99,  // MEDIA_NEXT
+    [KC_MEDIA_PREV_TRACK] = 0x90,  // MEDIA_PREV
+    [KC_MEDIA_STOP]       = 0xA4,  // MEDIA_STOP
+    [KC_MEDIA_PLAY_PAUSE] = 0xA2,  // MEDIA_PLAY
+    [KC_MEDIA_SELECT]     = 0xED,  // MEDIA_SELECT
+    [KC_WWW_SEARCH]       = 0xE5,  // WWW_SEARCH
+    [KC_WWW_HOME]         = 0xB2,  // WWW_HOME
+    [KC_WWW_BACK]         = 0xEA,  // WWW_BACK
+    [KC_WWW_FORWARD]      = 0xE9,  // WWW_FORWARD
+    [KC_WWW_STOP]         = 0xE8,  // WWW_STOP
+    [KC_WWW_REFRESH]      = 0xE7,  // WWW_REFRESH
+    [KC_WWW_FAVORITES]    = 0xE6,  // WWW_FAVORITES
+    [KC_MAIL]             = 0xEC,  // APP_MAIL
+    [KC_CALCULATOR]       = 0xA1,  // APP_CALC
+    [KC_MY_COMPUTER]      = 0xEB,  // APP_MYCOMP
+    [KC_SYSTEM_POWER]     = 0xDE,  // POWER
+    [KC_SYSTEM_SLEEP]     = 0xDF,  // SLEEP
+    [KC_SYSTEM_WAKE]      = 0xE3,  // WAKE
+    [KC_INT1]             = 0x73,  // INTL1
+    [KC_INT2]             = 0x70,  // INTL2
+    [KC_INT3]             = 0x7D,  // INTL3
+    [KC_INT4]             = 0x79,  // INTL4
+    [KC_INT5]             = 0x7B,  // INTL5
+    [KC_INT6]             = 0x70,  // INTL6
+    [KC_LNG1]             = 0x83,  // LANG1
+    [KC_LNG2]             = 0x84,  // LANG2
+    [KC_LNG4]             = 0x79,  // LANG4
+    [KC_LNG5]             = 0x7B,  // LANG5
+};
+
+// Set 1 entries that do not fit the packed format
+static const ps2_mapping_t ps2_set1_escapes[PS2_SET1_ESCAPES] = {
+    [1] = {0x37, false, PS2_KEY_PRINTSCREEN},
+    [2] = {0x45, false, PS2_KEY_PAUSE},
+    [3] = {0xF2, false, PS2_KEY_MAKE_ONLY},
+    [4] = {0xF1, false, PS2_KEY_MAKE_ONLY},
+};
+
+// QMK keycode -> Set 3 make code (no prefixes, nothing to pack)
+static const uint8_t ps2_set3_table[256] = {
+    [KC_A]                = 0x1C,  // A
+    [KC_B]                = 0x32,  // B
+    [KC_C]                = 0x21,  // C
+    [KC_D]                = 0x23,  // D
+    [KC_E]                = 0x24,  // E
+    [KC_F]                = 0x2B,  // F
+    [KC_G]                = 0x34,  // G
+    [KC_H]                = 0x33,  // H
+    [KC_I]                = 0x43,  // I
+    [KC_J]                = 0x3B,  // J
+    [KC_K]                = 0x42,  // K
+    [KC_L]                = 0x4B,  // L
+    [KC_M]                = 0x3A,  // M
+    [KC_N]                = 0x31,  // N
+    [KC_O]                = 0x44,  // O
+    [KC_P]                = 0x4D,  // P
+    [KC_Q]                = 0x15,  // Q
+    [KC_R]                = 0x2D,  // R
+    [KC_S]                = 0x1B,  // S
+    [KC_T]                = 0x2C,  // T
+    [KC_U]                = 0x3C,  // U
+    [KC_V]                = 0x2A,  // V
+    [KC_W]                = 0x1D,  // W
+    [KC_X]                = 0x22,  // X
+    [KC_Y]                = 0x35,  // Y
+    [KC_Z]                = 0x1A,  // Z
+    [KC_1]                = 0x16,  // 1
+    [KC_2]                = 0x1E,  // 2
+    [KC_3]                = 0x26,  // 3
+    [KC_4]                = 0x25,  // 4
+    [KC_5]                = 0x2E,  // 5
+    [KC_6]                = 0x36,  // 6
+    [KC_7]                = 0x3D,  // 7
+    [KC_8]                = 0x3E,  // 8
+    [KC_9]                = 0x46,  // 9
+    [KC_0]                = 0x45,  // 0
+    [KC_F1]               = 0x07,  // F1
+    [KC_F2]               = 0x0F,  // F2
+    [KC_F3]               = 0x17,  // F3
+    [KC_F4]               = 0x1F,  // F4
+    [KC_F5]               = 0x27,  // F5
+    [KC_F6]               = 0x2F,  // F6
+    [KC_F7]               = 0x37,  // F7
+    [KC_F8]               = 0x3F,  // F8
+    [KC_F9]               = 0x47,  // F9
+    [KC_F10]              = 0x4F,  // F10
+    [KC_F11]              = 0x56,  // F11
+    [KC_F12]              = 0x5E,  // F12
+    [KC_GRAVE]            = 0x0E,  // GRAVE
+    [KC_MINUS]            = 0x4E,  // MINUS
+    [KC_EQUAL]            = 0x55,  // EQUAL
+    [KC_LBRC]             = 0x54,  // LBRACKET
+    [KC_RBRC]             = 0x5B,  // RBRACKET
+    [KC_BSLS]             = 0x5C,  // BACKSLASH
+    [KC_SCLN]             = 0x4C,  // SEMICOLON
+    [KC_QUOTE]            = 0x52,  // QUOTE
+    [KC_COMMA]            = 0x41,  // COMMA
+    [KC_DOT]              = 0x49,  // DOT
+    [KC_SLASH]            = 0x4A,  // SLASH
+    [KC_ESCAPE]           = 0x08,  // ESC
+    [KC_BSPC]             = 0x66,  // BACKSPACE
+    [KC_TAB]              = 0x0D,  // TAB
+    [KC_CAPS]             = 0x14,  // CAPS
+    [KC_ENTER]            = 0x5A,  // ENTER
+    [KC_SPACE]            = 0x29,  // SPACE
+    [KC_LCTL]             = 0x11,  // LCTRL
+    [KC_LSFT]             = 0x12,  // LSHIFT
+    [KC_LALT]             = 0x19,  // LALT
+    [KC_LGUI]             = 0x8B,  // LGUI
+    [KC_RCTL]             = 0x58,  // RCTRL
+    [KC_RSFT]             = 0x59,  // RSHIFT
+    [KC_RALT]             = 0x39,  // RALT
+    [KC_RGUI]             = 0x8C,  // RGUI
+    [KC_APPLICATION]      = 0x8D,  // MENU
+    [KC_INSERT]           = 0x67,  // INSERT
+    [KC_HOME]             = 0x6E,  // HOME
+    [KC_PGUP]             = 0x6F,  // PGUP
+    [KC_DELETE]           = 0x64,  // DELETE
+    [KC_END]              = 0x65,  // END
+    [KC_PGDN]             = 0x6D,  // PGDN
+    [KC_UP]               = 0x63,  // UP
+    [KC_DOWN]             = 0x60,  // DOWN
+    [KC_LEFT]             = 0x61,  // LEFT
+    [KC_RIGHT]            = 0x6A,  // RIGHT
+    [KC_NUM]              = 0x76,  // NUMLOCK
+    [KC_KP_SLASH]         = 0x77,  // KP_SLASH
+    [KC_KP_ASTERISK]      = 0x7E,  // KP_ASTERISK
+    [KC_KP_MINUS]         = 0x84,  // KP_MINUS
+    [KC_KP_PLUS]          = 0x7C,  // KP_PLUS
+    [KC_KP_ENTER]         = 0x79,  // KP_ENTER
+    [KC_KP_DOT]           = 0x71,  // KP_DOT
+    [KC_KP_0]             = 0x70,  // KP_0
+    [KC_KP_1]             = 0x69,  // KP_1
+    [KC_KP_2]             = 0x72,  // KP_2
+    [KC_KP_3]             = 0x7A,  // KP_3
+    [KC_KP_4]             = 0x6B,  // KP_4
+    [KC_KP_5]             = 0x73,  // KP_5
+    [KC_KP_6]             = 0x74,  // KP_6
+    [KC_KP_7]             = 0x6C,  // KP_7
+    [KC_KP_8]             = 0x75,  // KP_8
+    [KC_KP_9]             = 0x7D,  // KP_9
+    [KC_SCRL]             = 0x5F,  // SCROLL
+    [KC_PSCR]             = 0x57,  // PSCREEN
+    [KC_PAUSE]            = 0x62,  // PAUSE
+};
+
+// Consumer usage - PS2_USAGE_FIRST -> QMK keycode
+static const uint8_t ps2_usage_table[PS2_USAGE_LAST - PS2_USAGE_FIRST + 1] = {
+    [0x00B5 - PS2_USAGE_FIRST] = KC_MEDIA_NEXT_TRACK,
+    [0x00B6 - PS2_USAGE_FIRST] = KC_MEDIA_PREV_TRACK,
+    [0x00B7 - PS2_USAGE_FIRST] = KC_MEDIA_STOP,
+    [0x00CD - PS2_USAGE_FIRST] = KC_MEDIA_PLAY_PAUSE,
+    [0x00E2 - PS2_USAGE_FIRST] = KC_AUDIO_MUTE,
+    [0x00E9 - PS2_USAGE_FIRST] = KC_AUDIO_VOL_UP,
+    [0x00EA - PS2_USAGE_FIRST] = KC_AUDIO_VOL_DOWN,
+    [0x0183 - PS2_USAGE_FIRST] = KC_MEDIA_SELECT,
+    [0x018A - PS2_USAGE_FIRST] = KC_MAIL,
+    [0x0192 - PS2_USAGE_FIRST] = KC_CALCULATOR,
+    [0x0194 - PS2_USAGE_FIRST] = KC_MY_COMPUTER,
+    [0x0221 - PS2_USAGE_FIRST] = KC_WWW_SEARCH,
+    [0x0223 - PS2_USAGE_FIRST] = KC_WWW_HOME,
+    [0x0224 - PS2_USAGE_FIRST] = KC_WWW_BACK,
+    [0x0225 - PS2_USAGE_FIRST] = KC_WWW_FORWARD,
+    [0x0226 - PS2_USAGE_FIRST] = KC_WWW_STOP,
+    [0x0227 - PS2_USAGE_FIRST] = KC_WWW_REFRESH,
+    [0x022A - PS2_USAGE_FIRST] = KC_WWW_FAVORITES,
+};
+
+// Scancode -> QMK keycode, for decoders
+static const uint8_t ps2_reverse_plain[256] = {
+    [0x01] = KC_F9,
+    [0x03] = KC_F5,
+    [0x04] = KC_F3,
+    [0x05] = KC_F1,
+    [0x06] = KC_F2,
+    [0x07] = KC_F12,
+    [0x08] = KC_F13,
+    [0x09] = KC_F10,
+    [0x0A] = KC_F8,
+    [0x0B] = KC_F6,
+    [0x0C] = KC_F4,
+    [0x0D] = KC_TAB,
+    [0x0E] = KC_GRAVE,
+    [0x10] = KC_F14,
+    [0x11] = KC_LALT,
+    [0x12] = KC_LSFT,
+    [0x13] = KC_INT2,
+    [0x14] = KC_LCTL,
+    [0x15] = KC_Q,
+    [0x16] = KC_1,
+    [0x18] = KC_F15,
+    [0x1A] = KC_Z,
+    [0x1B] = KC_S,
+    [0x1C] = KC_A,
+    [0x1D] = KC_W,
+    [0x1E] = KC_2,
+    [0x20] = KC_F16,
+    [0x21] = KC_C,
+    [0x22] = KC_X,
+    [0x23] = KC_D,
+    [0x24] = KC_E,
+    [0x25] = KC_4,
+    [0x26] = KC_3,
+    [0x28] = KC_F17,
+    [0x29] = KC_SPACE,
+    [0x2A] = KC_V,
+    [0x2B] = KC_F,
+    [0x2C] = KC_T,
+    [0x2D] = KC_R,
+    [0x2E] = KC_5,
+    [0x30] = KC_F18,
+    [0x31] = KC_N,
+    [0x32] = KC_B,
+    [0x33] = KC_H,
+    [0x34] = KC_G,
+    [0x35] = KC_Y,
+    [0x36] = KC_6,
+    [0x38] = KC_F19,
+    [0x3A] = KC_M,
+    [0x3B] = KC_J,
+    [0x3C] = KC_U,
+    [0x3D] = KC_7,
+    [0x3E] = KC_8,
+    [0x40] = KC_F20,
+    [0x41] = KC_COMMA,
+    [0x42] = KC_K,
+    [0x43] = KC_I,
+    [0x44] = KC_O,
+    [0x45] = KC_0,
+    [0x46] = KC_9,
+    [0x48] = KC_F21,
+    [0x49] = KC_DOT,
+    [0x4A] = KC_SLASH,
+    [0x4B] = KC_L,
+    [0x4C] = KC_SCLN,
+    [0x4D] = KC_P,
+    [0x4E] = KC_MINUS,
+    [0x50] = KC_F22,
+    [0x51] = KC_INT1,
+    [0x52] = KC_QUOTE,
+    [0x54] = KC_LBRC,
+    [0x55] = KC_EQUAL,
+    [0x57] = KC_F23,
+    [0x58] = KC_CAPS,
+    [0x59] = KC_RSFT,
+    [0x5A] = KC_ENTER,
+    [0x5B] = KC_RBRC,
+    [0x5D] = KC_BSLS,
+    [0x5F] = KC_F24,
+    [0x63] = KC_LNG3,
+    [0x64] = KC_INT4,
+    [0x66] = KC_BSPC,
+    [0x67] = KC_INT5,
+    [0x69] = KC_KP_1,
+    [0x6A] = KC_INT3,
+    [0x6B] = KC_KP_4,
+    [0x6C] = KC_KP_7,
+    [0x70] = KC_KP_0,
+    [0x71] = KC_KP_DOT,
+    [0x72] = KC_KP_2,
+    [0x73] = KC_KP_5,
+    [0x74] = KC_KP_6,
+    [0x75] = KC_KP_8,
+    [0x76] = KC_ESCAPE,
+    [0x77] = KC_NUM,
+    [0x78] = KC_F11,
+    [0x79] = KC_KP_PLUS,
+    [0x7A] = KC_KP_3,
+    [0x7B] = KC_KP_MINUS,
+    [0x7C] = KC_KP_ASTERISK,
+    [0x7D] = KC_KP_9,
+    [0x7E] = KC_SCRL,
+    [0x83] = KC_F7,
+    [0xF1] = KC_LNG2,
+    [0xF2] = KC_LNG1,
+};
+
+static const uint8_t ps2_reverse_e0[128] = {
+    [0x10] = KC_WWW_SEARCH,
+    [0x11] = KC_RALT,
+    [0x14] = KC_RCTL,
+    [0x15] = KC_MEDIA_PREV_TRACK,
+    [0x18] = KC_WWW_FAVORITES,
+    [0x1F] = KC_LGUI,
+    [0x20] = KC_WWW_REFRESH,
+    [0x21] = KC_AUDIO_VOL_DOWN,
+    [0x23] = KC_AUDIO_MUTE,
+    [0x27] = KC_RGUI,
+    [0x28] = KC_WWW_STOP,
+    [0x2B] = KC_CALCULATOR,
+    [0x2F] = KC_APPLICATION,
+    [0x30] = KC_WWW_FORWARD,
+    [0x32] = KC_AUDIO_VOL_UP,
+    [0x34] = KC_MEDIA_PLAY_PAUSE,
+    [0x37] = KC_SYSTEM_POWER,
+    [0x38] = KC_WWW_BACK,
+    [0x3A] = KC_WWW_HOME,
+    [0x3B] = KC_MEDIA_STOP,
+    [0x3F] = KC_SYSTEM_SLEEP,
+    [0x40] = KC_MY_COMPUTER,
+    [0x48] = KC_MAIL,
+    [0x4A] = KC_KP_SLASH,
+    [0x4D] = KC_MEDIA_NEXT_TRACK,
+    [0x50] = KC_MEDIA_SELECT,
+    [0x5A] = KC_KP_ENTER,
+    [0x5E] = KC_SYSTEM_WAKE,
+    [0x69] = KC_END,
+    [0x6B] = KC_LEFT,
+    [0x6C] = KC_HOME,
+    [0x70] = KC_INSERT,
+    [0x71] = KC_DELETE,
+    [0x72] = KC_DOWN,
+    [0x74] = KC_RIGHT,
+    [0x75] = KC_UP,
+    [0x7A] = KC_PGDN,
+    [0x7C] = KC_PSCR,
+    [0x7D] = KC_PGUP,
+};
+
+// The only E1 sequence
+#define PS2_REVERSE_E1 KC_PAUSE
+
+#endif // PS2_SCANCODE_TABLES_GEN_H
@@ -0,0 +1,93 @@
+// ps2_scancodes.c - QMK keycode <-> PS/2 Scan Code Set 2 lookup
+#include "ps2_scancodes.h"
+#include "ps2_scancode_tables_gen.h"
+#include "report.h"
+
+static inline ps2_mapping_t ps2_unpack_mapping(uint8_t packed, const ps2_mapping_t *escapes, uint8_t escape_count) {
+    if (!(packed & PS2_PACKED_E0)) {
+        return (ps2_mapping_t){packed, false, PS2_KEY_NORMAL};
+    }
+
+    uint8_t code = packed & ~PS2_PACKED_E0;
+    if (code < escape_count) {
+        return escapes[code];
+    }
+    return (ps2_mapping_t){code, true, PS2_KEY_NORMAL};
+}
+
+ps2_mapping_t ps2_scancode_for_keycode(ps2_scancode_set_t set, uint16_t keycode) {
+    if (keycode >= 256) {
+        return (ps2_mapping_t){0, false, PS2_KEY_NORMAL};
+    }
+
+    switch (set) {
+        case PS2_SCANCODE_SET_1:
+            return ps2_unpack_mapping(ps2_set1_table[keycode], ps2_set1_escapes, PS2_SET1_ESCAPES);
+        case PS2_SCANCODE_SET_3:
+            return (ps2_mapping_t){ps2_set3_table[keycode], false, PS2_KEY_NORMAL};
+        default:
+            return ps2_unpack_mapping(ps2_set2_table[keycode], ps2_set2_escapes, PS2_SET2_ESCAPES);
+    }
+}
+
+uint16_t ps2_keycode_for_usage(uint16_t usage) {
+    if (usage < PS2_USAGE_FIRST || usage > PS2_USAGE_LAST) {
+        return KC_NO;
+    }
+    return ps2_usage_table[usage - PS2_USAGE_FIRST];
+}
+
+// Power, Sleep and Wake are consecutive both as usages and as keycodes
+uint16_t ps2_keycode_for_system_usage(uint16_t usage) {
+    if (usage < SYSTEM_POWER_DOWN || usage > SYSTEM_WAKE_UP) {
+        return KC_NO;
+    }
+    return KC_SYSTEM_POWER + (usage - SYSTEM_POWER_DOWN);
+}
+
+ps2_mapping_t ps2_scancode_for_usage(ps2_scancode_set_t set, uint16_t usage) {
+    return ps2_scancode_for_keycode(set, ps2_keycode_for_usage(usage));
+}
+
+uint16_t ps2_keycode_for_scancode(uint8_t prefix, uint8_t scancode) {
+    switch (prefix) {
+        case 0:
+            return ps2_reverse_plain[scancode];
+        case PS2_PREFIX_E0:
+            return scancode < sizeof(ps2_reverse_e0) ? ps2_reverse_e0[scancode] : KC_NO;
+        case PS2_PREFIX_E1:
+            return PS2_REVERSE_E1;
+        default:
+            return KC_NO;
+    }
+}
+
+#ifdef PS2_SCANCODE_BENCHMARK
+#include "print.h"
+#include "timer.h"
+
+#define PS2_BENCHMARK_ROUNDS 4000  // x 256 keycodes
+
+void ps2_scancodes_benchmark(void) {
+    volatile uint8_t sink = 0;
+
+    uint32_t start = timer_read32();
+    for (uint16_t round = 0; round < PS2_BENCHMARK_ROUNDS; round++) {
+        for (uint16_t keycode = 0; keycode < 256; keycode++) {
+            sink = ps2_scancode_for_keycode(PS2_SCANCODE_SET_2, keycode).scancode;
+        }
+    }
+    uint32_t elapsed = timer_elapsed32(start);
+    (void)sink;
+
+    uint32_t lookups = (uint32_t)PS2_BENCHMARK_ROUNDS * 256;
+    uprintf("[PS2] Scancode lookup: %lu lookups in %lums (%lu ns each)\n",
+            (unsigned long)lookups, (unsigned long)elapsed,
+            (unsigned long)((uint64_t)elapsed * 1000000 / lookups));
+    uprintf("[PS2] Scancode tables: sets %u, escapes %u, usage %u, reverse %u bytes\n",
+            (unsigned)(sizeof(ps2_set1_table) + sizeof(ps2_set2_table) + sizeof(ps2_set3_table)),
+            (unsigned)(sizeof(ps2_set1_escapes) + sizeof(ps2_set2_escapes)),
+            (unsigned)sizeof(ps2_usage_table),
+            (unsigned)(sizeof(ps2_reverse_plain) + sizeof(ps2_reverse_e0)));
+}
+#endif
@@ -0,0 +1,167 @@
+// ps2_stats.c - Keystroke latency histograms and bus counters
+//
+// Buckets are log-linear: values below 4us get a bucket each, above that
+// every power of two is split into 4, so a bucket is never wider than 25%
+// of its value. Percentiles report the top of the bucket they fall in.
+#include "ps2_stats.h"
+#include "ps2_keyboard.h"  // Keyboard port queue
+#include "quantum.h"
+#include <string.h>
+
+#if defined(PROTOCOL_CHIBIOS)
+#include <ch.h>
+#endif
+
+#if PS2_STATS_ENABLE
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t buckets[PS2_STATS_BUCKETS];
+} ps2_histogram_t;
+
+static ps2_histogram_t histograms[PS2_STAGE_COUNT];
+static uint32_t counters[PS2_COUNT_COUNT];
+
+// Keyboard bus bytes in total and the most in one main loop iteration
+static uint32_t bytes_sent = 0;
+static uint8_t bytes_sent_max = 0;
+
+// Keystroke currently being processed
+static uint32_t key_event_start = 0;
+static bool key_event_pending = false;
+static bool key_event_active = false;
+
+static const char *const stage_names[PS2_STAGE_COUNT] = {
+    [PS2_STAGE_SCAN] = "scan->record",
+    [PS2_STAGE_RECORD] = "record->report",
+    [PS2_STAGE_DIFF] = "report diff",
+    [PS2_STAGE_QUEUE] = "queue wait",
+    [PS2_STAGE_WIRE] = "on the wire",
+    [PS2_STAGE_TOTAL] = "record->wire",
+    [PS2_STAGE_EDGE] = "edge lateness",
+};
+
+uint32_t ps2_stats_now(void) {
+#if defined(PROTOCOL_CHIBIOS)
+    // The RP2040 port runs the system timer at 1MHz
+    return TIME_I2US(chVTGetSystemTimeX());
+#else
+    return timer_read32() * 1000UL;
+#endif
+}
+
+static uint8_t ps2_stats_bucket(uint32_t us) {
+    if (us < 4) {
+        return us;
+    }
+    uint8_t octave = 31 - __builtin_clz(us);  // 2 and up
+    uint16_t bucket = (octave - 1) * 4 + ((us >> (octave - 2)) & 3);
+    return bucket < PS2_STATS_BUCKETS ? bucket : PS2_STATS_BUCKETS - 1;
+}
+
+// Largest value that falls in bucket
+static uint32_t ps2_stats_bucket_top(uint8_t bucket) {
+    uint8_t next = bucket + 1;
+    if (next < 4) {
+        return bucket;
+    }
+    uint8_t octave = next / 4 + 1;
+    return ((4UL + next % 4) << (octave - 2)) - 1;
+}
+
+void ps2_stats_record(ps2_stats_stage_t stage, uint32_t us) {
+    ps2_histogram_t *h = &histograms[stage];
+    if (h->count == 0 || us < h->min) {
+        h->min = us;
+    }
+    if (us > h->max) {
+        h->max = us;
+    }
+    h->count++;
+    h->buckets[ps2_stats_bucket(us)]++;
+}
+
+void ps2_stats_count(ps2_stats_counter_t counter) {
+    counters[counter]++;
+}
+
+void ps2_stats_sent(uint8_t bytes) {
+    bytes_sent += bytes;
+    if (bytes > bytes_sent_max) {
+        bytes_sent_max = bytes;
+    }
+}
+
+void ps2_stats_key_event(uint16_t event_time) {
+    // QMK stamps matrix events with the 16-bit millisecond timer
+    ps2_stats_record(PS2_STAGE_SCAN, (uint16_t)(timer_read() - event_time) * 1000UL);
+    key_event_start = ps2_stats_now();
+    key_event_pending = true;
+    key_event_active = true;
+}
+
+uint32_t ps2_stats_report(uint32_t now) {
+    if (key_event_pending) {
+        ps2_stats_record(PS2_STAGE_RECORD, now - key_event_start);
+        key_event_pending = false;
+    }
+    // Later reports from the same keystroke (e.g. a modifier then the key)
+    // still count from its start, until the next keystroke arrives
+    return key_event_active ? key_event_start : now;
+}
+
+static uint32_t ps2_stats_percentile(const ps2_histogram_t *h, uint8_t percent) {
+    uint32_t target = (h->count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t bucket = 0; bucket < PS2_STATS_BUCKETS; bucket++) {
+        seen += h->buckets[bucket];
+        if (seen >= target) {
+            uint32_t top = ps2_stats_bucket_top(bucket);
+            if (top > h->max) return h->max;
+            if (top < h->min) return h->min;
+            return top;
+        }
+    }
+    return h->max;
+}
+
+void ps2_stats_dump(void) {
+    uprintf("[PS2] Latency (us)      count      min      p50      p99      max\n");
+    for (uint8_t stage = 0; stage < PS2_STAGE_COUNT; stage++) {
+        const ps2_histogram_t *h = &histograms[stage];
+        if (h->count == 0) {
+            uprintf("[PS2]   %-15s      0\n", stage_names[stage]);
+            continue;
+        }
+        uprintf("[PS2]   %-15s %6lu %8lu %8lu %8lu %8lu\n", stage_names[stage],
+                (unsigned long)h->count, (unsigned long)h->min,
+                (unsigned long)ps2_stats_percentile(h, 50),
+                (unsigned long)ps2_stats_percentile(h, 99),
+                (unsigned long)h->max);
+    }
+    uprintf("[PS2] Sent: %lu bytes, at most %u per loop\n", (unsigned long)bytes_sent, (unsigned)bytes_sent_max);
+    uprintf("[PS2] Queue high-water: %u/%u\n", (unsigned)ps2_queue_high_water(&ps2_keyboard_port.queue), (unsigned)PS2_QUEUE_SIZE);
+    uprintf("[PS2] Dropped: %lu keys, %lu repeats, %lu responses\n",
+            (unsigned long)counters[PS2_COUNT_KEY_DROPPED],
+            (unsigned long)counters[PS2_COUNT_REPEAT_DROPPED],
+            (unsigned long)counters[PS2_COUNT_RESPONSE_DROPPED]);
+    uprintf("[PS2] Deferred: %lu keys\n", (unsigned long)counters[PS2_COUNT_KEY_DEFERRED]);
+    uprintf("[PS2] Host: %lu resends, %lu frame errors, %lu bytes cut off\n",
+            (unsigned long)counters[PS2_COUNT_HOST_RESEND],
+            (unsigned long)counters[PS2_COUNT_FRAME_ERROR],
+            (unsigned long)counters[PS2_COUNT_TX_ABORT]);
+}
+
+void ps2_stats_reset(void) {
+    memset(histograms, 0, sizeof(histograms));
+    memset(counters, 0, sizeof(counters));
+    bytes_sent = 0;
+    bytes_sent_max = 0;
+    ps2_queue_reset_high_water(&ps2_keyboard_port.queue);
+    key_event_pending = false;
+    key_event_active = false;
+}
+
+#endif
@@ -0,0 +1,96 @@
+// ps2_stats.h - Keystroke latency histograms and bus counters
+//
+// Each stage a keystroke passes through in PS/2 mode is timed into a fixed
+// bucket histogram, so min/p50/p99/max can be read off the console with
+// ps2_stats_dump() (bound to the PS2_STATS keycode in kb.c).
+#ifndef PS2_STATS_H
+#define PS2_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// On by default when there is a console to dump to
+#ifndef PS2_STATS_ENABLE
+#ifdef CONSOLE_ENABLE
+#define PS2_STATS_ENABLE 1
+#else
+#define PS2_STATS_ENABLE 0
+#endif
+#endif
+
+// Histogram range: 4 buckets per power of two of microseconds, up to
+// 2^PS2_STATS_OCTAVES us. Longer samples land in the last bucket; max is
+// always exact.
+#ifndef PS2_STATS_OCTAVES
+#define PS2_STATS_OCTAVES 20  // ~1s
+#endif
+#define PS2_STATS_BUCKETS (PS2_STATS_OCTAVES * 4)
+
+typedef enum {
+    PS2_STAGE_SCAN,    // Matrix event -> process_record_kb() (ms resolution)
+    PS2_STAGE_RECORD,  // process_record_kb() -> report reaches the driver
+    PS2_STAGE_DIFF,    // Report -> its sequences queued
+    PS2_STAGE_QUEUE,   // Sequence queued -> engine starts sending it
+    PS2_STAGE_WIRE,    // Engine starts the sequence -> last stop bit
+    PS2_STAGE_TOTAL,   // process_record_kb() -> last stop bit
+    PS2_STAGE_EDGE,    // Bus edge placed after its deadline (jitter, any port)
+    PS2_STAGE_COUNT
+} ps2_stats_stage_t;
+
+typedef enum {
+    PS2_COUNT_KEY_DROPPED,       // Make/break lost (queue stalled or full)
+    PS2_COUNT_REPEAT_DROPPED,    // Typematic repeat lost to a full queue
+    PS2_COUNT_RESPONSE_DROPPED,  // Command response lost to a full queue
+    PS2_COUNT_KEY_DEFERRED,      // Make/break left for a resync (backlog full)
+    PS2_COUNT_HOST_RESEND,       // Host asked for a resend (0xFE)
+    PS2_COUNT_FRAME_ERROR,       // Garbled frame from the host
+    PS2_COUNT_TX_ABORT,          // Byte cut off by the host and sent again (any port)
+    PS2_COUNT_COUNT
+} ps2_stats_counter_t;
+
+#if PS2_STATS_ENABLE
+// Microsecond clock shared by all stages (safe from the timer callback)
+uint32_t ps2_stats_now(void);
+
+void ps2_stats_record(ps2_stats_stage_t stage, uint32_t us);
+void ps2_stats_count(ps2_stats_counter_t counter);
+
+// Start of a keystroke: called from process_record_kb() with the matrix
+// event time
+void ps2_stats_key_event(uint16_t event_time);
+
+// Bytes the keyboard bus sent since the last main loop iteration (what
+// ps2_keyboard_task() returns)
+void ps2_stats_sent(uint8_t bytes);
+
+// A report reached the driver at now. Returns the time the keystroke that
+// caused it started (now if there was none).
+uint32_t ps2_stats_report(uint32_t now);
+
+void ps2_stats_dump(void);
+void ps2_stats_reset(void);
+#else
+static inline uint32_t ps2_stats_now(void) {
+    return 0;
+}
+static inline void ps2_stats_record(ps2_stats_stage_t stage, uint32_t us) {
+    (void)stage;
+    (void)us;
+}
+static inline void ps2_stats_count(ps2_stats_counter_t counter) {
+    (void)counter;
+}
+static inline void ps2_stats_key_event(uint16_t event_time) {
+    (void)event_time;
+}
+static inline void ps2_stats_sent(uint8_t bytes) {
+    (void)bytes;
+}
+static inline uint32_t ps2_stats_report(uint32_t now) {
+    return now;
+}
+static inline void ps2_stats_dump(void) {}
+static inline void ps2_stats_reset(void) {}
+#endif
+
+#endif // PS2_STATS_H
@@ -0,0 +1,53 @@
+// ps2_trace.c - Deferred binary trace log
+//
+// Single producer (main loop) ring. Writing a record is a timestamp and an
+// 8-byte store; all formatting happens in ps2_trace_drain().
+#include "ps2_trace.h"
+#include "quantum.h"
+
+#if PS2_TRACE_LEVEL > PS2_TRACE_LEVEL_OFF
+
+static ps2_trace_record_t trace_ring[PS2_TRACE_SIZE];
+static uint8_t trace_head = 0;     // Next slot to write
+static uint8_t trace_count = 0;
+static uint16_t trace_dropped = 0; // Records lost since the last drain
+
+void ps2_trace_write(ps2_trace_event_t event, uint16_t a, uint16_t b, uint8_t c) {
+    // Keep the oldest records: the start of a burst says more than its tail
+    if (trace_count >= PS2_TRACE_SIZE) {
+        if (trace_dropped < UINT16_MAX) {
+            trace_dropped++;
+        }
+        return;
+    }
+
+    ps2_trace_record_t *record = &trace_ring[trace_head];
+    record->time = timer_read();
+    record->event = event;
+    record->c = c;
+    record->a = a;
+    record->b = b;
+    trace_head = (trace_head + 1) & (PS2_TRACE_SIZE - 1);
+    trace_count++;
+}
+
+// "PS2T tttt ee cc aaaa bbbb" without the spaces
+static void ps2_trace_print(const ps2_trace_record_t *record) {
+    uprintf("PS2T %04X%02X%02X%04X%04X\n", record->time, record->event, record->c, record->a, record->b);
+}
+
+void ps2_trace_drain(uint8_t max) {
+    while (max-- && trace_count) {
+        uint8_t tail = (trace_head - trace_count) & (PS2_TRACE_SIZE - 1);
+        ps2_trace_print(&trace_ring[tail]);
+        trace_count--;
+    }
+
+    if (trace_dropped && trace_count == 0) {
+        ps2_trace_record_t lost = {.time = timer_read(), .event = PS2_EV_DROPPED, .a = trace_dropped};
+        ps2_trace_print(&lost);
+        trace_dropped = 0;
+    }
+}
+
+#endif
@@ -0,0 +1,114 @@
+// ps2_trace.h - Deferred binary trace log
+//
+// Hot-path events are written as fixed-size binary records to a RAM ring
+// instead of going through uprintf. The ring is drained to the console as
+// hex when the bus is idle, and ps2_trace.py (repo root) turns the records
+// back into text using the event list below.
+#ifndef PS2_TRACE_H
+#define PS2_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PS2_TRACE_LEVEL_OFF   0
+#define PS2_TRACE_LEVEL_WARN  1  // Lost data, errors from the host
+#define PS2_TRACE_LEVEL_INFO  2  // Host commands
+#define PS2_TRACE_LEVEL_DEBUG 3  // Every report, key change and repeat
+
+// Calls above this level are compiled out, arguments and all. With a
+// console the default is WARN, so the keystroke path stays free of trace
+// work; INFO and DEBUG are opt-in from config.h. Without a console there is
+// nothing to drain to, so the default is off.
+#ifndef PS2_TRACE_LEVEL
+#ifdef CONSOLE_ENABLE
+#define PS2_TRACE_LEVEL PS2_TRACE_LEVEL_WARN
+#else
+#define PS2_TRACE_LEVEL PS2_TRACE_LEVEL_OFF
+#endif
+#endif
+
+// Records the ring holds (power of two, 8 bytes each)
+#ifndef PS2_TRACE_SIZE
+#define PS2_TRACE_SIZE 64
+#endif
+
+#if PS2_TRACE_SIZE < 2 || PS2_TRACE_SIZE > 128 || (PS2_TRACE_SIZE & (PS2_TRACE_SIZE - 1)) != 0
+#error "PS2_TRACE_SIZE must be a power of two between 2 and 128"
+#endif
+
+// Records drained per call, so one idle moment never stalls the task loop
+#ifndef PS2_TRACE_DRAIN_BATCH
+#define PS2_TRACE_DRAIN_BATCH 4
+#endif
+
+// Event tokens. ps2_trace.py reads this list: the comment after each entry
+// is a Python format string over the record fields a, b (16 bit) and c
+// (8 bit). Only ever append, so old captures still decode.
+typedef enum {
+    PS2_EV_DROPPED,            // {a} trace records lost (ring full)
+    PS2_EV_KEY_PRESS,          // Key pressed: keycode={a:#06x} scancode={b:#04x} e0={c}
+    PS2_EV_KEY_RELEASE,        // Key released: keycode={a:#06x} scancode={b:#04x} e0={c}
+    PS2_EV_MOD_PRESS,          // Modifier pressed: keycode={a:#06x} scancode={b:#04x} e0={c}
+    PS2_EV_MOD_RELEASE,        // Modifier released: keycode={a:#06x} scancode={b:#04x} e0={c}
+    PS2_EV_REPEAT,             // Typematic repeat: keycode={a:#06x} scancode={b:#04x} e0={c}
+    PS2_EV_UNMAPPED_KEYCODE,   // UNMAPPED keycode: {a:#06x}
+    PS2_EV_UNMAPPED_USAGE,     // UNMAPPED consumer control: {a:#06x}
+    PS2_EV_REPORT,             // Keyboard report: mods={c:#04x} keys={a}
+    PS2_EV_EXTRA,              // Extra key report: usage={a:#06x} keycode={b:#04x}
+    PS2_EV_HOST_COMMAND,       // Host command: {c:#04x}
+    PS2_EV_HOST_FRAME_ERROR,   // Host frame error, requesting resend
+    PS2_EV_LEDS,               // LEDs set: {c:#04x}
+    PS2_EV_TYPEMATIC_SET,      // Typematic set: {c:#04x}
+    PS2_EV_RESPONSE_DROPPED,   // WARNING: Send queue full! Dropping response {c:#04x}
+    PS2_EV_QUEUE_STALLED,      // WARNING: Send queue stalled! Dropping priority {a} packet ending {c:#04x}
+    PS2_EV_QUEUE_FULL,         // WARNING: Send queue full! Dropping priority {a} packet ending {c:#04x}
+    PS2_EV_MATRIX_PRESS,       // Matrix press: keycode={a:#06x} usb_mode={c}
+    PS2_EV_MATRIX_RELEASE,     // Matrix release: keycode={a:#06x} usb_mode={c}
+    PS2_EV_MOUSE_COMMAND,      // Mouse host command: {c:#04x}
+    PS2_EV_MOUSE_ID,           // Mouse ID now {c}
+    PS2_EV_MOUSE_PACKET,       // Mouse packet: buttons={c:#04x} x={a:#06x} y={b:#06x}
+    PS2_EV_TX_ABORT,           // Host cut off {a} byte(s) on CLK pin {c}, sending again
+    PS2_EV_EXTRA_FULL,         // WARNING: Extra key table full! Dropping keycode {a:#06x}
+    PS2_EV_BACKLOG_FULL,       // WARNING: Key backlog full! Keycode {a:#06x} make={c} waits for a resync
+} ps2_trace_event_t;
+
+// One record: 16-bit millisecond timestamp, event token and arguments
+typedef struct {
+    uint16_t time;
+    uint8_t event;  // ps2_trace_event_t
+    uint8_t c;
+    uint16_t a;
+    uint16_t b;
+} ps2_trace_record_t;
+
+#if PS2_TRACE_LEVEL > PS2_TRACE_LEVEL_OFF
+void ps2_trace_write(ps2_trace_event_t event, uint16_t a, uint16_t b, uint8_t c);
+
+// Print up to max records to the console. Call when nothing time-critical
+// is pending.
+void ps2_trace_drain(uint8_t max);
+#else
+static inline void ps2_trace_drain(uint8_t max) {
+    (void)max;
+}
+#endif
+
+#if PS2_TRACE_LEVEL >= PS2_TRACE_LEVEL_WARN
+#define PS2_TRACE_WARN(event, a, b, c) ps2_trace_write(event, a, b, c)
+#else
+#define PS2_TRACE_WARN(event, a, b, c) do {} while (0)
+#endif
+
+#if PS2_TRACE_LEVEL >= PS2_TRACE_LEVEL_INFO
+#define PS2_TRACE_INFO(event, a, b, c) ps2_trace_write(event, a, b, c)
+#else
+#define PS2_TRACE_INFO(event, a, b, c) do {} while (0)
+#endif
+
+#if PS2_TRACE_LEVEL >= PS2_TRACE_LEVEL_DEBUG
+#define PS2_TRACE_DEBUG(event, a, b, c) ps2_trace_write(event, a, b, c)
+#else
+#define PS2_TRACE_DEBUG(event, a, b, c) do {} while (0)
+#endif
+
+#endif // PS2_TRACE_H
@@ -9,7 +9,15 @@ BOOTLOADER = rp2040
 
 # Custom source files for PS/2 device implementation
 SRC += ps2_keyboard.c \
+       ps2_bus.c \
+       ps2_scancodes.c \
+       ps2_queue.c \
+       ps2_trace.c \
+       ps2_stats.c \
+       ps2_keylog.c \
        ps2_mouse.c \
+       host_fanout.c \
+       host_detect.c \
        kb.c
 
 # Compiler optimization
@@ -0,0 +1,687 @@
+// bench.c - PS/2 driver benchmarks on the host-side simulation
+//
+// Each workload runs in its own process on a freshly booted keyboard: mode
+// switch to PS/2, host Reset (0xFF), then the workload, then until the bus
+// has been quiet for a while. Reported per workload:
+//
+//   keys/s       key presses the host decoded, first to last frame
+//   bus B/s      device->host bytes over the same window
+//   report ns    host CPU time of a PS/2 send_keyboard() call (p50/p99),
+//                over the calls that found room in the queue
+//   blocked      calls that had to wait for queue space instead
+//   stall us     virtual time a main loop iteration spent past the matrix
+//                scan (p99/max): busy waits
+//   result       frame errors, clock timing and whether the keys the host
+//                ends up holding match (none) after everything was released
+//
+// Workloads with a mouse also move a pointing device at 1kHz the whole time,
+// on the mouse port with an IntelliMouse host polling at 200Hz. They get a
+// second row for that bus: packets, packets/s, bus B/s and whether the
+// movement the host added up matches what was reported.
+//
+// The typing+knob workload types as in typing while a volume knob is spun
+// now and then, 30 detents in 60ms, with a system Wake tap at the end:
+// every detent has to arrive, the typing alongside too.
+//
+// The busy_host workload runs send_string against a keyboard host that
+// keeps grabbing the clock for a moment, mid-frame or not; every byte it
+// cuts off has to arrive anyway.
+//
+// After the workloads come the protocol cases, also one process each: after
+// the Reset they play host commands and key events and compare every byte
+// the device sent with the stream the host expects - command arguments and
+// Resend on a bad one, the Set 1 and Set 3 encoders and the Set 3 key
+// attributes, NKRO reports and the resync after Disable/Enable.
+//
+// --irq-latency delays every timer callback by up to that many ns, like
+// the USB interrupt on the real board; -v shows how late the bus edges
+// were in the firmware's "edge lateness" histogram.
+//
+// --keylog writes the key events of the workload picked with -w as the
+// firmware's key log recorded them, for replay (SEND_STRING and extra
+// reports bypass process_record_kb() and aren't in it).
+//
+// Usage: bench [-v] [-w workload|case] [--vcd file] [--keylog file] [--irq-latency ns]
+#include "sim_hw.h"
+#include "sim_qmk.h"
+#include "quantum.h"
+#include "ps2_stats.h"
+#include "ps2_keylog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Bus counts as drained once it has been quiet this long
+#define BENCH_QUIET_MS 20
+#define BENCH_DRAIN_LIMIT_MS 60000
+
+// Shortest clock half period a host is guaranteed to sample (spec: 30-50us)
+#define BENCH_CLK_HALF_MIN_NS 30000
+
+// Busy host: CLK held low this long, this often (not a multiple of a frame,
+// so the holds land on every bit of one sooner or later)
+#define BENCH_BUSY_PERIOD_US 2900
+#define BENCH_BUSY_HOLD_US   150
+
+static const char bench_text[] =
+    "The quick brown fox jumps over the lazy dog. PACK MY BOX WITH FIVE DOZEN "
+    "liquor jugs! Sphinx of black quartz, judge my vow: 0123456789 (+-*/=) "
+    "\"quoted\" {braces} [brackets] <angles> ~tilde_under|pipe? #$%^&@\n"
+    "int main(void) { return printf(\"%d\\n\", 42) > 0 ? 0 : 1; }\n";
+
+// =============================================================================
+// EVENT SCRIPTS
+// =============================================================================
+
+typedef struct {
+    uint64_t time_ns;   // From the start of the workload
+    uint8_t keycode;
+    bool pressed;
+    uint8_t report_id;  // Extra report (usage tap) instead of a key
+    uint16_t usage;
+} bench_event_t;
+
+typedef struct {
+    bench_event_t *events;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t next;      // Next event to feed
+    uint64_t start_ns;
+    const char *string; // SEND_STRING workload instead of events
+    uint32_t keystrokes;
+
+    // Pointing device running alongside
+    bool mouse;
+    uint64_t mouse_next_ns;
+    uint32_t mouse_reports;
+    int32_t mouse_x;    // Totals the host should end up with (PS/2 directions)
+    int32_t mouse_y;
+    int32_t mouse_z;
+} bench_script_t;
+
+static void bench_add(bench_script_t *script, uint64_t time_us, uint8_t keycode, bool pressed) {
+    if (script->count == script->capacity) {
+        script->capacity = script->capacity ? script->capacity * 2 : 256;
+        script->events = realloc(script->events, script->capacity * sizeof(bench_event_t));
+        if (!script->events) {
+            perror("bench");
+            exit(1);
+        }
+    }
+    script->events[script->count++] = (bench_event_t){time_us * 1000, keycode, pressed, 0, 0};
+    if (pressed) {
+        script->keystrokes++;
+    }
+}
+
+// Consumer or system usage tapped, as QMK's tap_code() does for an encoder:
+// the usage and its release in back to back reports
+static void bench_add_usage(bench_script_t *script, uint64_t time_us, uint8_t report_id, uint16_t usage) {
+    bench_add(script, time_us, KC_NO, true);
+    script->events[script->count - 1].report_id = report_id;
+    script->events[script->count - 1].usage = usage;
+}
+
+static int bench_event_compare(const void *a, const void *b) {
+    const bench_event_t *x = a;
+    const bench_event_t *y = b;
+    return (x->time_ns > y->time_ns) - (x->time_ns < y->time_ns);
+}
+
+// Fast typist: a key every 25ms, each held 40ms so neighbours overlap, with
+// Shift held around capitals
+static void bench_typing(bench_script_t *script) {
+    uint64_t t = 0;  // us
+    for (const char *c = bench_text; *c; c++) {
+        uint8_t code = sim_ascii_keycode(*c);
+        if ((code & 0x7F) == KC_NO) {
+            continue;
+        }
+        if (code & 0x80) {
+            bench_add(script, t, KC_LEFT_SHIFT, true);
+            bench_add(script, t + 10000, code & 0x7F, true);
+            bench_add(script, t + 50000, code & 0x7F, false);
+            bench_add(script, t + 55000, KC_LEFT_SHIFT, false);
+            t += 60000;
+        } else {
+            bench_add(script, t, code, true);
+            bench_add(script, t + 40000, code, false);
+            t += 25000;
+        }
+    }
+    qsort(script->events, script->count, sizeof(bench_event_t), bench_event_compare);
+}
+
+static void bench_send_string(bench_script_t *script) {
+    script->string = bench_text;
+    for (const char *c = bench_text; *c; c++) {
+        if ((sim_ascii_keycode(*c) & 0x7F) != KC_NO) {
+            script->keystrokes += (sim_ascii_keycode(*c) & 0x80) ? 2 : 1;
+        }
+    }
+}
+
+// Shortcuts: modifiers go down one scan apart, the key follows, everything
+// is let go 30ms later in reverse order
+static void bench_chords(bench_script_t *script) {
+    static const uint8_t chords[][4] = {
+        {KC_LEFT_CTRL, KC_C},
+        {KC_LEFT_CTRL, KC_V},
+        {KC_LEFT_CTRL, KC_LEFT_SHIFT, KC_T},
+        {KC_LEFT_CTRL, KC_LEFT_ALT, KC_DELETE},
+        {KC_LEFT_GUI, KC_R},
+        {KC_LEFT_ALT, KC_LEFT_SHIFT, KC_TAB},
+        {KC_RIGHT_CTRL, KC_RIGHT_SHIFT, KC_RIGHT_ALT, KC_END},
+        {KC_LEFT_CTRL, KC_LEFT_SHIFT, KC_LEFT_ALT, KC_F12},
+    };
+    uint64_t t = 0;  // us
+    for (uint16_t round = 0; round < 40; round++) {
+        for (uint8_t chord = 0; chord < sizeof(chords) / sizeof(chords[0]); chord++) {
+            uint8_t len = 0;
+            while (len < 4 && chords[chord][len] != KC_NO) {
+                bench_add(script, t + len * 1000, chords[chord][len], true);
+                len++;
+            }
+            for (uint8_t i = 0; i < len; i++) {
+                bench_add(script, t + 30000 + i * 1000, chords[chord][len - 1 - i], false);
+            }
+            t += 60000;
+        }
+    }
+}
+
+// Typing with a volume knob spun now and then
+#define BENCH_KNOB_DETENTS     30
+#define BENCH_KNOB_DETENT_US   2000
+#define BENCH_KNOB_INTERVAL_US 1500000
+#define BENCH_USAGE_VOLUME_UP  0xE9
+
+static void bench_typing_knob(bench_script_t *script) {
+    bench_typing(script);
+    uint64_t end = script->events[script->count - 1].time_ns / 1000;
+    for (uint64_t t = 300000; t < end; t += BENCH_KNOB_INTERVAL_US) {
+        for (uint16_t i = 0; i < BENCH_KNOB_DETENTS; i++) {
+            bench_add_usage(script, t + i * BENCH_KNOB_DETENT_US, REPORT_ID_CONSUMER, BENCH_USAGE_VOLUME_UP);
+        }
+    }
+    bench_add_usage(script, end, REPORT_ID_SYSTEM, SYSTEM_WAKE_UP);
+    qsort(script->events, script->count, sizeof(bench_event_t), bench_event_compare);
+}
+
+// Mouse reports every millisecond until the key events run out, with a
+// wheel notch every 16th
+#define BENCH_MOUSE_INTERVAL_NS 1000000
+
+static void bench_mouse(bench_script_t *script, uint64_t elapsed) {
+    while (script->next < script->count && script->mouse_next_ns <= elapsed) {
+        int8_t v = script->mouse_reports % 16 == 0 ? 1 : 0;
+        sim_mouse_event(3, -2, v, 0);
+        script->mouse_x += 3;
+        script->mouse_y += 2;
+        script->mouse_z -= v;
+        script->mouse_reports++;
+        script->mouse_next_ns += BENCH_MOUSE_INTERVAL_NS;
+    }
+}
+
+static void bench_scan(void *ctx) {
+    bench_script_t *script = ctx;
+    if (script->mouse) {
+        bench_mouse(script, sim_now_ns() - script->start_ns);
+    }
+    if (script->string) {
+        sim_send_string(script->string);
+        script->string = NULL;
+        return;
+    }
+    uint64_t elapsed = sim_now_ns() - script->start_ns;
+    while (script->next < script->count && script->events[script->next].time_ns <= elapsed) {
+        const bench_event_t *event = &script->events[script->next++];
+        if (event->report_id) {
+            sim_extra_event(event->report_id, event->usage);
+            sim_extra_event(event->report_id, 0);
+        } else {
+            sim_key_event(event->keycode, event->pressed);
+        }
+    }
+}
+
+// =============================================================================
+// RUNNER
+// =============================================================================
+
+typedef struct {
+    const char *name;
+    void (*build)(bench_script_t *script);
+    bool mouse;
+    bool busy_host;
+} bench_workload_t;
+
+static const bench_workload_t workloads[] = {
+    {"typing", bench_typing, false, false},
+    {"send_string", bench_send_string, false, false},
+    {"chords", bench_chords, false, false},
+    {"typing+mouse", bench_typing, true, false},
+    {"typing+knob", bench_typing_knob, false, false},
+    {"busy_host", bench_send_string, false, true},
+};
+
+static const char *vcd_path = NULL;
+static const char *keylog_path = NULL;
+
+static void bench_keylog_write(void) {
+    uint16_t len = 0;
+    const uint8_t *data = ps2_keylog_data(&len);
+    FILE *file = fopen(keylog_path, "wb");
+    if (!file || fwrite(data, 1, len, file) != len || fclose(file) != 0) {
+        perror(keylog_path);
+    }
+}
+
+static bool bench_script_done(const bench_script_t *script) {
+    return !script->string && script->next >= script->count;
+}
+
+// Run until nothing has moved on the bus for BENCH_QUIET_MS
+static void bench_drain(void) {
+    uint32_t quiet = 0;
+    uint32_t last_edges = 0;
+    sim_edges(&last_edges);
+    for (uint32_t ms = 0; ms < BENCH_DRAIN_LIMIT_MS && quiet < BENCH_QUIET_MS; ms++) {
+        sim_run_ms(1);
+        uint32_t edges = 0;
+        sim_edges(&edges);
+        quiet = edges == last_edges ? quiet + 1 : 0;
+        last_edges = edges;
+    }
+}
+
+// Command from the mouse port's host, answered before the next one
+static void bench_mouse_command(uint8_t byte) {
+    sim_host_send(byte);
+    sim_run_ms(5);
+}
+
+// Reset, IntelliMouse knock, 200 samples/s, enable
+static bool bench_mouse_setup(void) {
+    static const uint8_t commands[] = {0xFF, 0xF3, 200, 0xF3, 100, 0xF3, 80, 0xF2, 0xF3, 200, 0xF4};
+    static const uint8_t expected[] = {0xFA, 0xAA, 0x00, 0xFA, 0xFA, 0xFA, 0xFA, 0xFA, 0xFA,
+                                       0xFA, 0x03, 0xFA, 0xFA, 0xFA};
+    sim_bus_select(SIM_BUS_MOUSE);
+    sim_host_reset();
+    for (size_t i = 0; i < sizeof(commands); i++) {
+        bench_mouse_command(commands[i]);
+    }
+    uint8_t reply[sizeof(expected) + 4];
+    uint32_t len = sim_host_received(reply, sizeof(reply));
+    sim_bus_stats_reset();
+    sim_bus_select(SIM_BUS_KEYBOARD);
+    return len == sizeof(expected) && !memcmp(reply, expected, len);
+}
+
+static const char *bench_bus_check(const sim_bus_stats_t *bus, char *result, size_t size) {
+    if (bus->frame_errors) {
+        snprintf(result, size, "FAIL: %u frame errors", (unsigned)bus->frame_errors);
+    } else if (bus->clk_low_min_ns < BENCH_CLK_HALF_MIN_NS || bus->clk_high_min_ns < BENCH_CLK_HALF_MIN_NS) {
+        snprintf(result, size, "FAIL: clock %.1f/%.1fus low/high", bus->clk_low_min_ns / 1000.0,
+                 bus->clk_high_min_ns / 1000.0);
+    } else {
+        return NULL;
+    }
+    return result;
+}
+
+// Add up the 4-byte packets the mouse host received and compare
+static bool bench_mouse_report(const bench_script_t *script) {
+    static uint8_t log[65536];
+    sim_bus_select(SIM_BUS_MOUSE);
+    const sim_bus_stats_t *bus = sim_bus_stats();
+    uint32_t len = sim_host_received(log, sizeof(log));
+    sim_bus_select(SIM_BUS_KEYBOARD);
+
+    int32_t x = 0, y = 0, z = 0;
+    uint32_t packets = len / 4;
+    bool aligned = len % 4 == 0;
+    for (uint32_t i = 0; aligned && i < len; i += 4) {
+        aligned = (log[i] & 0x08) != 0;
+        x += log[i + 1] - ((log[i] & 0x10) ? 256 : 0);
+        y += log[i + 2] - ((log[i] & 0x20) ? 256 : 0);
+        z += (int8_t)log[i + 3];
+    }
+
+    uint64_t window_ns = bus->last_frame_ns > bus->first_frame_ns ? bus->last_frame_ns - bus->first_frame_ns : 1;
+    char result[96];
+    bool ok = false;
+    if (bench_bus_check(bus, result, sizeof(result))) {
+    } else if (!aligned) {
+        snprintf(result, sizeof(result), "FAIL: %u bytes are not 4-byte packets", (unsigned)len);
+    } else if (x != script->mouse_x || y != script->mouse_y || z != script->mouse_z) {
+        snprintf(result, sizeof(result), "MISMATCH: moved %d/%d/%d of %d/%d/%d", (int)x, (int)y, (int)z,
+                 (int)script->mouse_x, (int)script->mouse_y, (int)script->mouse_z);
+    } else {
+        snprintf(result, sizeof(result), "ok (%u reports)", (unsigned)script->mouse_reports);
+        ok = true;
+    }
+    printf("%-12s %5u %8.1f %8.0f %40s %s\n", "  mouse", (unsigned)packets, packets * 1e9 / window_ns,
+           bus->frames * 1e9 / window_ns, "", result);
+    return ok;
+}
+
+static bool bench_run(const bench_workload_t *workload) {
+    sim_boot(true);
+    sim_host_reset();
+    sim_host_send(0xFF);
+    bench_drain();
+
+    uint8_t reply[4];
+    uint32_t len = sim_host_received(reply, sizeof(reply));
+    if (len < 2 || reply[0] != 0xFA || reply[1] != 0xAA) {
+        printf("%-12s FAIL: no ACK + BAT after Reset\n", workload->name);
+        return false;
+    }
+
+    if (workload->mouse && !bench_mouse_setup()) {
+        printf("%-12s FAIL: mouse did not answer the IntelliMouse setup\n", workload->name);
+        return false;
+    }
+
+    if (vcd_path && !sim_vcd_open(vcd_path)) {
+        perror(vcd_path);
+    }
+    bench_script_t script = {0};
+    workload->build(&script);
+    script.mouse = workload->mouse;
+    sim_qmk_stats_reset();
+    sim_bus_stats_reset();
+    sim_edges_clear();
+    ps2_stats_reset();
+    if (workload->busy_host) {
+        sim_host_inhibit_every(BENCH_BUSY_PERIOD_US, BENCH_BUSY_HOLD_US);
+    }
+
+    if (keylog_path) {
+        ps2_keylog_start();
+    }
+
+    script.start_ns = sim_now_ns();
+    while (!bench_script_done(&script)) {
+        sim_loop_once(bench_scan, &script);
+    }
+    bench_drain();
+    sim_vcd_close();
+    if (keylog_path) {
+        bench_keylog_write();
+    }
+
+    const sim_bus_stats_t *bus = sim_bus_stats();
+    sim_qmk_stats_t *qmk = &sim_qmk_stats;
+    uint64_t window_ns = bus->last_frame_ns > bus->first_frame_ns ? bus->last_frame_ns - bus->first_frame_ns : 1;
+    double keys_per_s = sim_host_makes() * 1e9 / window_ns;
+    double bytes_per_s = bus->frames * 1e9 / window_ns;
+
+    bool ok = false;
+    char result[96];
+    uint32_t edge_count = 0;
+    sim_edges(&edge_count);
+    if (bench_bus_check(bus, result, sizeof(result))) {
+    } else if (sim_host_keys_held() != 0 || sim_host_makes() != script.keystrokes) {
+        snprintf(result, sizeof(result), "MISMATCH: %u/%u keys, %u still held", (unsigned)sim_host_makes(),
+                 (unsigned)script.keystrokes, (unsigned)sim_host_keys_held());
+    } else if (workload->busy_host) {
+        snprintf(result, sizeof(result), "ok (%u edges, %u bytes cut off)", (unsigned)edge_count,
+                 (unsigned)sim_host_cuts());
+        ok = true;
+    } else {
+        snprintf(result, sizeof(result), "ok (%u edges)", (unsigned)edge_count);
+        ok = true;
+    }
+
+    printf("%-12s %5u %8.1f %8.0f %6llu/%-6llu %4u/%-4u %7.0f/%-8.0f %s\n", workload->name,
+           (unsigned)sim_host_makes(), keys_per_s, bytes_per_s,
+           (unsigned long long)sim_samples_percentile(&qmk->report_host_ns, 50),
+           (unsigned long long)sim_samples_percentile(&qmk->report_host_ns, 99),
+           (unsigned)qmk->reports_blocked, (unsigned)qmk->reports,
+           sim_samples_percentile(&qmk->loop_stall_ns, 99) / 1000.0,
+           sim_samples_percentile(&qmk->loop_stall_ns, 100) / 1000.0, result);
+
+    if (workload->mouse && !bench_mouse_report(&script)) {
+        ok = false;
+    }
+
+    if (sim_verbose) {
+        ps2_stats_dump();
+    }
+    return ok;
+}
+
+// =============================================================================
+// PROTOCOL CASES
+// =============================================================================
+// Byte streams the host must see for host commands, the other scancode sets
+// and NKRO reports. Each case runs on a freshly booted and reset keyboard,
+// like a workload; a mismatch prints both streams.
+
+typedef struct {
+    uint16_t keycode;
+    bool pressed;
+    const report_nkro_t *nkro;  // Instead of a key event
+} bench_input_t;
+
+static void bench_input_scan(void *ctx) {
+    const bench_input_t *input = ctx;
+    if (input->nkro) {
+        host_get_driver()->send_nkro((report_nkro_t *)input->nkro);
+    } else {
+        sim_key_event(input->keycode, input->pressed);
+    }
+}
+
+// Host command bytes, each answered before the next
+static void bench_host(const uint8_t *bytes, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        sim_host_send(bytes[i]);
+        sim_run_ms(5);
+    }
+}
+
+static void bench_key(uint16_t keycode, bool pressed) {
+    bench_input_t input = {keycode, pressed, NULL};
+    sim_loop_once(bench_input_scan, &input);
+    sim_run_ms(10);
+}
+
+static void bench_tap(uint16_t keycode) {
+    bench_key(keycode, true);
+    bench_key(keycode, false);
+}
+
+static void bench_nkro(const uint8_t *keycodes, size_t len) {
+    report_nkro_t report = {0};
+    for (size_t i = 0; i < len; i++) {
+        report.bits[keycodes[i] / 8] |= 1 << (keycodes[i] % 8);
+    }
+    bench_input_t input = {KC_NO, false, &report};
+    sim_loop_once(bench_input_scan, &input);
+    sim_run_ms(10);
+}
+
+#define BENCH_HOST(...) bench_host((const uint8_t[]){__VA_ARGS__}, sizeof((const uint8_t[]){__VA_ARGS__}))
+#define BENCH_NKRO(...) bench_nkro((const uint8_t[]){__VA_ARGS__}, sizeof((const uint8_t[]){__VA_ARGS__}))
+
+// ED, F3 and F0 take an argument; one they can't use gets FE and the host
+// sends it again
+static void bench_case_arguments(void) {
+    BENCH_HOST(0xED, 0x02);        // FA FA
+    BENCH_HOST(0xF3, 0x80, 0x20);  // FA FE FA
+    BENCH_HOST(0xF0, 0x05, 0x02);  // FA FE FA
+    BENCH_HOST(0xF0, 0x00);        // FA FA 02
+}
+
+// Set 1: break = make | 0x80, E0 on both
+static void bench_case_set1(void) {
+    BENCH_HOST(0xF0, 0x01);  // FA FA
+    bench_tap(KC_A);         // 1E 9E
+    bench_tap(KC_UP);        // E0 48 E0 C8
+}
+
+// Set 3: no E0, F0 breaks; F9 makes every key make-only
+static void bench_case_set3(void) {
+    BENCH_HOST(0xF0, 0x03);  // FA FA
+    bench_tap(KC_UP);        // 63 F0 63
+    BENCH_HOST(0xF9);        // FA
+    bench_tap(KC_UP);        // 63
+    bench_tap(KC_A);         // 1C
+}
+
+// Set 3: FD makes the keys that follow make-only, up to the next command
+static void bench_case_set3_keys(void) {
+    BENCH_HOST(0xF0, 0x03, 0xFD, 0x1C, 0xEE);  // FA FA FA FA EE
+    bench_tap(KC_A);                           // 1C
+    bench_tap(KC_B);                           // 32 F0 32
+}
+
+// NKRO reports are diffed against what the host holds
+static void bench_case_nkro(void) {
+    BENCH_NKRO(KC_A, KC_B);  // 1C 32
+    BENCH_NKRO(KC_B);        // F0 1C
+    BENCH_NKRO(KC_B, KC_C);  // 21
+    bench_nkro(NULL, 0);     // F0 32 F0 21
+}
+
+// Changes while disabled go out as one diff on Enable
+static void bench_case_disable(void) {
+    bench_key(KC_A, true);   // 1C
+    BENCH_HOST(0xF5);        // FA
+    bench_key(KC_A, false);
+    bench_key(KC_B, true);
+    BENCH_HOST(0xF4);        // FA F0 1C 32
+    bench_key(KC_B, false);  // F0 32
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+    uint8_t expected[24];
+    uint8_t expected_len;
+} bench_case_t;
+
+#define BENCH_EXPECT(...) {__VA_ARGS__}, sizeof((const uint8_t[]){__VA_ARGS__})
+
+static const bench_case_t cases[] = {
+    {"arguments", bench_case_arguments, BENCH_EXPECT(0xFA, 0xFA, 0xFA, 0xFE, 0xFA, 0xFA, 0xFE, 0xFA, 0xFA, 0xFA, 0x02)},
+    {"set1", bench_case_set1, BENCH_EXPECT(0xFA, 0xFA, 0x1E, 0x9E, 0xE0, 0x48, 0xE0, 0xC8)},
+    {"set3", bench_case_set3, BENCH_EXPECT(0xFA, 0xFA, 0x63, 0xF0, 0x63, 0xFA, 0x63, 0x1C)},
+    {"set3_keys", bench_case_set3_keys, BENCH_EXPECT(0xFA, 0xFA, 0xFA, 0xFA, 0xEE, 0x1C, 0x32, 0xF0, 0x32)},
+    {"nkro", bench_case_nkro, BENCH_EXPECT(0x1C, 0x32, 0xF0, 0x1C, 0x21, 0xF0, 0x32, 0xF0, 0x21)},
+    {"disable", bench_case_disable, BENCH_EXPECT(0x1C, 0xFA, 0xFA, 0xF0, 0x1C, 0x32, 0xF0, 0x32)},
+};
+
+static void bench_print_bytes(const char *label, const uint8_t *bytes, uint32_t len) {
+    printf("%-12s   %s:", "", label);
+    for (uint32_t i = 0; i < len; i++) {
+        printf(" %02X", bytes[i]);
+    }
+    printf("\n");
+}
+
+static bool bench_case_run(const bench_case_t *c) {
+    sim_boot(true);
+    sim_host_reset();
+    sim_host_send(0xFF);
+    bench_drain();
+
+    uint8_t received[64];
+    sim_host_received(received, sizeof(received));
+    c->run();
+    bench_drain();
+    uint32_t len = sim_host_received(received, sizeof(received));
+
+    if (len != c->expected_len || memcmp(received, c->expected, len)) {
+        printf("%-12s MISMATCH\n", c->name);
+        bench_print_bytes("expected", c->expected, c->expected_len);
+        bench_print_bytes("received", received, len);
+        return false;
+    }
+    printf("%-12s ok (%u bytes)\n", c->name, (unsigned)len);
+    return true;
+}
+
+// A fresh process per run: the driver keeps its state in statics
+static bool bench_fork(const char *name, bool (*run)(const void *arg), const void *arg) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        bool ok = run(arg);
+        fflush(stdout);
+        _exit(ok ? 0 : 1);
+    }
+    int child = 0;
+    waitpid(pid, &child, 0);
+    if (!WIFEXITED(child)) {
+        printf("%-12s crashed\n", name);
+    }
+    return WIFEXITED(child) && WEXITSTATUS(child) == 0;
+}
+
+static bool bench_run_workload(const void *arg) {
+    return bench_run(arg);
+}
+
+static bool bench_run_case(const void *arg) {
+    return bench_case_run(arg);
+}
+
+int main(int argc, char **argv) {
+    const char *only = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            sim_verbose = true;
+        } else if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+            only = argv[++i];
+        } else if (!strcmp(argv[i], "--vcd") && i + 1 < argc) {
+            vcd_path = argv[++i];
+        } else if (!strcmp(argv[i], "--keylog") && i + 1 < argc) {
+            keylog_path = argv[++i];
+        } else if (!strcmp(argv[i], "--irq-latency") && i + 1 < argc) {
+            sim_irq_latency(strtoul(argv[++i], NULL, 0));
+        } else {
+            fprintf(stderr, "usage: %s [-v] [-w workload] [--vcd file] [--keylog file] [--irq-latency ns]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (keylog_path && !only) {
+        fprintf(stderr, "%s: --keylog needs -w\n", argv[0]);
+        return 2;
+    }
+
+    printf("%-12s %5s %8s %8s %13s %9s %16s  %s\n", "workload", "keys", "keys/s", "bus B/s", "report ns",
+           "blocked", "stall us", "result");
+    printf("%-12s %5s %8s %8s %13s %9s %16s\n", "", "", "", "", "p50/p99", "", "p99/max");
+
+    int status = 0;
+    for (size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+        if (only && strcmp(only, workloads[i].name)) {
+            continue;
+        }
+        if (!bench_fork(workloads[i].name, bench_run_workload, &workloads[i])) {
+            status = 1;
+        }
+    }
+
+    if (keylog_path) {
+        return status;
+    }
+    printf("\n%-12s %s\n", "case", "result");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (only && strcmp(only, cases[i].name)) {
+            continue;
+        }
+        if (!bench_fork(cases[i].name, bench_run_case, &cases[i])) {
+            status = 1;
+        }
+    }
+    return status;
+}
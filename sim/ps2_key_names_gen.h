@@ -0,0 +1,157 @@
+// ps2_key_names_gen.h - Display name of each key, by QMK keycode
+// GENERATED by gen_scancodes.py from ps2_keys.def - do not edit
+#ifndef PS2_KEY_NAMES_GEN_H
+#define PS2_KEY_NAMES_GEN_H
+
+static const char *const ps2_key_names[256] = {
+    [KC_A]                = "A",
+    [KC_B]                = "B",
+    [KC_C]                = "C",
+    [KC_D]                = "D",
+    [KC_E]                = "E",
+    [KC_F]                = "F",
+    [KC_G]                = "G",
+    [KC_H]                = "H",
+    [KC_I]                = "I",
+    [KC_J]                = "J",
+    [KC_K]                = "K",
+    [KC_L]                = "L",
+    [KC_M]                = "M",
+    [KC_N]                = "N",
+    [KC_O]                = "O",
+    [KC_P]                = "P",
+    [KC_Q]                = "Q",
+    [KC_R]                = "R",
+    [KC_S]                = "S",
+    [KC_T]                = "T",
+    [KC_U]                = "U",
+    [KC_V]                = "V",
+    [KC_W]                = "W",
+    [KC_X]                = "X",
+    [KC_Y]                = "Y",
+    [KC_Z]                = "Z",
+    [KC_1]                = "1",
+    [KC_2]                = "2",
+    [KC_3]                = "3",
+    [KC_4]                = "4",
+    [KC_5]                = "5",
+    [KC_6]                = "6",
+    [KC_7]                = "7",
+    [KC_8]                = "8",
+    [KC_9]                = "9",
+    [KC_0]                = "0",
+    [KC_F1]               = "F1",
+    [KC_F2]               = "F2",
+    [KC_F3]               = "F3",
+    [KC_F4]               = "F4",
+    [KC_F5]               = "F5",
+    [KC_F6]               = "F6",
+    [KC_F7]               = "F7",
+    [KC_F8]               = "F8",
+    [KC_F9]               = "F9",
+    [KC_F10]              = "F10",
+    [KC_F11]              = "F11",
+    [KC_F12]              = "F12",
+    [KC_F13]              = "F13",
+    [KC_F14]              = "F14",
+    [KC_F15]              = "F15",
+    [KC_F16]              = "F16",
+    [KC_F17]              = "F17",
+    [KC_F18]              = "F18",
+    [KC_F19]              = "F19",
+    [KC_F20]              = "F20",
+    [KC_F21]              = "F21",
+    [KC_F22]              = "F22",
+    [KC_F23]              = "F23",
+    [KC_F24]              = "F24",
+    [KC_GRAVE]            = "GRAVE",
+    [KC_MINUS]            = "MINUS",
+    [KC_EQUAL]            = "EQUAL",
+    [KC_LBRC]             = "LBRACKET",
+    [KC_RBRC]             = "RBRACKET",
+    [KC_BSLS]             = "BACKSLASH",
+    [KC_SCLN]             = "SEMICOLON",
+    [KC_QUOTE]            = "QUOTE",
+    [KC_COMMA]            = "COMMA",
+    [KC_DOT]              = "DOT",
+    [KC_SLASH]            = "SLASH",
+    [KC_ESCAPE]           = "ESC",
+    [KC_BSPC]             = "BACKSPACE",
+    [KC_TAB]              = "TAB",
+    [KC_CAPS]             = "CAPS",
+    [KC_ENTER]            = "ENTER",
+    [KC_SPACE]            = "SPACE",
+    [KC_LCTL]             = "LCTRL",
+    [KC_LSFT]             = "LSHIFT",
+    [KC_LALT]             = "LALT",
+    [KC_LGUI]             = "LGUI",
+    [KC_RCTL]             = "RCTRL",
+    [KC_RSFT]             = "RSHIFT",
+    [KC_RALT]             = "RALT",
+    [KC_RGUI]             = "RGUI",
+    [KC_APPLICATION]      = "MENU",
+    [KC_INSERT]           = "INSERT",
+    [KC_HOME]             = "HOME",
+    [KC_PGUP]             = "PGUP",
+    [KC_DELETE]           = "DELETE",
+    [KC_END]              = "END",
+    [KC_PGDN]             = "PGDN",
+    [KC_UP]               = "UP",
+    [KC_DOWN]             = "DOWN",
+    [KC_LEFT]             = "LEFT",
+    [KC_RIGHT]            = "RIGHT",
+    [KC_NUM]              = "NUMLOCK",
+    [KC_KP_SLASH]         = "KP_SLASH",
+    [KC_KP_ASTERISK]      = "KP_ASTERISK",
+    [KC_KP_MINUS]         = "KP_MINUS",
+    [KC_KP_PLUS]          = "KP_PLUS",
+    [KC_KP_ENTER]         = "KP_ENTER",
+    [KC_KP_DOT]           = "KP_DOT",
+    [KC_KP_0]             = "KP_0",
+    [KC_KP_1]             = "KP_1",
+    [KC_KP_2]             = "KP_2",
+    [KC_KP_3]             = "KP_3",
+    [KC_KP_4]             = "KP_4",
+    [KC_KP_5]             = "KP_5",
+    [KC_KP_6]             = "KP_6",
+    [KC_KP_7]             = "KP_7",
+    [KC_KP_8]             = "KP_8",
+    [KC_KP_9]             = "KP_9",
+    [KC_SCRL]             = "SCROLL",
+    [KC_PSCR]             = "PSCREEN",
+    [KC_PAUSE]            = "PAUSE",
+    [KC_AUDIO_MUTE]       = "MUTE",
+    [KC_AUDIO_VOL_UP]     = "VOLUMEUP",
+    [KC_AUDIO_VOL_DOWN]   = "VOLUMEDOWN",
+    [KC_MEDIA_NEXT_TRACK] = "MEDIA_NEXT",
+    [KC_MEDIA_PREV_TRACK] = "MEDIA_PREV",
+    [KC_MEDIA_STOP]       = "MEDIA_STOP",
+    [KC_MEDIA_PLAY_PAUSE] = "MEDIA_PLAY",
+    [KC_MEDIA_SELECT]     = "MEDIA_SELECT",
+    [KC_WWW_SEARCH]       = "WWW_SEARCH",
+    [KC_WWW_HOME]         = "WWW_HOME",
+    [KC_WWW_BACK]         = "WWW_BACK",
+    [KC_WWW_FORWARD]      = "WWW_FORWARD",
+    [KC_WWW_STOP]         = "WWW_STOP",
+    [KC_WWW_REFRESH]      = "WWW_REFRESH",
+    [KC_WWW_FAVORITES]    = "WWW_FAVORITES",
+    [KC_MAIL]             = "APP_MAIL",
+    [KC_CALCULATOR]       = "APP_CALC",
+    [KC_MY_COMPUTER]      = "APP_MYCOMP",
+    [KC_SYSTEM_POWER]     = "POWER",
+    [KC_SYSTEM_SLEEP]     = "SLEEP",
+    [KC_SYSTEM_WAKE]      = "WAKE",
+    [KC_INT1]             = "INTL1",
+    [KC_INT2]             = "INTL2",
+    [KC_INT3]             = "INTL3",
+    [KC_INT4]             = "INTL4",
+    [KC_INT5]             = "INTL5",
+    [KC_INT6]             = "INTL6",
+    [KC_LNG1]             = "LANG1",
+    [KC_LNG2]             = "LANG2",
+    [KC_LNG3]             = "LANG3",
+    [KC_LNG4]             = "LANG4",
+    [KC_LNG5]             = "LANG5",
+};
+
+#endif // PS2_KEY_NAMES_GEN_H
@@ -0,0 +1,992 @@
+// ps2cap.c - Offline PS/2 decoder for logic analyzer captures
+//
+// Reads one bus (CLK and DATA) from a sigrok CSV or VCD capture, from
+// sigrok-cli, PulseView or bench --vcd, and decodes it in one pass without
+// holding the capture in memory. Both directions are decoded the way the
+// other end reads them: device bytes on the falling clock edge, host bytes
+// on the rising edge plus the device's ACK bit. Whose a CLK low phase is
+// follows from the frame it is in: from idle, CLK falling while DATA is
+// still high is the host; inside a frame, a low is the device's unless it
+// outlasts the device's previous one by half again or DATA moved during a
+// device byte's low, which is the host grabbing the clock. A host low ending with DATA low is a request-to-send,
+// otherwise an inhibit, and a device byte it lands in is cut off (the
+// device sends it again; not an error).
+//
+// Each byte is printed with its time and meaning: Set 2 keys through the
+// firmware's own reverse tables and the names from ps2_keys.def, host
+// commands and their arguments, responses. The summary gives per direction
+// bytes/s, parity, framing, timeout and missing-ACK errors, and the clock
+// frequency, CLK half periods, inter-byte gaps, the host's request-to-send
+// hold and how long the device took to start answering a host byte.
+//
+// The exit status is 1 if any byte failed to decode, or bytes were cut off
+// and none decoded, so a capture can gate a timing regression.
+//
+// Usage: ps2cap [-q] [-m] [-c clk] [-d data] [--rate hz] file|-
+//
+//   -q      summary only
+//   -m      mouse bus: mouse command names, device bytes undecoded
+//   -c/-d   channel names (default: the first containing "clk"/"clock"
+//           and "dat", else the first two channels)
+//   --rate  samplerate of a CSV capture without a time column or a
+//           "; Samplerate:" comment
+#define _GNU_SOURCE  // strcasestr()
+#include "quantum.h"
+#include "ps2_bus.h"
+#include "ps2_keyboard.h"
+#include "ps2_mouse.h"
+#include "ps2_scancodes.h"
+#include "ps2_key_names_gen.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// CLK stuck high this long inside a frame ends it as a timeout; the device
+// may take up to 15ms to start clocking a host byte in
+#define CAP_BIT_TIMEOUT_NS  2000000ULL
+#define CAP_RTS_TIMEOUT_NS 15000000ULL
+
+// Histograms: one bucket per unit, the last one catches everything above
+#define CAP_HIST_BUCKETS 65536
+
+#define CAP_LINE_MAX 4096
+#define CAP_NAME_MAX 64
+
+// =============================================================================
+// STATISTICS
+// =============================================================================
+
+typedef struct {
+    uint32_t count[CAP_HIST_BUCKETS];
+    uint32_t samples;
+    uint64_t min;
+    uint64_t max;
+} cap_hist_t;
+
+typedef enum {
+    CAP_DEVICE,
+    CAP_HOST,
+    CAP_DIRECTIONS
+} cap_dir_t;
+
+typedef struct {
+    uint32_t bytes;
+    uint32_t parity_errors;
+    uint32_t framing_errors;
+    uint32_t timeouts;
+    uint32_t cut_off;
+    uint32_t no_ack;
+    uint64_t first_ns;   // Start of the first byte
+    uint64_t last_ns;    // End of the last one
+    cap_hist_t period;   // Clock period per byte, 0.1us
+    cap_hist_t low;      // CLK half periods, 0.1us
+    cap_hist_t high;
+    cap_hist_t gap;      // End of the previous byte (either way) to the start of this one, us
+    cap_hist_t wait;     // Device: host byte end to its answer starting, us. Host: RTS hold, us
+} cap_stats_t;
+
+static cap_stats_t stats[CAP_DIRECTIONS];
+static const char *const dir_names[CAP_DIRECTIONS] = {"device", "host"};
+
+static void cap_hist_add(cap_hist_t *hist, uint64_t value) {
+    if (hist->samples == 0 || value < hist->min) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+    hist->count[value < CAP_HIST_BUCKETS ? value : CAP_HIST_BUCKETS - 1]++;
+    hist->samples++;
+}
+
+static uint64_t cap_hist_percentile(const cap_hist_t *hist, uint8_t percent) {
+    uint64_t rank = ((uint64_t)hist->samples * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (uint32_t value = 0; value < CAP_HIST_BUCKETS; value++) {
+        seen += hist->count[value];
+        if (seen >= rank && seen > 0) {
+            return value == CAP_HIST_BUCKETS - 1 ? hist->max : value;
+        }
+    }
+    return hist->max;
+}
+
+// =============================================================================
+// BYTE ANNOTATION
+// =============================================================================
+// What each byte means, as far as the bytes before it tell: Set 2 prefixes
+// and breaks, the argument of a host command, the reply to one.
+
+static bool mouse_bus = false;
+static bool quiet = false;
+
+static struct {
+    bool e0;
+    bool f0;
+    uint8_t pause;          // Bytes left of E1 14 77 E1 F0 14 F0 77
+    uint8_t scancode_set;   // Only Set 2 is decoded
+    uint8_t answers_due;    // Host bytes the device hasn't ACKed (or refused) yet
+    uint8_t replies;        // Device bytes after the ACKs that belong to a command
+    const char *reply;
+    uint8_t command;        // Host command waiting for its argument
+    bool resend;            // Host asked for the last device byte again
+    char last[64];          // What that byte meant
+} keys = {.scancode_set = 2};
+
+static const char *cap_response_name(uint8_t byte) {
+    switch (byte) {
+        case PS2_ACK:           return "ACK";
+        case PS2_RESEND:        return "Resend";
+        case PS2_BAT_SUCCESS:   return "BAT passed";
+        case PS2_BAT_FAIL:      return "BAT failed";
+        case PS2_ECHO_RESPONSE: return "Echo";
+        default:                return NULL;
+    }
+}
+
+static void cap_describe_device_byte(uint8_t byte, char *text, size_t size) {
+    const char *response = cap_response_name(byte);
+    text[0] = '\0';
+
+    if (keys.answers_due && response) {
+        keys.answers_due--;
+        snprintf(text, size, "%s", response);
+        return;
+    }
+    if (keys.replies) {
+        keys.replies--;
+        snprintf(text, size, "%s", keys.reply);
+        return;
+    }
+    if (mouse_bus) {
+        return;
+    }
+
+    if (keys.pause) {
+        if (--keys.pause == 0) {
+            snprintf(text, size, "%s", ps2_key_names[KC_PAUSE]);
+        }
+        return;
+    }
+    if (!keys.e0 && !keys.f0 && (response || byte == 0x00 || byte == 0xFF)) {
+        snprintf(text, size, "%s", response ? response : "Overrun");
+        return;
+    }
+    switch (byte) {
+        case PS2_PREFIX_E0:
+            keys.e0 = true;
+            return;
+        case PS2_PREFIX_F0:
+            keys.f0 = true;
+            return;
+        case PS2_PREFIX_E1:
+            keys.pause = 7;
+            return;
+    }
+
+    uint16_t keycode = keys.scancode_set == 2 ? ps2_keycode_for_scancode(keys.e0 ? PS2_PREFIX_E0 : 0, byte) : KC_NO;
+    const char *name = keycode < 256 ? ps2_key_names[keycode] : NULL;
+    if (keys.scancode_set != 2) {
+        snprintf(text, size, "Set %u code", keys.scancode_set);
+    } else if (name) {
+        snprintf(text, size, "%s %s", name, keys.f0 ? "break" : "make");
+    } else if (keys.e0 && byte == 0x12) {
+        snprintf(text, size, "PrintScreen shift %s", keys.f0 ? "break" : "make");
+    } else {
+        snprintf(text, size, "unknown %s%02X", keys.e0 ? "E0 " : "", byte);
+    }
+    keys.e0 = false;
+    keys.f0 = false;
+}
+
+static void cap_describe_device(uint8_t byte, char *text, size_t size) {
+    // A resent byte means what it did the first time; decoding it again
+    // would take it for the next one in the sequence
+    if (keys.resend) {
+        keys.resend = false;
+        snprintf(text, size, "%s", keys.last);
+        return;
+    }
+    cap_describe_device_byte(byte, text, size);
+    snprintf(keys.last, sizeof(keys.last), "%s", text);
+}
+
+static const char *cap_keyboard_command(uint8_t byte) {
+    switch (byte) {
+        case PS2_CMD_SET_LEDS:           return "Set LEDs";
+        case PS2_CMD_ECHO:               return "Echo";
+        case PS2_CMD_SET_SCANCODE_SET:   return "Scancode set";
+        case PS2_CMD_IDENTIFY:           return "Identify";
+        case PS2_CMD_SET_TYPEMATIC:      return "Set typematic";
+        case PS2_CMD_ENABLE:             return "Enable";
+        case PS2_CMD_DISABLE:            return "Disable";
+        case PS2_CMD_SET_DEFAULTS:       return "Set defaults";
+        case PS2_CMD_SET_ALL_TYPEMATIC:  return "All keys typematic";
+        case PS2_CMD_SET_ALL_MAKE_BREAK: return "All keys make/break";
+        case PS2_CMD_SET_ALL_MAKE:       return "All keys make";
+        case PS2_CMD_SET_ALL_DEFAULT:    return "All keys default";
+        case PS2_CMD_SET_KEY_TYPEMATIC:  return "Key typematic";
+        case PS2_CMD_SET_KEY_MAKE_BREAK: return "Key make/break";
+        case PS2_CMD_SET_KEY_MAKE:       return "Key make";
+        case PS2_CMD_RESET:              return "Reset";
+        default:                         return NULL;
+    }
+}
+
+static const char *cap_mouse_command(uint8_t byte) {
+    switch (byte) {
+        case PS2_MOUSE_CMD_SET_SCALING_1_1: return "Scaling 1:1";
+        case PS2_MOUSE_CMD_SET_SCALING_2_1: return "Scaling 2:1";
+        case PS2_MOUSE_CMD_SET_RESOLUTION:  return "Set resolution";
+        case PS2_MOUSE_CMD_STATUS_REQUEST:  return "Status request";
+        case PS2_MOUSE_CMD_SET_STREAM_MODE: return "Stream mode";
+        case PS2_MOUSE_CMD_READ_DATA:       return "Read data";
+        case PS2_MOUSE_CMD_RESET_WRAP_MODE: return "Reset wrap mode";
+        case PS2_MOUSE_CMD_SET_WRAP_MODE:   return "Wrap mode";
+        case PS2_MOUSE_CMD_SET_REMOTE_MODE: return "Remote mode";
+        case PS2_MOUSE_CMD_GET_DEVICE_ID:   return "Get device ID";
+        case PS2_MOUSE_CMD_SET_SAMPLE_RATE: return "Set sample rate";
+        case PS2_MOUSE_CMD_ENABLE:          return "Enable";
+        case PS2_MOUSE_CMD_DISABLE:         return "Disable";
+        case PS2_MOUSE_CMD_SET_DEFAULTS:    return "Set defaults";
+        case PS2_MOUSE_CMD_RESET:           return "Reset";
+        default:                            return NULL;
+    }
+}
+
+static void cap_describe_host(uint8_t byte, char *text, size_t size) {
+    // Answered with the last byte again, not an ACK; a command waiting for
+    // its argument still is
+    if (byte == PS2_CMD_RESEND) {
+        keys.resend = true;
+        snprintf(text, size, "Resend");
+        return;
+    }
+    keys.answers_due++;
+    text[0] = '\0';
+
+    // Argument of the previous command
+    uint8_t command = keys.command;
+    keys.command = 0;
+    if (command == PS2_CMD_SET_LEDS && !mouse_bus) {
+        snprintf(text, size, "LEDs:%s%s%s", byte & 0x04 ? " caps" : "", byte & 0x02 ? " num" : "",
+                 byte & 0x01 ? " scroll" : "");
+        return;
+    }
+    if (command == PS2_CMD_SET_SCANCODE_SET && !mouse_bus) {
+        if (byte == 0) {
+            keys.replies = 1;
+            keys.reply = "Scancode set";
+            snprintf(text, size, "Query");
+        } else {
+            keys.scancode_set = byte;
+            snprintf(text, size, "Set %u", byte);
+        }
+        return;
+    }
+    if (command == PS2_CMD_SET_TYPEMATIC) {
+        snprintf(text, size, mouse_bus ? "%u samples/s" : "Rate/delay %02X", byte);
+        return;
+    }
+    if (command == PS2_MOUSE_CMD_SET_RESOLUTION && mouse_bus) {
+        snprintf(text, size, "%u counts/mm", 1 << (byte & 3));
+        return;
+    }
+
+    const char *name = mouse_bus ? cap_mouse_command(byte) : cap_keyboard_command(byte);
+    if (!name) {
+        return;
+    }
+    snprintf(text, size, "%s", name);
+    switch (byte) {
+        case PS2_CMD_SET_LEDS:
+        case PS2_CMD_SET_SCANCODE_SET:
+        case PS2_CMD_SET_TYPEMATIC:
+        case PS2_MOUSE_CMD_SET_RESOLUTION:
+            keys.command = byte;
+            break;
+        case PS2_CMD_IDENTIFY:
+            keys.replies = mouse_bus ? 1 : 2;
+            keys.reply = "ID";
+            break;
+        case PS2_CMD_RESET:
+            keys.answers_due = 1;
+            keys.replies = mouse_bus ? 2 : 1;
+            keys.reply = mouse_bus ? "BAT / ID" : "BAT";
+            keys.scancode_set = 2;
+            break;
+        case PS2_MOUSE_CMD_STATUS_REQUEST:
+            if (mouse_bus) {
+                keys.replies = 3;
+                keys.reply = "Status";
+            }
+            break;
+    }
+}
+
+// =============================================================================
+// BUS DECODER
+// =============================================================================
+// Fed the two line levels at every change. Frames are only counted once the
+// rising edge after their last bit shows the clock low was the device's.
+
+typedef enum {
+    CAP_IDLE,
+    CAP_HOST_HOLD,  // Host pulled CLK low from idle: inhibit or request-to-send
+    CAP_IN_DEVICE,  // Device->host: bits sampled on falling edges
+    CAP_IN_HOST     // Host->device: bits sampled on rising edges
+} cap_state_t;
+
+static struct {
+    cap_state_t state;
+    bool clk;
+    bool data;
+    bool fall_data;           // DATA when CLK last fell
+    uint64_t fall_ns;
+    uint64_t rise_ns;
+    uint8_t falls;            // Falling edges in this frame
+    uint8_t rises;            // Rising edges in this frame
+    uint16_t frame;
+    bool ack;
+    uint64_t start_ns;        // Device: start bit edge; host: CLK released after RTS
+    uint64_t first_fall_ns;
+    uint64_t pending_high;    // High half period, kept until the next low proves short
+    uint64_t device_low_ns;   // Last CLK low the device drove (0 = none yet)
+    uint64_t last_end_ns;     // End of the last frame either way (0 = none yet)
+    uint64_t host_end_ns;     // End of the last host byte still waiting for an answer
+    uint64_t now_ns;
+    uint32_t inhibits;
+    uint64_t changes;
+} bus = {.clk = true, .data = true};
+
+static void cap_print(uint64_t time_ns, cap_dir_t dir, const char *byte, const char *text) {
+    if (quiet) {
+        return;
+    }
+    printf("%14.6f  %-6s %s%s%s\n", time_ns / 1e9, dir_names[dir], byte, text[0] ? "  " : "", text);
+}
+
+static void cap_count_frame(cap_dir_t dir, uint64_t end_ns) {
+    cap_stats_t *s = &stats[dir];
+    uint64_t frames = s->bytes + s->parity_errors + s->framing_errors + s->no_ack;
+    if (frames == 0) {
+        s->first_ns = bus.start_ns;
+    }
+    s->last_ns = end_ns;
+    if (bus.last_end_ns) {
+        cap_hist_add(&s->gap, (bus.start_ns - bus.last_end_ns) / 1000);
+    }
+    bus.last_end_ns = end_ns;
+    cap_hist_add(&s->period, (bus.fall_ns - bus.first_fall_ns) / 10 / 100);
+}
+
+static void cap_device_done(uint64_t end_ns) {
+    cap_stats_t *s = &stats[CAP_DEVICE];
+    uint8_t byte = (bus.frame >> 1) & 0xFF;
+    bool parity_ok = (__builtin_popcount((bus.frame >> 1) & 0x1FF) & 1) == 1;
+    bool stop_ok = (bus.frame >> 10) & 1;
+
+    if (bus.host_end_ns) {
+        cap_hist_add(&s->wait, (bus.start_ns - bus.host_end_ns) / 1000);
+        bus.host_end_ns = 0;
+    }
+    cap_count_frame(CAP_DEVICE, end_ns);
+
+    char hex[4];
+    snprintf(hex, sizeof(hex), "%02X", byte);
+    if (!stop_ok) {
+        s->framing_errors++;
+        cap_print(bus.start_ns, CAP_DEVICE, hex, "FRAMING ERROR (stop bit low)");
+    } else if (!parity_ok) {
+        s->parity_errors++;
+        cap_print(bus.start_ns, CAP_DEVICE, hex, "PARITY ERROR");
+    } else {
+        char text[64];
+        s->bytes++;
+        cap_describe_device(byte, text, sizeof(text));
+        cap_print(bus.start_ns, CAP_DEVICE, hex, text);
+    }
+}
+
+static void cap_host_done(uint64_t end_ns) {
+    cap_stats_t *s = &stats[CAP_HOST];
+    uint8_t byte = bus.frame & 0xFF;
+    bool parity_ok = (__builtin_popcount(bus.frame & 0x1FF) & 1) == 1;
+    bool stop_ok = (bus.frame >> 9) & 1;
+
+    cap_count_frame(CAP_HOST, end_ns);
+    bus.host_end_ns = end_ns;
+
+    char hex[4];
+    snprintf(hex, sizeof(hex), "%02X", byte);
+    if (!stop_ok) {
+        s->framing_errors++;
+        cap_print(bus.start_ns, CAP_HOST, hex, "FRAMING ERROR (stop bit low)");
+    } else if (!parity_ok) {
+        s->parity_errors++;
+        cap_print(bus.start_ns, CAP_HOST, hex, "PARITY ERROR");
+    } else if (!bus.ack) {
+        s->no_ack++;
+        cap_print(bus.start_ns, CAP_HOST, hex, "NOT ACKNOWLEDGED");
+    } else {
+        char text[64];
+        s->bytes++;
+        cap_describe_host(byte, text, sizeof(text));
+        cap_print(bus.start_ns, CAP_HOST, hex, text);
+    }
+}
+
+static void cap_abandon(const char *why, bool error) {
+    cap_dir_t dir = bus.state == CAP_IN_DEVICE ? CAP_DEVICE : CAP_HOST;
+    uint8_t bits = dir == CAP_DEVICE ? bus.falls : bus.rises;
+    char text[64];
+    snprintf(text, sizeof(text), "%s after %u bits", why, bits);
+    cap_print(bus.start_ns, dir, "--", text);
+    if (error) {
+        stats[dir].timeouts++;
+    } else {
+        stats[dir].cut_off++;
+    }
+    bus.state = CAP_IDLE;
+}
+
+static void cap_falling(uint64_t now) {
+    if (bus.state != CAP_IDLE && bus.falls > 0) {
+        bus.pending_high = now - bus.rise_ns;
+    }
+    bus.fall_ns = now;
+    bus.fall_data = bus.data;
+
+    switch (bus.state) {
+        case CAP_IDLE:
+            // The device pulls DATA low for the start bit before it clocks;
+            // the host grabs CLK first and only then pulls DATA for an RTS
+            if (!bus.data) {
+                bus.state = CAP_IN_DEVICE;
+                bus.falls = 1;
+                bus.frame = 0;
+                bus.start_ns = now;
+                bus.first_fall_ns = now;
+            } else {
+                bus.state = CAP_HOST_HOLD;
+            }
+            return;
+
+        case CAP_HOST_HOLD:
+            return;
+
+        case CAP_IN_DEVICE:
+            bus.frame |= (uint16_t)bus.data << bus.falls;
+            bus.falls++;
+            return;
+
+        case CAP_IN_HOST:
+            if (bus.falls++ == 0) {
+                bus.first_fall_ns = now;
+            }
+            if (bus.falls == 11) {
+                bus.ack = !bus.data;
+            }
+            return;
+    }
+}
+
+// Whether the CLK low phase that just ended was the host's. Inside a frame
+// the device clocks every bit at the same rate, so a low half again as long
+// as its last one is the host holding CLK past the device's release. The
+// first low of a frame gets more room: the firmware steps down to a slower
+// profile (up to twice the low time) when the host asks for a Resend. A
+// device only changes DATA while CLK is high, so DATA moving during a low of
+// its own byte is the host pulling it for a request-to-send. With nothing to
+// compare against yet, the low is the device's.
+static bool cap_host_low(uint64_t low) {
+    switch (bus.state) {
+        case CAP_IDLE:
+            return false;
+        case CAP_HOST_HOLD:
+            return true;
+        case CAP_IN_DEVICE:
+            if (bus.data != bus.fall_data) {
+                return true;
+            }
+            break;
+        case CAP_IN_HOST:
+            break;
+    }
+    uint64_t limit = bus.falls > 1 ? bus.device_low_ns + bus.device_low_ns / 2 : bus.device_low_ns * 3;
+    return bus.device_low_ns && low > limit;
+}
+
+static void cap_rising(uint64_t now) {
+    uint64_t low = now - bus.fall_ns;
+    bus.rise_ns = now;
+
+    if (cap_host_low(low)) {
+        // The host read all eleven bits before it grabbed the clock
+        if (bus.state == CAP_IN_DEVICE && bus.falls == 11) {
+            bus.state = CAP_IDLE;
+            cap_device_done(bus.fall_ns);
+        }
+        if (bus.state == CAP_IN_DEVICE || bus.state == CAP_IN_HOST) {
+            cap_abandon("cut off by the host", false);
+        }
+        bus.state = CAP_IDLE;
+        if (!bus.data) {
+            // Request-to-send: the start bit is on DATA, the device clocks the rest
+            bus.state = CAP_IN_HOST;
+            bus.falls = 0;
+            bus.rises = 0;
+            bus.frame = 0;
+            bus.ack = false;
+            bus.start_ns = now;
+            cap_hist_add(&stats[CAP_HOST].wait, low / 1000);
+        } else {
+            bus.inhibits++;
+        }
+        return;
+    }
+    if (bus.state == CAP_IDLE) {
+        return;
+    }
+
+    cap_stats_t *s = &stats[bus.state == CAP_IN_DEVICE ? CAP_DEVICE : CAP_HOST];
+    if (bus.falls > 0) {
+        cap_hist_add(&s->low, low / 100);
+        bus.device_low_ns = low;
+    }
+    if (bus.falls > 1) {
+        cap_hist_add(&s->high, bus.pending_high / 100);
+    }
+
+    if (bus.state == CAP_IN_DEVICE) {
+        if (bus.falls == 11) {
+            bus.state = CAP_IDLE;
+            cap_device_done(now);
+        }
+        return;
+    }
+
+    // Data, parity and stop on the first ten rising edges, ACK on the eleventh
+    if (bus.falls == 0) {
+        return;
+    }
+    if (bus.rises < 10) {
+        bus.frame |= (uint16_t)bus.data << bus.rises;
+    }
+    if (++bus.rises == 11) {
+        bus.state = CAP_IDLE;
+        cap_host_done(now);
+    }
+}
+
+// CLK stuck high inside a frame: the sender gave up
+static void cap_check_timeout(uint64_t now) {
+    if (bus.state == CAP_IDLE || !bus.clk) {
+        return;
+    }
+    uint64_t limit = bus.state == CAP_IN_HOST && bus.falls == 0 ? CAP_RTS_TIMEOUT_NS : CAP_BIT_TIMEOUT_NS;
+    if (now - bus.rise_ns > limit) {
+        cap_abandon("TIMEOUT", true);
+    }
+}
+
+static void cap_sample(uint64_t now, bool clk, bool data) {
+    cap_check_timeout(now);
+    bus.now_ns = now;
+    bus.data = data;
+    if (clk != bus.clk) {
+        bus.clk = clk;
+        if (clk) {
+            cap_rising(now);
+        } else {
+            cap_falling(now);
+        }
+    }
+    bus.changes++;
+}
+
+// =============================================================================
+// CAPTURE READERS
+// =============================================================================
+// Both call cap_sample() once per timestamp at which either line changed.
+// When CLK and DATA change in the same sample, DATA counts as settled first.
+
+static const char *clk_name = NULL;
+static const char *data_name = NULL;
+static double csv_rate = 0;
+
+static bool cap_name_is(const char *name, const char *const *hints) {
+    for (; *hints; hints++) {
+        if (strcasestr(name, *hints)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Pick the CLK and DATA channels out of count names; false if not found
+static bool cap_pick_channels(char names[][CAP_NAME_MAX], int count, int *clk, int *data) {
+    static const char *const clk_hints[] = {"clk", "clock", NULL};
+    static const char *const data_hints[] = {"dat", NULL};
+    *clk = -1;
+    *data = -1;
+    for (int i = 0; i < count; i++) {
+        if (*clk < 0 && (clk_name ? !strcmp(names[i], clk_name) : cap_name_is(names[i], clk_hints))) {
+            *clk = i;
+        } else if (*data < 0 && (data_name ? !strcmp(names[i], data_name) : cap_name_is(names[i], data_hints))) {
+            *data = i;
+        }
+    }
+    if (*clk < 0 && *data < 0 && !clk_name && !data_name && count >= 2) {
+        *clk = 0;
+        *data = 1;
+    }
+    if (*clk < 0 || *data < 0) {
+        fprintf(stderr, "ps2cap: no CLK/DATA channels (have:");
+        for (int i = 0; i < count; i++) {
+            fprintf(stderr, " %s", names[i]);
+        }
+        fprintf(stderr, "); use -c and -d\n");
+        return false;
+    }
+    printf("channels     CLK=%s DATA=%s\n", names[*clk], names[*data]);
+    return true;
+}
+
+#define CAP_VCD_MAX_VARS 64
+
+// One whitespace separated token; false at end of file
+static bool cap_token(FILE *in, char *token, size_t size) {
+    int c;
+    while ((c = getc(in)) != EOF && isspace(c)) {
+    }
+    if (c == EOF) {
+        return false;
+    }
+    size_t len = 0;
+    do {
+        if (len + 1 < size) {
+            token[len++] = c;
+        }
+    } while ((c = getc(in)) != EOF && !isspace(c));
+    token[len] = '\0';
+    return true;
+}
+
+// "1ns", "10 us": ns per VCD time unit, as a multiplier or a divisor
+static bool cap_vcd_timescale(const char *text, uint64_t *mul, uint64_t *div) {
+    static const struct {
+        const char *unit;
+        int exp;  // Power of ten of one unit in ns
+    } units[] = {{"fs", -6}, {"ps", -3}, {"ns", 0}, {"us", 3}, {"ms", 6}, {"s", 9}};
+    char *unit = NULL;
+    long magnitude = strtol(text, &unit, 10);
+    while (*unit == ' ') {
+        unit++;
+    }
+    for (size_t i = 0; i < sizeof(units) / sizeof(units[0]); i++) {
+        if (strcmp(unit, units[i].unit)) {
+            continue;
+        }
+        *mul = magnitude;
+        *div = 1;
+        for (int e = units[i].exp; e > 0; e--) {
+            *mul *= 10;
+        }
+        for (int e = units[i].exp; e < 0; e++) {
+            *div *= 10;
+        }
+        return magnitude > 0;
+    }
+    return false;
+}
+
+static bool cap_read_vcd(FILE *in) {
+    char token[CAP_LINE_MAX];
+    char names[CAP_VCD_MAX_VARS][CAP_NAME_MAX];
+    char ids[CAP_VCD_MAX_VARS][CAP_NAME_MAX];
+    int vars = 0;
+    uint64_t mul = 1, div = 1;
+
+    // Header: timescale and variables
+    while (cap_token(in, token, sizeof(token)) && strcmp(token, "$enddefinitions")) {
+        if (!strcmp(token, "$timescale")) {
+            char scale[CAP_NAME_MAX] = "";
+            while (cap_token(in, token, sizeof(token)) && strcmp(token, "$end")) {
+                strncat(scale, token, sizeof(scale) - strlen(scale) - 1);
+            }
+            if (!cap_vcd_timescale(scale, &mul, &div)) {
+                fprintf(stderr, "ps2cap: unknown timescale '%s'\n", scale);
+                return false;
+            }
+        } else if (!strcmp(token, "$var") && vars < CAP_VCD_MAX_VARS) {
+            char type[CAP_NAME_MAX], width[CAP_NAME_MAX];
+            if (!cap_token(in, type, sizeof(type)) || !cap_token(in, width, sizeof(width)) ||
+                !cap_token(in, ids[vars], CAP_NAME_MAX) || !cap_token(in, names[vars], CAP_NAME_MAX)) {
+                break;
+            }
+            vars++;
+        }
+    }
+
+    int clk, data;
+    if (!cap_pick_channels(names, vars, &clk, &data)) {
+        return false;
+    }
+
+    // Value changes: apply everything at one timestamp, then sample
+    bool levels[2] = {true, true};
+    bool sampled[2] = {true, true};
+    uint64_t time = 0;
+    bool started = false;
+    while (cap_token(in, token, sizeof(token))) {
+        char level = token[0];
+        const char *id = token + 1;
+        if (level == '#') {
+            if (started && (levels[0] != sampled[0] || levels[1] != sampled[1])) {
+                cap_sample(time * mul / div, levels[0], levels[1]);
+                sampled[0] = levels[0];
+                sampled[1] = levels[1];
+            }
+            time = strtoull(id, NULL, 10);
+            started = true;
+            continue;
+        }
+        if (level == 'b' || level == 'B' || level == 'r' || level == 'R') {
+            cap_token(in, token, sizeof(token));  // Vector value: skip its identifier
+            continue;
+        }
+        if (level == '$') {
+            continue;  // $dumpvars, $end and the like
+        }
+        if (!strcmp(id, ids[clk])) {
+            levels[0] = level != '0';
+        } else if (!strcmp(id, ids[data])) {
+            levels[1] = level != '0';
+        }
+    }
+    if (levels[0] != sampled[0] || levels[1] != sampled[1]) {
+        cap_sample(time * mul / div, levels[0], levels[1]);
+    }
+    bus.now_ns = time * mul / div;
+    return true;
+}
+
+// "; Samplerate: 2 MHz" (sigrok CSV comment) in Hz, or 0
+static double cap_csv_samplerate(const char *line) {
+    const char *p = strcasestr(line, "samplerate:");
+    if (!p) {
+        return 0;
+    }
+    char *unit = NULL;
+    double rate = strtod(p + strlen("samplerate:"), &unit);
+    while (*unit == ' ') {
+        unit++;
+    }
+    switch (tolower(*unit)) {
+        case 'k': return rate * 1e3;
+        case 'm': return rate * 1e6;
+        case 'g': return rate * 1e9;
+        default:  return rate;
+    }
+}
+
+static bool cap_read_csv(FILE *in, char *line) {
+    char names[CAP_VCD_MAX_VARS][CAP_NAME_MAX];
+    int columns = 0;
+    int time_column = -1;
+    int clk = -1, data = -1;
+    uint64_t sample = 0;
+    bool last[2] = {true, true};
+
+    do {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == ';' || line[0] == '#' || line[0] == '\0') {
+            if (csv_rate == 0) {
+                csv_rate = cap_csv_samplerate(line);
+            }
+            continue;
+        }
+
+        // Header: channel names (a first line of numbers has none)
+        if (clk < 0) {
+            char *save = NULL;
+            bool numeric = true;
+            for (char *field = strtok_r(line, ",", &save); field && columns < CAP_VCD_MAX_VARS;
+                 field = strtok_r(NULL, ",", &save)) {
+                while (*field == ' ') {
+                    field++;
+                }
+                numeric = numeric && (isdigit((unsigned char)*field) || *field == '.');
+                snprintf(names[columns], CAP_NAME_MAX, "%s", numeric ? "" : field);
+                if (!strncasecmp(field, "time", 4)) {
+                    time_column = columns;
+                }
+                columns++;
+            }
+            if (numeric) {
+                fprintf(stderr, "ps2cap: CSV capture needs a header line with channel names\n");
+                return false;
+            }
+            // Channels only: the time column is not a candidate
+            char channel_names[CAP_VCD_MAX_VARS][CAP_NAME_MAX];
+            int map[CAP_VCD_MAX_VARS];
+            int channels = 0;
+            for (int i = 0; i < columns; i++) {
+                if (i != time_column) {
+                    memcpy(channel_names[channels], names[i], CAP_NAME_MAX);
+                    map[channels++] = i;
+                }
+            }
+            if (!cap_pick_channels(channel_names, channels, &clk, &data)) {
+                return false;
+            }
+            clk = map[clk];
+            data = map[data];
+            if (time_column < 0 && csv_rate == 0) {
+                fprintf(stderr, "ps2cap: CSV capture has no time column or samplerate; use --rate\n");
+                return false;
+            }
+            continue;
+        }
+
+        bool levels[2] = {true, true};
+        uint64_t now = 0;
+        char *save = NULL;
+        int column = 0;
+        for (char *field = strtok_r(line, ",", &save); field; field = strtok_r(NULL, ",", &save), column++) {
+            if (column == time_column) {
+                now = (uint64_t)(strtod(field, NULL) * 1e9 + 0.5);
+            } else if (column == clk) {
+                levels[0] = atoi(field) != 0;
+            } else if (column == data) {
+                levels[1] = atoi(field) != 0;
+            }
+        }
+        if (time_column < 0) {
+            now = (uint64_t)(sample * 1e9 / csv_rate + 0.5);
+        }
+        sample++;
+        bus.now_ns = now;
+        if (levels[0] != last[0] || levels[1] != last[1]) {
+            cap_sample(now, levels[0], levels[1]);
+            last[0] = levels[0];
+            last[1] = levels[1];
+        }
+    } while (fgets(line, CAP_LINE_MAX, in));
+    return true;
+}
+
+// =============================================================================
+// SUMMARY
+// =============================================================================
+
+static void cap_print_hist(const char *dir, const char *what, const cap_hist_t *hist, double scale) {
+    if (hist->samples == 0) {
+        return;
+    }
+    printf("%-6s %-18s %8u %9.1f %9.1f %9.1f %9.1f\n", dir, what, (unsigned)hist->samples, hist->min * scale,
+           cap_hist_percentile(hist, 50) * scale, cap_hist_percentile(hist, 99) * scale, hist->max * scale);
+}
+
+// Clock frequency from the period histogram (0.1us): the fast end of the
+// frequencies is the short end of the periods
+static void cap_print_clock(const char *dir, const cap_hist_t *hist) {
+    if (hist->samples == 0 || hist->min == 0) {
+        return;
+    }
+    printf("%-6s %-18s %8u %9.2f %9.2f %9.2f %9.2f\n", dir, "clock kHz", (unsigned)hist->samples,
+           1e4 / hist->max, 1e4 / cap_hist_percentile(hist, 50), 1e4 / cap_hist_percentile(hist, 1),
+           1e4 / hist->min);
+}
+
+static bool cap_summary(void) {
+    bool ok = true;
+    printf("\ncapture      %.6f s, %llu line changes, %u inhibits\n", bus.now_ns / 1e9,
+           (unsigned long long)bus.changes, (unsigned)bus.inhibits);
+    printf("%-6s %7s %9s %7s %8s %8s %8s %7s\n", "", "bytes", "bytes/s", "parity", "framing", "timeout",
+           "cut off", "no ACK");
+    for (int dir = 0; dir < CAP_DIRECTIONS; dir++) {
+        cap_stats_t *s = &stats[dir];
+        uint64_t window_ns = s->last_ns > s->first_ns ? s->last_ns - s->first_ns : 0;
+        printf("%-6s %7u %9.1f %7u %8u %8u %8u %7u\n", dir_names[dir], (unsigned)s->bytes,
+               window_ns ? s->bytes * 1e9 / window_ns : 0.0, (unsigned)s->parity_errors,
+               (unsigned)s->framing_errors, (unsigned)s->timeouts, (unsigned)s->cut_off, (unsigned)s->no_ack);
+        ok = ok && !s->parity_errors && !s->framing_errors && !s->timeouts && !s->no_ack;
+        // Cut-offs and not one byte through: a stuck bus, or a misread one
+        ok = ok && (s->bytes || !s->cut_off);
+    }
+
+    printf("\n%-6s %-18s %8s %9s %9s %9s %9s\n", "", "", "count", "min", "p50", "p99", "max");
+    for (int dir = 0; dir < CAP_DIRECTIONS; dir++) {
+        cap_stats_t *s = &stats[dir];
+        cap_print_clock(dir_names[dir], &s->period);
+        cap_print_hist(dir_names[dir], "CLK low us", &s->low, 0.1);
+        cap_print_hist(dir_names[dir], "CLK high us", &s->high, 0.1);
+        cap_print_hist(dir_names[dir], "gap before us", &s->gap, 1);
+        cap_print_hist(dir_names[dir], dir == CAP_DEVICE ? "answer after us" : "RTS hold us", &s->wait, 1);
+    }
+    if (bus.state == CAP_IN_DEVICE || bus.state == CAP_IN_HOST) {
+        printf("(capture ends inside a %s byte)\n", bus.state == CAP_IN_DEVICE ? "device" : "host");
+    }
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-q")) {
+            quiet = true;
+        } else if (!strcmp(argv[i], "-m")) {
+            mouse_bus = true;
+        } else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+            clk_name = argv[++i];
+        } else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+            data_name = argv[++i];
+        } else if (!strcmp(argv[i], "--rate") && i + 1 < argc) {
+            csv_rate = strtod(argv[++i], NULL);
+        } else if (!path && (argv[i][0] != '-' || !strcmp(argv[i], "-"))) {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "usage: %s [-q] [-m] [-c clk] [-d data] [--rate hz] file|-\n", argv[0]);
+        return 2;
+    }
+
+    FILE *in = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if (!in) {
+        perror(path);
+        return 2;
+    }
+
+    // VCD starts with a $ keyword; anything else is taken for CSV
+    static char line[CAP_LINE_MAX];
+    int c;
+    while ((c = getc(in)) != EOF && isspace(c)) {
+    }
+    if (c == EOF) {
+        fprintf(stderr, "ps2cap: %s is empty\n", path);
+        return 2;
+    }
+    ungetc(c, in);
+    bool read_ok;
+    if (c == '$') {
+        read_ok = cap_read_vcd(in);
+    } else {
+        read_ok = fgets(line, sizeof(line), in) && cap_read_csv(in, line);
+    }
+    if (in != stdin) {
+        fclose(in);
+    }
+    if (!read_ok) {
+        return 2;
+    }
+    cap_check_timeout(bus.now_ns);
+    return cap_summary() ? 0 : 1;
+}
@@ -0,0 +1,621 @@
+// replay.c - Runs a recorded key log through the driver on the simulation
+//
+// Boots the keyboard as bench does, in the mode the log was recorded in,
+// resets it from the host and puts back the scancode set, typematic rate
+// and timing profile from the log header. Then every recorded scan's events
+// go through process_record_kb() at their recorded time on the virtual
+// clock, with the typematic task, the key backlog and the consumer key meter
+// running in between as they did on the keyboard. The same log gives the
+// same byte stream every run.
+//
+// Each event is printed with the Set 2 bytes the host received for it and
+// its latency from process_record_kb() to their last stop bit. Typematic
+// repeats, responses and bytes no event explains get lines of their own.
+// The summary has latency percentiles for presses and releases, the events
+// that never reached the host and the keys it still holds.
+//
+// The log is the binary file bench --keylog writes, or console output with
+// the "PS2K" lines the PS2_KEYLOG key prints (the last log in it is used).
+//
+// The exit status is 1 if an event was lost, a frame was garbled or the
+// host holds other keys than the log at the end.
+//
+// Usage: replay [-q] [-v] [--vcd file] [--irq-latency ns] file|-
+//
+//   -q      summary only
+//   -v      console output and the firmware's latency histograms
+#include "sim_hw.h"
+#include "sim_qmk.h"
+#include "quantum.h"
+#include "ps2_bus.h"
+#include "ps2_keyboard.h"
+#include "ps2_keylog.h"
+#include "ps2_scancodes.h"
+#include "ps2_stats.h"
+#include "ps2_key_names_gen.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// After the last event: done once the bus has been quiet this long
+#define REPLAY_QUIET_MS 20
+#define REPLAY_DRAIN_LIMIT_MS 60000
+
+// Time the host gives the keyboard to answer each setup command
+#define REPLAY_COMMAND_MS 5
+
+static void *replay_grow(void *array, uint32_t *capacity, size_t size) {
+    *capacity = *capacity ? *capacity * 2 : 1024;
+    array = realloc(array, *capacity * size);
+    if (!array) {
+        perror("replay");
+        exit(1);
+    }
+    return array;
+}
+
+// =============================================================================
+// KEY LOG
+// =============================================================================
+
+typedef struct {
+    uint64_t time_ns;   // Recorded, from the start of the log
+    uint32_t scan;      // Events of one matrix scan share this
+    uint16_t keycode;
+    bool pressed;
+    bool wire_due;      // Expected to produce bytes on the wire
+    uint64_t fed_ns;    // When the replay handed it to process_record_kb()
+    int32_t seq;        // Wire sequence it produced (-1 = none yet)
+} replay_event_t;
+
+static struct {
+    uint8_t set;
+    uint8_t typematic;
+    uint8_t profile;
+    bool usb_mode;
+    replay_event_t *events;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t scans;
+} keylog;
+
+static bool keylog_is_header(const uint8_t *data, uint32_t len) {
+    return len >= PS2_KEYLOG_HEADER_SIZE && !memcmp(data, PS2_KEYLOG_MAGIC, 4) && data[4] == PS2_KEYLOG_VERSION;
+}
+
+static int hex_value(int c) {
+    return isdigit(c) ? c - '0' : tolower(c) - 'a' + 10;
+}
+
+// Console output: the hex after each "PS2K ", in place. A line that starts
+// with a header starts the log over, so the last one wins.
+static uint32_t keylog_from_console(uint8_t *text, uint32_t len) {
+    uint32_t out = 0;
+    uint32_t line_start = 0;
+    text[len] = '\0';
+    for (char *line = (char *)text; line; ) {
+        char *next = strchr(line, '\n');
+        if (next) {
+            *next++ = '\0';
+        }
+        const char *p = strstr(line, "PS2K ");
+        if (p) {
+            line_start = out;
+            for (p += 5; isxdigit((unsigned char)p[0]) && isxdigit((unsigned char)p[1]); p += 2) {
+                text[out++] = hex_value(p[0]) << 4 | hex_value(p[1]);
+            }
+            if (line_start > 0 && keylog_is_header(text + line_start, out - line_start)) {
+                memmove(text, text + line_start, out - line_start);
+                out -= line_start;
+            }
+        }
+        line = next;
+    }
+    return out;
+}
+
+static bool keylog_load(const char *path) {
+    FILE *file = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    uint8_t *data = NULL;
+    uint32_t len = 0, capacity = 0;
+    size_t got;
+    do {
+        if (capacity - len < 4096) {
+            data = replay_grow(data, &capacity, 1);
+        }
+        got = fread(data + len, 1, capacity - len - 1, file);
+        len += got;
+    } while (got > 0);
+    if (file != stdin) {
+        fclose(file);
+    }
+
+    // The binary log as is, else the hex out of console output
+    if (!keylog_is_header(data, len)) {
+        len = keylog_from_console(data, len);
+    }
+    if (!keylog_is_header(data, len)) {
+        fprintf(stderr, "%s: no key log (version %u) found\n", path, PS2_KEYLOG_VERSION);
+        return false;
+    }
+    keylog.set = data[5];
+    keylog.typematic = data[6];
+    keylog.profile = data[7] & ~PS2_KEYLOG_USB_MODE;
+    keylog.usb_mode = data[7] & PS2_KEYLOG_USB_MODE;
+
+    uint64_t time_ns = 0;
+    for (uint32_t pos = PS2_KEYLOG_HEADER_SIZE; pos < len;) {
+        uint64_t head = 0;
+        uint8_t shift = 0;
+        uint8_t byte;
+        do {
+            if (pos >= len || shift > 28) {
+                fprintf(stderr, "%s: key log cut short after %u events\n", path, (unsigned)keylog.count);
+                return keylog.count > 0;
+            }
+            byte = data[pos++];
+            head |= (uint64_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        if (pos + 2 > len) {
+            fprintf(stderr, "%s: key log cut short after %u events\n", path, (unsigned)keylog.count);
+            return keylog.count > 0;
+        }
+
+        if (keylog.count == keylog.capacity) {
+            keylog.events = replay_grow(keylog.events, &keylog.capacity, sizeof(replay_event_t));
+        }
+        replay_event_t *event = &keylog.events[keylog.count++];
+        uint64_t delta_us = head >> 1;
+        if (delta_us || keylog.count == 1) {
+            keylog.scans++;
+        }
+        time_ns += delta_us * 1000;
+        *event = (replay_event_t){
+            .time_ns = time_ns,
+            .scan = keylog.scans,
+            .keycode = data[pos] | data[pos + 1] << 8,
+            .pressed = head & 1,
+            .seq = -1,
+        };
+        pos += 2;
+    }
+    return true;
+}
+
+// =============================================================================
+// WIRE
+// =============================================================================
+// Every byte the keyboard host received, and the Set 2 sequences they form.
+
+typedef enum {
+    SEQ_KEY,         // Make or break an event asked for
+    SEQ_REPEAT,      // Make of a key the host already holds
+    SEQ_UNEXPECTED,  // Make or break no event explains
+    SEQ_RESPONSE,    // ACK, BAT and friends
+    SEQ_OTHER,       // Unknown code, or not Set 2
+} seq_kind_t;
+
+typedef struct {
+    uint32_t first;  // Byte indexes
+    uint32_t last;
+    uint16_t keycode;
+    bool make;
+    seq_kind_t kind;
+} replay_seq_t;
+
+typedef struct {
+    uint64_t time_ns;  // Stop bit
+    uint8_t byte;
+} replay_byte_t;
+
+static struct {
+    replay_byte_t *rx;
+    uint32_t count;
+    uint32_t capacity;
+    replay_seq_t *seqs;
+    uint32_t seq_count;
+    uint32_t seq_capacity;
+} wire;
+
+// After every loop, so the host's receive log never fills up
+static void wire_collect(void) {
+    static uint8_t bytes[65536];
+    static uint64_t times[65536];
+    uint32_t count = sim_host_received_at(bytes, times, sizeof(bytes));
+    for (uint32_t i = 0; i < count; i++) {
+        if (wire.count == wire.capacity) {
+            wire.rx = replay_grow(wire.rx, &wire.capacity, sizeof(replay_byte_t));
+        }
+        wire.rx[wire.count++] = (replay_byte_t){times[i], bytes[i]};
+    }
+}
+
+static replay_seq_t *wire_add_seq(uint32_t first, uint32_t last, seq_kind_t kind) {
+    if (wire.seq_count == wire.seq_capacity) {
+        wire.seqs = replay_grow(wire.seqs, &wire.seq_capacity, sizeof(replay_seq_t));
+    }
+    replay_seq_t *seq = &wire.seqs[wire.seq_count++];
+    *seq = (replay_seq_t){.first = first, .last = last, .keycode = KC_NO, .kind = kind};
+    return seq;
+}
+
+static bool wire_is_response(uint8_t byte) {
+    switch (byte) {
+        case PS2_ACK: case PS2_RESEND: case PS2_BAT_SUCCESS: case PS2_BAT_FAIL: case PS2_ECHO_RESPONSE:
+        case 0x00: case 0xFF:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Split the bytes into sequences. PrintScreen's fake shift (E0 12 before
+// the make, E0 F0 12 after the break) goes with the key.
+static void wire_decode(bool set2) {
+    uint32_t first = 0;
+    bool e0 = false, f0 = false;
+    uint8_t pause = 0;
+
+    for (uint32_t i = 0; i < wire.count; i++) {
+        uint8_t byte = wire.rx[i].byte;
+        if (!set2) {
+            wire_add_seq(i, i, SEQ_OTHER);
+            continue;
+        }
+        if (pause) {
+            if (--pause == 0) {
+                replay_seq_t *seq = wire_add_seq(first, i, SEQ_KEY);
+                seq->keycode = KC_PAUSE;
+                seq->make = true;
+                first = i + 1;
+            }
+            continue;
+        }
+        if (!e0 && !f0 && first == i && wire_is_response(byte)) {
+            wire_add_seq(i, i, SEQ_RESPONSE);
+            first = i + 1;
+            continue;
+        }
+        if (byte == PS2_PREFIX_E0 || byte == PS2_PREFIX_F0 || byte == PS2_PREFIX_E1) {
+            e0 |= byte == PS2_PREFIX_E0;
+            f0 |= byte == PS2_PREFIX_F0;
+            pause = byte == PS2_PREFIX_E1 ? 7 : 0;
+            continue;
+        }
+
+        uint16_t keycode = ps2_keycode_for_scancode(e0 ? PS2_PREFIX_E0 : 0, byte);
+        bool fake_shift = keycode == KC_NO && e0 && byte == 0x12;
+        if (fake_shift && !f0) {
+            // Keep it for the key it comes before
+        } else if (fake_shift && wire.seq_count > 0 && wire.seqs[wire.seq_count - 1].last + 1 == first) {
+            wire.seqs[wire.seq_count - 1].last = i;
+            first = i + 1;
+        } else {
+            replay_seq_t *seq = wire_add_seq(first, i, keycode == KC_NO ? SEQ_OTHER : SEQ_KEY);
+            seq->keycode = keycode;
+            seq->make = !f0;
+            first = i + 1;
+        }
+        e0 = false;
+        f0 = false;
+    }
+}
+
+// Pause and the make-only keys send nothing on release
+static bool replay_has_break(uint16_t keycode) {
+    ps2_special_key_type_t type = ps2_scancode_for_keycode(PS2_SCANCODE_SET_2, keycode).special_type;
+    return type != PS2_KEY_PAUSE && type != PS2_KEY_MAKE_ONLY;
+}
+
+// Pair each make/break with the oldest event for that key still waiting
+// for one; a make of a key the host already holds is a repeat
+static void wire_match(void) {
+    static bool held[256];
+    uint32_t from = 0;  // Oldest event still waiting for anything
+
+    for (uint32_t s = 0; s < wire.seq_count; s++) {
+        replay_seq_t *seq = &wire.seqs[s];
+        if (seq->kind != SEQ_KEY) {
+            continue;
+        }
+        uint8_t key = seq->keycode & 0xFF;
+        if (seq->make && held[key] && replay_has_break(seq->keycode)) {
+            seq->kind = SEQ_REPEAT;
+            continue;
+        }
+        held[key] = seq->make && replay_has_break(seq->keycode);
+
+        while (from < keylog.count && (!keylog.events[from].wire_due || keylog.events[from].seq >= 0)) {
+            from++;
+        }
+        seq->kind = SEQ_UNEXPECTED;
+        for (uint32_t e = from; e < keylog.count; e++) {
+            replay_event_t *event = &keylog.events[e];
+            if (event->fed_ns > wire.rx[seq->last].time_ns) {
+                break;
+            }
+            if (event->wire_due && event->seq < 0 && event->keycode == seq->keycode && event->pressed == seq->make) {
+                event->seq = s;
+                seq->kind = SEQ_KEY;
+                break;
+            }
+        }
+    }
+}
+
+// =============================================================================
+// RUN
+// =============================================================================
+
+static uint32_t next_event = 0;
+static uint64_t start_ns = 0;
+
+// One matrix scan's worth of events
+static void replay_scan(void *ctx) {
+    (void)ctx;
+    uint32_t scan = keylog.events[next_event].scan;
+    while (next_event < keylog.count && keylog.events[next_event].scan == scan) {
+        replay_event_t *event = &keylog.events[next_event++];
+        event->fed_ns = sim_now_ns() - start_ns;
+        sim_key_event(event->keycode, event->pressed);
+    }
+}
+
+static void replay_command(uint8_t byte) {
+    sim_host_send(byte);
+    sim_run_ms(REPLAY_COMMAND_MS);
+}
+
+// Power up, Reset from the host, then the host settings from the log
+static bool replay_setup(void) {
+    sim_boot(!keylog.usb_mode);
+    sim_host_reset();
+    replay_command(PS2_CMD_RESET);
+    sim_run_ms(100);
+    uint8_t reply[16];
+    uint32_t len = sim_host_received(reply, sizeof(reply));
+    if (len < 2 || reply[0] != PS2_ACK || reply[1] != PS2_BAT_SUCCESS) {
+        return false;
+    }
+
+    if (keylog.set != PS2_SCANCODE_SET_2) {
+        replay_command(PS2_CMD_SET_SCANCODE_SET);
+        replay_command(keylog.set);
+    }
+    if (keylog.typematic != PS2_TYPEMATIC_DEFAULT) {
+        replay_command(PS2_CMD_SET_TYPEMATIC);
+        replay_command(keylog.typematic);
+    }
+    if (keylog.profile != ps2_keyboard_get_timing_profile()) {
+        ps2_keyboard_set_timing_profile(keylog.profile);
+    }
+    sim_run_ms(REPLAY_COMMAND_MS);
+    sim_host_received(NULL, 0);
+    return ps2_keyboard_get_scancode_set() == keylog.set;
+}
+
+// Feed each scan at its recorded time: an idle loop when it is further off,
+// else the loop whose matrix scan lands on it
+static void replay_run(void) {
+    // Only Set 2 is decoded, so only Set 2 bytes can be matched to events
+    for (uint32_t i = 0; i < keylog.count && keylog.set == PS2_SCANCODE_SET_2; i++) {
+        replay_event_t *event = &keylog.events[i];
+        event->wire_due = ps2_scancode_for_keycode(PS2_SCANCODE_SET_2, event->keycode).scancode != 0 &&
+                          (event->pressed || replay_has_break(event->keycode));
+    }
+
+    sim_bus_stats_reset();
+    sim_edges_clear();
+    sim_qmk_stats_reset();
+    ps2_stats_reset();
+    start_ns = sim_now_ns();
+
+    while (next_event < keylog.count) {
+        uint64_t due = start_ns + keylog.events[next_event].time_ns;
+        uint64_t now = sim_now_ns();
+        if (due < now + 2 * SIM_SCAN_NS) {
+            if (due > now + SIM_SCAN_NS) {
+                sim_advance_to_ns(due - SIM_SCAN_NS);
+            }
+            sim_loop_once(replay_scan, NULL);
+        } else {
+            sim_loop_once(NULL, NULL);
+        }
+        wire_collect();
+    }
+
+    uint32_t quiet = 0;
+    uint32_t last_edges = 0;
+    sim_edges(&last_edges);
+    for (uint32_t ms = 0; ms < REPLAY_DRAIN_LIMIT_MS && quiet < REPLAY_QUIET_MS; ms++) {
+        sim_run_ms(1);
+        wire_collect();
+        uint32_t edges = 0;
+        sim_edges(&edges);
+        quiet = edges == last_edges ? quiet + 1 : 0;
+        last_edges = edges;
+    }
+}
+
+// =============================================================================
+// REPORT
+// =============================================================================
+
+static void replay_key_name(uint16_t keycode, char *text, size_t size) {
+    if (keycode < 256 && ps2_key_names[keycode]) {
+        snprintf(text, size, "%s", ps2_key_names[keycode]);
+    } else {
+        snprintf(text, size, "0x%04X", keycode);
+    }
+}
+
+static void replay_seq_bytes(const replay_seq_t *seq, char *text, size_t size) {
+    size_t used = 0;
+    text[0] = '\0';
+    for (uint32_t i = seq->first; i <= seq->last && used + 4 < size; i++) {
+        used += snprintf(text + used, size - used, i == seq->first ? "%02X" : " %02X", wire.rx[i].byte);
+    }
+}
+
+static void replay_print_event(const replay_event_t *event) {
+    char name[40], bytes[64], latency[16];
+    char key[32];
+    replay_key_name(event->keycode, key, sizeof(key));
+    snprintf(name, sizeof(name), "%s %s", key, event->pressed ? "down" : "up");
+    bytes[0] = '\0';
+    if (event->seq >= 0) {
+        const replay_seq_t *seq = &wire.seqs[event->seq];
+        replay_seq_bytes(seq, bytes, sizeof(bytes));
+        snprintf(latency, sizeof(latency), "%.1f", (wire.rx[seq->last].time_ns - start_ns - event->fed_ns) / 1000.0);
+    } else {
+        snprintf(latency, sizeof(latency), "%s", event->wire_due ? "lost" : "-");
+    }
+    printf("%12.3f  %-24s %10s%s%s\n", event->fed_ns / 1e6, name, latency, bytes[0] ? "  " : "", bytes);
+}
+
+static void replay_print_seq(const replay_seq_t *seq) {
+    static const char *const kinds[] = {
+        [SEQ_REPEAT] = "repeat",
+        [SEQ_UNEXPECTED] = "unexpected",
+        [SEQ_RESPONSE] = "response",
+        [SEQ_OTHER] = "other",
+    };
+    char name[40], bytes[64], key[32];
+    replay_key_name(seq->keycode, key, sizeof(key));
+    if (seq->kind == SEQ_REPEAT || seq->kind == SEQ_UNEXPECTED) {
+        snprintf(name, sizeof(name), "%s %s", key, seq->kind == SEQ_REPEAT ? "repeat" : seq->make ? "make" : "break");
+    } else {
+        snprintf(name, sizeof(name), "(%s)", kinds[seq->kind]);
+    }
+    replay_seq_bytes(seq, bytes, sizeof(bytes));
+    printf("%12.3f  %-24s %10s  %s%s\n", (wire.rx[seq->last].time_ns - start_ns) / 1e6, name, "", bytes,
+           seq->kind == SEQ_UNEXPECTED ? "  (no event)" : "");
+}
+
+// Events at the time they were fed, the sequences no event claimed at the
+// time their last byte arrived
+static void replay_print_timeline(void) {
+    printf("%12s  %-24s %10s  %s\n", "time ms", "event", "latency us", "wire");
+    uint32_t s = 0;
+    for (uint32_t e = 0; e <= keylog.count; e++) {
+        uint64_t until = e < keylog.count ? keylog.events[e].fed_ns : UINT64_MAX;
+        for (; s < wire.seq_count && wire.rx[wire.seqs[s].last].time_ns - start_ns < until; s++) {
+            if (wire.seqs[s].kind != SEQ_KEY) {
+                replay_print_seq(&wire.seqs[s]);
+            }
+        }
+        if (e < keylog.count) {
+            replay_print_event(&keylog.events[e]);
+        }
+    }
+    printf("\n");
+}
+
+static void replay_print_latency(const char *label, sim_samples_t *samples) {
+    printf("%-12s %8u %9.1f %9.1f %9.1f %9.1f\n", label, (unsigned)samples->count,
+           sim_samples_percentile(samples, 0) / 1000.0, sim_samples_percentile(samples, 50) / 1000.0,
+           sim_samples_percentile(samples, 99) / 1000.0, sim_samples_percentile(samples, 100) / 1000.0);
+}
+
+// Summary; false if an event was lost or the host ends up out of step
+static bool replay_print_summary(void) {
+    static sim_samples_t presses, releases;
+    uint32_t lost = 0;
+    int32_t held = 0;  // Keys the log leaves down (extra keys aside)
+    for (uint32_t i = 0; i < keylog.count; i++) {
+        replay_event_t *event = &keylog.events[i];
+        if (event->wire_due && event->seq < 0) {
+            lost++;
+        }
+        if (event->seq >= 0) {
+            uint64_t ns = wire.rx[wire.seqs[event->seq].last].time_ns - start_ns - event->fed_ns;
+            sim_samples_add(event->pressed ? &presses : &releases, ns);
+        }
+        bool extra = event->keycode >= KC_SYSTEM_POWER && event->keycode <= KC_WWW_FAVORITES;
+        if (event->wire_due && !extra && replay_has_break(event->keycode)) {
+            held += event->pressed ? 1 : -1;
+        }
+    }
+    uint32_t counts[SEQ_OTHER + 1] = {0};
+    for (uint32_t s = 0; s < wire.seq_count; s++) {
+        counts[wire.seqs[s].kind]++;
+    }
+
+    const sim_bus_stats_t *bus = sim_bus_stats();
+    uint64_t span_ns = keylog.count ? keylog.events[keylog.count - 1].fed_ns : 0;
+    printf("log          %u events in %u scans over %.3f s, Set %u, typematic 0x%02X, %s mode\n",
+           (unsigned)keylog.count, (unsigned)keylog.scans, span_ns / 1e9, keylog.set, keylog.typematic,
+           keylog.usb_mode ? "USB" : "PS/2");
+    printf("wire         %u bytes: %u repeats, %u unexpected, %u responses, %u other, %u frame errors\n",
+           (unsigned)wire.count, (unsigned)counts[SEQ_REPEAT], (unsigned)counts[SEQ_UNEXPECTED],
+           (unsigned)counts[SEQ_RESPONSE], (unsigned)counts[SEQ_OTHER], (unsigned)bus->frame_errors);
+
+    bool ok = lost == 0 && bus->frame_errors == 0;
+    if (keylog.set == PS2_SCANCODE_SET_2) {
+        ok = ok && (int32_t)sim_host_keys_held() == held;
+        printf("host         %u lost, %u keys held at the end (log: %d)\n", (unsigned)lost,
+               (unsigned)sim_host_keys_held(), (int)held);
+        printf("\n%-12s %8s %9s %9s %9s %9s\n", "latency us", "count", "min", "p50", "p99", "max");
+        replay_print_latency("down", &presses);
+        replay_print_latency("up", &releases);
+    } else {
+        printf("host         Set %u: bytes not matched to events\n", keylog.set);
+    }
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    const char *vcd_path = NULL;
+    bool quiet = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-q")) {
+            quiet = true;
+        } else if (!strcmp(argv[i], "-v")) {
+            sim_verbose = true;
+        } else if (!strcmp(argv[i], "--vcd") && i + 1 < argc) {
+            vcd_path = argv[++i];
+        } else if (!strcmp(argv[i], "--irq-latency") && i + 1 < argc) {
+            sim_irq_latency(strtoul(argv[++i], NULL, 0));
+        } else if (!path && (argv[i][0] != '-' || !strcmp(argv[i], "-"))) {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "usage: %s [-q] [-v] [--vcd file] [--irq-latency ns] file|-\n", argv[0]);
+        return 2;
+    }
+    if (!keylog_load(path)) {
+        return 2;
+    }
+
+    if (!replay_setup()) {
+        fprintf(stderr, "replay: keyboard did not come up in Set %u\n", keylog.set);
+        return 1;
+    }
+    if (vcd_path && !sim_vcd_open(vcd_path)) {
+        perror(vcd_path);
+    }
+    replay_run();
+    sim_vcd_close();
+
+    wire_decode(keylog.set == PS2_SCANCODE_SET_2);
+    wire_match();
+    if (!quiet) {
+        replay_print_timeline();
+    }
+    bool ok = replay_print_summary();
+    if (sim_verbose) {
+        ps2_stats_dump();
+    }
+    return ok ? 0 : 1;
+}
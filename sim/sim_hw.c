@@ -0,0 +1,771 @@
+// sim_hw.c - Simulated RP2040 + PS/2 host for running the driver on Linux
+//
+// Provides the gpio.h, timer.h, wait.h and ch.h stubs the driver is built
+// against. Time only moves when the firmware waits or reads a timer, or when
+// the simulation advances it between main loop iterations; due virtual
+// timers run at their exact deadline on the way, unless the firmware holds
+// the system lock.
+#include "sim_hw.h"
+#include "gpio.h"
+#include "timer.h"
+#include "wait.h"
+#include "ch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_PINS 32
+
+// Host timing (ns): how long it holds CLK low to request to send, and how
+// long it waits after one byte before sending the next
+#define SIM_HOST_INHIBIT_NS  100000
+#define SIM_HOST_SPACING_NS  500000
+
+// A device frame that stalls this long mid-byte was abandoned
+#define SIM_FRAME_TIMEOUT_NS 2000000
+
+// =============================================================================
+// CLOCK AND VIRTUAL TIMERS
+// =============================================================================
+
+static uint64_t now_ns = 0;
+static virtual_timer_t *timers = NULL;  // Armed, in no particular order
+static int lock_depth = 0;
+static bool in_isr = false;
+
+static uint64_t sim_host_next_deadline(void);
+static void sim_host_run_due(uint64_t time_ns);
+
+uint64_t sim_now_ns(void) {
+    return now_ns;
+}
+
+static virtual_timer_t *sim_next_timer(void) {
+    virtual_timer_t *next = NULL;
+    for (virtual_timer_t *vtp = timers; vtp; vtp = vtp->next) {
+        if (!next || vtp->deadline_ns < next->deadline_ns) {
+            next = vtp;
+        }
+    }
+    return next;
+}
+
+static void sim_timer_unlink(virtual_timer_t *vtp) {
+    for (virtual_timer_t **link = &timers; *link; link = &(*link)->next) {
+        if (*link == vtp) {
+            *link = vtp->next;
+            break;
+        }
+    }
+    vtp->armed = false;
+    vtp->next = NULL;
+}
+
+void sim_advance_to_ns(uint64_t time_ns) {
+    // Timer callbacks may read the clock themselves: that only moves time
+    if (in_isr) {
+        if (time_ns > now_ns) {
+            now_ns = time_ns;
+        }
+        return;
+    }
+
+    while (true) {
+        virtual_timer_t *vtp = lock_depth == 0 ? sim_next_timer() : NULL;
+        uint64_t host_deadline_ns = sim_host_next_deadline();
+        bool host_due = host_deadline_ns != 0 && host_deadline_ns <= time_ns;
+        bool timer_due = vtp && vtp->deadline_ns <= time_ns;
+        if (!host_due && !timer_due) {
+            break;
+        }
+
+        if (host_due && (!timer_due || host_deadline_ns <= vtp->deadline_ns)) {
+            if (host_deadline_ns > now_ns) {
+                now_ns = host_deadline_ns;
+            }
+            sim_host_run_due(host_deadline_ns);
+            continue;
+        }
+
+        if (vtp->deadline_ns > now_ns) {
+            now_ns = vtp->deadline_ns;
+        }
+        sim_timer_unlink(vtp);
+        in_isr = true;
+        vtp->func(vtp, vtp->par);
+        in_isr = false;
+    }
+
+    if (time_ns > now_ns) {
+        now_ns = time_ns;
+    }
+}
+
+void sim_advance_ns(uint64_t ns) {
+    sim_advance_to_ns(now_ns + ns);
+}
+
+// Other interrupts: each timer callback runs up to this much late
+static uint32_t irq_latency_ns = 0;
+static uint32_t irq_latency_seed = 1;
+
+void sim_irq_latency(uint32_t max_ns) {
+    irq_latency_ns = max_ns;
+}
+
+static uint64_t sim_irq_delay_ns(void) {
+    if (irq_latency_ns == 0) {
+        return 0;
+    }
+    irq_latency_seed = irq_latency_seed * 1103515245 + 12345;
+    return (irq_latency_seed >> 8) % (irq_latency_ns + 1);
+}
+
+void chVTObjectInit(virtual_timer_t *vtp) {
+    memset(vtp, 0, sizeof(*vtp));
+}
+
+void chVTSetI(virtual_timer_t *vtp, sysinterval_t delay, vtfunc_t vtfunc, void *par) {
+    if (vtp->armed) {
+        sim_timer_unlink(vtp);
+    }
+    vtp->deadline_ns = now_ns + (uint64_t)delay * 1000 + sim_irq_delay_ns();
+    vtp->func = vtfunc;
+    vtp->par = par;
+    vtp->armed = true;
+    vtp->next = timers;
+    timers = vtp;
+}
+
+void chVTResetI(virtual_timer_t *vtp) {
+    if (vtp->armed) {
+        sim_timer_unlink(vtp);
+    }
+}
+
+bool chVTIsArmedI(const virtual_timer_t *vtp) {
+    return vtp->armed;
+}
+
+systime_t chVTGetSystemTimeX(void) {
+    sim_advance_ns(SIM_TIMER_READ_NS);
+    return (systime_t)(now_ns / 1000);
+}
+
+void chSysLock(void) {
+    lock_depth++;
+}
+
+void chSysUnlock(void) {
+    // Timers that came due while locked fire as soon as the lock is gone
+    if (--lock_depth == 0) {
+        sim_advance_to_ns(now_ns);
+    }
+}
+
+void chSysLockFromISR(void) {
+    lock_depth++;
+}
+
+void chSysUnlockFromISR(void) {
+    lock_depth--;
+}
+
+uint32_t timer_read32(void) {
+    sim_advance_ns(SIM_TIMER_READ_NS);
+    return (uint32_t)(now_ns / 1000000);
+}
+
+uint16_t timer_read(void) {
+    return (uint16_t)timer_read32();
+}
+
+uint16_t timer_elapsed(uint16_t last) {
+    return (uint16_t)(timer_read() - last);
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return timer_read32() - last;
+}
+
+// On ChibiOS these may sleep the thread: not allowed in a timer callback or
+// under chSysLock()
+static void sim_check_can_sleep(const char *what) {
+    if (in_isr || lock_depth) {
+        fprintf(stderr, "sim: %s() %s\n", what, in_isr ? "in a timer callback" : "with the system locked");
+        abort();
+    }
+}
+
+void wait_us(unsigned us) {
+    sim_check_can_sleep("wait_us");
+    sim_advance_ns((uint64_t)us * 1000);
+}
+
+void wait_ms(unsigned ms) {
+    sim_check_can_sleep("wait_ms");
+    sim_advance_ns((uint64_t)ms * 1000000);
+}
+
+
+// =============================================================================
+// OPEN DRAIN WIRES
+// =============================================================================
+// A bus line is high unless the device or the host pulls it low. Other pins
+// read their external level (mode switch) or the pullup. An attached host's
+// pull-ups hold its lines high against the firmware's pull-downs; without a
+// host a line with the pull-down on reads low.
+
+static bool pin_output[SIM_PINS];
+static bool pin_latch_low[SIM_PINS];
+static bool pin_host_low[SIM_PINS];
+static bool pin_pulldown[SIM_PINS];
+static bool pin_host_pullup[SIM_PINS];
+static bool pin_external[SIM_PINS];
+static bool pin_external_level[SIM_PINS];
+
+static sim_edge_t *edges = NULL;
+static uint32_t edge_count = 0;
+static uint32_t edge_capacity = 0;
+static FILE *vcd = NULL;
+
+typedef enum {
+    HOST_LISTEN,    // Receiving whatever the device clocks out
+    HOST_INHIBIT,   // Holding CLK low before a request-to-send
+    HOST_TX_BITS,   // Device clocks our data bits in
+    HOST_TX_ACK,    // Waiting for the device's ACK pulse to end
+    HOST_BUSY,      // Holding CLK low to stall the device (inhibit)
+} sim_host_mode_t;
+
+#define SIM_HOST_TX_FIFO 16
+#define SIM_HOST_RX_LOG  65536
+
+// One host port: its two wires and the host model listening on them
+typedef struct {
+    uint8_t clk;               // 0xFF = not attached
+    uint8_t data;
+    bool clk_level;
+    bool data_level;
+    uint64_t deadline_ns;      // 0 = no host event pending
+
+    sim_host_mode_t mode;
+
+    // Device->host frame being received
+    int8_t rx_bit;             // -1 = waiting for a start bit
+    uint16_t rx_frame;
+    uint64_t last_fall_ns;
+    uint64_t last_rise_ns;
+    bool clocking;             // Inside a frame in either direction
+
+    // Host->device
+    uint8_t tx_fifo[SIM_HOST_TX_FIFO];
+    uint8_t tx_head;
+    uint8_t tx_count;
+    uint16_t tx_frame;         // Data, parity, stop
+    uint8_t tx_bit;
+
+    // Busy host: holds CLK low for busy_ns every busy_period_ns
+    uint64_t busy_period_ns;   // 0 = never
+    uint64_t busy_ns;
+    uint32_t busy_cuts;        // Device frames a hold cut off
+
+    uint8_t rx_log[SIM_HOST_RX_LOG];
+    uint64_t rx_log_ns[SIM_HOST_RX_LOG];  // Stop bit of each
+    uint32_t rx_log_count;
+
+    // Set 2 decoder
+    bool e0;
+    bool f0;
+    uint8_t skip;              // Rest of the Pause sequence
+    bool held[256];            // Make code | 0x80 for E0 keys
+    uint8_t held_count;
+    uint32_t makes;
+
+    sim_bus_stats_t stats;
+} sim_host_t;
+
+static sim_host_t hosts[SIM_BUSES] = {
+    [0 ... SIM_BUSES - 1] = {.clk = 0xFF, .data = 0xFF, .clk_level = true, .data_level = true, .rx_bit = -1},
+};
+static sim_host_t *selected = &hosts[0];  // What the sim_host_*() calls act on
+
+static void sim_host_on_edge(sim_host_t *host, bool clk, bool level);
+
+static bool sim_line(uint8_t pin) {
+    if (pin >= SIM_PINS) {
+        return true;
+    }
+    if (pin_external[pin]) {
+        return pin_external_level[pin];
+    }
+    if ((pin_output[pin] && pin_latch_low[pin]) || pin_host_low[pin]) {
+        return false;
+    }
+    return pin_host_pullup[pin] || pin_output[pin] || !pin_pulldown[pin];
+}
+
+// VCD identifier: c/d for bus 0, e/f for bus 1, ...
+static char sim_vcd_id(uint8_t bus, bool clk) {
+    return 'c' + bus * 2 + (clk ? 0 : 1);
+}
+
+static void sim_edge_log(uint8_t bus, uint8_t pin, bool level) {
+    if (edge_count == edge_capacity) {
+        edge_capacity = edge_capacity ? edge_capacity * 2 : 4096;
+        edges = realloc(edges, edge_capacity * sizeof(*edges));
+        if (!edges) {
+            perror("sim: edge log");
+            exit(1);
+        }
+    }
+    edges[edge_count++] = (sim_edge_t){.time_ns = now_ns, .pin = pin, .level = level};
+
+    if (vcd) {
+        fprintf(vcd, "#%llu\n%d%c\n", (unsigned long long)now_ns, level, sim_vcd_id(bus, pin == hosts[bus].clk));
+    }
+}
+
+// Re-evaluate every bus line after anything drove them
+static void sim_bus_update(void) {
+    for (uint8_t bus = 0; bus < SIM_BUSES; bus++) {
+        sim_host_t *host = &hosts[bus];
+        if (host->clk >= SIM_PINS) {
+            continue;
+        }
+        bool clk = sim_line(host->clk);
+        bool data = sim_line(host->data);
+        if (data != host->data_level) {
+            host->data_level = data;
+            sim_edge_log(bus, host->data, data);
+            sim_host_on_edge(host, false, data);
+        }
+        if (clk != host->clk_level) {
+            host->clk_level = clk;
+            sim_edge_log(bus, host->clk, clk);
+            sim_host_on_edge(host, true, clk);
+        }
+    }
+}
+
+void setPinInput(pin_t pin) {
+    pin_output[pin] = false;
+    pin_pulldown[pin] = false;
+    sim_bus_update();
+}
+
+void setPinInputHigh(pin_t pin) {
+    setPinInput(pin);
+}
+
+void setPinInputLow(pin_t pin) {
+    pin_output[pin] = false;
+    pin_pulldown[pin] = true;
+    sim_bus_update();
+}
+
+void setPinOutput(pin_t pin) {
+    pin_output[pin] = true;
+    sim_bus_update();
+}
+
+void writePinLow(pin_t pin) {
+    pin_latch_low[pin] = true;
+    sim_bus_update();
+}
+
+void writePinHigh(pin_t pin) {
+    pin_latch_low[pin] = false;
+    sim_bus_update();
+}
+
+bool readPin(pin_t pin) {
+    return sim_line(pin);
+}
+
+void sim_bus_select(uint8_t bus) {
+    if (bus < SIM_BUSES) {
+        selected = &hosts[bus];
+    }
+}
+
+void sim_bus_attach(uint8_t clk_pin, uint8_t data_pin) {
+    pin_host_pullup[clk_pin] = true;
+    pin_host_pullup[data_pin] = true;
+    selected->clk = clk_pin;
+    selected->data = data_pin;
+    selected->clk_level = sim_line(clk_pin);
+    selected->data_level = sim_line(data_pin);
+}
+
+void sim_bus_detach(void) {
+    sim_host_t *host = selected;
+    if (host->clk >= SIM_PINS) {
+        return;
+    }
+    pin_host_pullup[host->clk] = false;
+    pin_host_pullup[host->data] = false;
+    pin_host_low[host->clk] = false;
+    pin_host_low[host->data] = false;
+    host->clk = 0xFF;
+    host->data = 0xFF;
+    host->deadline_ns = 0;
+    host->mode = HOST_LISTEN;
+    host->tx_count = 0;
+}
+
+void sim_pin_set_external(uint8_t pin, bool level) {
+    pin_external[pin] = true;
+    pin_external_level[pin] = level;
+}
+
+const sim_edge_t *sim_edges(uint32_t *count) {
+    *count = edge_count;
+    return edges;
+}
+
+void sim_edges_clear(void) {
+    edge_count = 0;
+}
+
+bool sim_vcd_open(const char *path) {
+    vcd = fopen(path, "w");
+    if (!vcd) {
+        return false;
+    }
+    fprintf(vcd, "$timescale 1ns $end\n$scope module ps2 $end\n");
+    for (uint8_t bus = 0; bus < SIM_BUSES; bus++) {
+        if (hosts[bus].clk < SIM_PINS) {
+            fprintf(vcd, "$var wire 1 %c clk%u $end\n$var wire 1 %c data%u $end\n", sim_vcd_id(bus, true), bus,
+                    sim_vcd_id(bus, false), bus);
+        }
+    }
+    fprintf(vcd, "$upscope $end\n$enddefinitions $end\n#%llu\n", (unsigned long long)now_ns);
+    for (uint8_t bus = 0; bus < SIM_BUSES; bus++) {
+        if (hosts[bus].clk < SIM_PINS) {
+            fprintf(vcd, "%d%c\n%d%c\n", hosts[bus].clk_level, sim_vcd_id(bus, true), hosts[bus].data_level,
+                    sim_vcd_id(bus, false));
+        }
+    }
+    return true;
+}
+
+void sim_vcd_close(void) {
+    if (vcd) {
+        fclose(vcd);
+        vcd = NULL;
+    }
+}
+
+// =============================================================================
+// HOST MODEL
+// =============================================================================
+// Decodes device frames on the falling clock edge like a real host, checks
+// start, parity and stop bits and the clock timing, and tracks which keys
+// it believes are held by decoding Set 2 make/break codes. One instance per
+// attached bus; each only sees its own two wires.
+
+static void sim_host_decode_set2(sim_host_t *host, uint8_t byte) {
+    if (host->skip) {
+        host->skip--;
+        return;
+    }
+    switch (byte) {
+        case 0xE0:
+            host->e0 = true;
+            return;
+        case 0xF0:
+            host->f0 = true;
+            return;
+        case 0xE1:
+            host->skip = 7;  // E1 14 77 E1 F0 14 F0 77 has no break
+            host->makes++;
+            return;
+        case 0xF1: case 0xF2:  // Hanja/Hangul, make only
+            if (!host->e0 && !host->f0) {
+                host->makes++;
+                return;
+            }
+            break;
+        case 0x00: case 0xAA: case 0xEE: case 0xFA: case 0xFC: case 0xFE: case 0xFF:
+            if (!host->e0 && !host->f0) {
+                return;  // Responses, not keys
+            }
+            break;
+    }
+
+    uint8_t key = (byte & 0x7F) | (host->e0 ? 0x80 : 0);
+    if (byte == 0x83) {
+        key = 0x7F | (host->e0 ? 0x80 : 0);  // F7, the one code above 0x7F
+    }
+    if (host->f0) {
+        if (host->held[key]) {
+            host->held[key] = false;
+            host->held_count--;
+        }
+    } else if (!host->held[key]) {
+        host->held[key] = true;
+        host->held_count++;
+        host->makes++;
+    }
+    host->e0 = false;
+    host->f0 = false;
+}
+
+static void sim_host_frame_done(sim_host_t *host) {
+    uint16_t frame = host->rx_frame;
+    uint8_t byte = (frame >> 1) & 0xFF;
+    bool parity_ok = (__builtin_popcount((frame >> 1) & 0x1FF) & 1) == 1;
+    bool stop_ok = (frame >> 10) & 1;
+
+    host->rx_bit = -1;
+    host->clocking = false;
+    host->stats.last_frame_ns = now_ns;
+    if (!parity_ok || !stop_ok) {
+        host->stats.frame_errors++;
+        return;
+    }
+    host->stats.frames++;
+    if (host->rx_log_count < SIM_HOST_RX_LOG) {
+        host->rx_log_ns[host->rx_log_count] = now_ns;
+        host->rx_log[host->rx_log_count++] = byte;
+    }
+    sim_host_decode_set2(host, byte);
+}
+
+static void sim_host_note_half_period(uint32_t *min, uint32_t *max, uint64_t since) {
+    uint32_t ns = (uint32_t)(now_ns - since);
+    if (*min == 0 || ns < *min) {
+        *min = ns;
+    }
+    if (ns > *max) {
+        *max = ns;
+    }
+}
+
+static void sim_host_start_next(sim_host_t *host) {
+    if (host->tx_count == 0) {
+        return;
+    }
+    uint8_t byte = host->tx_fifo[host->tx_head];
+    host->tx_head = (host->tx_head + 1) % SIM_HOST_TX_FIFO;
+    host->tx_count--;
+
+    uint8_t parity = !(__builtin_popcount(byte) & 1);
+    host->tx_frame = byte | (parity << 8) | (1 << 9);
+    host->tx_bit = 0;
+
+    // Whatever the device was sending is cut off
+    host->rx_bit = -1;
+    host->clocking = false;
+    host->mode = HOST_INHIBIT;
+    pin_host_low[host->clk] = true;
+    sim_bus_update();
+    host->deadline_ns = now_ns + SIM_HOST_INHIBIT_NS;
+}
+
+// Grab the clock whatever the device is doing. A frame in flight is lost:
+// the device has to notice and send it again.
+static void sim_host_busy_start(sim_host_t *host) {
+    if (host->rx_bit >= 0) {
+        host->busy_cuts++;
+    }
+    host->rx_bit = -1;
+    host->clocking = false;
+    host->mode = HOST_BUSY;
+    pin_host_low[host->clk] = true;
+    sim_bus_update();
+    host->deadline_ns = now_ns + host->busy_ns;
+}
+
+static void sim_host_event(sim_host_t *host) {
+    if (host->mode == HOST_BUSY) {
+        host->mode = HOST_LISTEN;
+        pin_host_low[host->clk] = false;
+        sim_bus_update();
+        host->deadline_ns = now_ns + host->busy_period_ns - host->busy_ns;
+    } else if (host->mode == HOST_LISTEN && host->tx_count == 0 && host->busy_period_ns) {
+        sim_host_busy_start(host);
+    } else if (host->mode == HOST_INHIBIT) {
+        // Start bit, then hand the clock to the device
+        host->mode = HOST_TX_BITS;
+        pin_host_low[host->data] = true;
+        pin_host_low[host->clk] = false;
+        sim_bus_update();
+    } else if (host->mode == HOST_LISTEN) {
+        sim_host_start_next(host);
+    }
+}
+
+static uint64_t sim_host_next_deadline(void) {
+    uint64_t next = 0;
+    for (uint8_t bus = 0; bus < SIM_BUSES; bus++) {
+        uint64_t deadline = hosts[bus].deadline_ns;
+        if (deadline != 0 && (next == 0 || deadline < next)) {
+            next = deadline;
+        }
+    }
+    return next;
+}
+
+static void sim_host_run_due(uint64_t time_ns) {
+    for (uint8_t bus = 0; bus < SIM_BUSES; bus++) {
+        if (hosts[bus].deadline_ns != 0 && hosts[bus].deadline_ns <= time_ns) {
+            hosts[bus].deadline_ns = 0;
+            sim_host_event(&hosts[bus]);
+        }
+    }
+}
+
+static void sim_host_on_edge(sim_host_t *host, bool clk, bool level) {
+    if (!clk) {
+        return;
+    }
+
+    if (level) {
+        if (host->clocking) {
+            sim_host_note_half_period(&host->stats.clk_low_min_ns, &host->stats.clk_low_max_ns, host->last_fall_ns);
+        }
+        host->last_rise_ns = now_ns;
+        if (host->mode == HOST_TX_ACK) {
+            host->mode = HOST_LISTEN;
+            host->clocking = false;
+            if (host->tx_count) {
+                host->deadline_ns = now_ns + SIM_HOST_SPACING_NS;
+            } else if (host->busy_period_ns) {
+                host->deadline_ns = now_ns + host->busy_period_ns - host->busy_ns;
+            }
+        }
+        return;
+    }
+
+    // Falling edge
+    if (host->clocking && now_ns - host->last_fall_ns > SIM_FRAME_TIMEOUT_NS) {
+        host->rx_bit = -1;
+        host->clocking = false;
+    }
+    if (host->clocking) {
+        sim_host_note_half_period(&host->stats.clk_high_min_ns, &host->stats.clk_high_max_ns, host->last_rise_ns);
+    }
+    host->last_fall_ns = now_ns;
+
+    switch (host->mode) {
+        case HOST_LISTEN:
+            if (host->rx_bit < 0) {
+                if (host->data_level) {
+                    host->stats.frame_errors++;  // Clock without a start bit
+                    return;
+                }
+                if (host->stats.frames == 0 && host->stats.frame_errors == 0) {
+                    host->stats.first_frame_ns = now_ns;
+                }
+                host->rx_bit = 0;
+                host->rx_frame = 0;
+                host->clocking = true;
+                return;
+            }
+            host->rx_bit++;
+            host->rx_frame |= (uint16_t)host->data_level << host->rx_bit;
+            if (host->rx_bit == 10) {
+                sim_host_frame_done(host);
+            }
+            return;
+
+        case HOST_TX_BITS:
+            host->clocking = true;
+            if (host->tx_bit < 10) {
+                pin_host_low[host->data] = !((host->tx_frame >> host->tx_bit) & 1);
+                host->tx_bit++;
+                sim_bus_update();
+            } else {
+                // ACK clock: the device holds DATA low
+                host->mode = HOST_TX_ACK;
+                if (!host->data_level) {
+                    host->stats.host_frames++;
+                }
+            }
+            return;
+
+        default:
+            return;
+    }
+}
+
+void sim_host_reset(void) {
+    sim_host_t *host = selected;
+    uint8_t clk = host->clk;
+    uint8_t data = host->data;
+    memset(host, 0, sizeof(*host));
+    host->clk = clk;
+    host->data = data;
+    host->rx_bit = -1;
+    if (clk < SIM_PINS) {
+        pin_host_low[clk] = false;
+        pin_host_low[data] = false;
+        host->clk_level = sim_line(clk);
+        host->data_level = sim_line(data);
+        sim_bus_update();
+    }
+}
+
+void sim_host_send(uint8_t byte) {
+    sim_host_t *host = selected;
+    if (host->tx_count == SIM_HOST_TX_FIFO) {
+        fprintf(stderr, "sim: host tx fifo full, dropping %02X\n", byte);
+        return;
+    }
+    host->tx_fifo[(host->tx_head + host->tx_count) % SIM_HOST_TX_FIFO] = byte;
+    host->tx_count++;
+    if (host->mode == HOST_LISTEN && host->deadline_ns == 0) {
+        sim_host_start_next(host);
+    }
+}
+
+bool sim_host_busy(void) {
+    return selected->mode != HOST_LISTEN || selected->tx_count != 0;
+}
+
+void sim_host_inhibit_every(uint32_t period_us, uint32_t hold_us) {
+    sim_host_t *host = selected;
+    host->busy_period_ns = hold_us < period_us ? (uint64_t)period_us * 1000 : 0;
+    host->busy_ns = (uint64_t)hold_us * 1000;
+    if (host->busy_period_ns && host->mode == HOST_LISTEN && host->deadline_ns == 0) {
+        host->deadline_ns = now_ns + host->busy_period_ns - host->busy_ns;
+    }
+}
+
+uint32_t sim_host_cuts(void) {
+    return selected->busy_cuts;
+}
+
+uint32_t sim_host_received(uint8_t *bytes, uint32_t max) {
+    return sim_host_received_at(bytes, NULL, max);
+}
+
+uint32_t sim_host_received_at(uint8_t *bytes, uint64_t *times_ns, uint32_t max) {
+    uint32_t count = selected->rx_log_count < max ? selected->rx_log_count : max;
+    if (bytes) {
+        memcpy(bytes, selected->rx_log, count);
+    }
+    if (times_ns) {
+        memcpy(times_ns, selected->rx_log_ns, count * sizeof(uint64_t));
+    }
+    selected->rx_log_count = 0;
+    return count;
+}
+
+uint8_t sim_host_keys_held(void) {
+    return selected->held_count;
+}
+
+uint32_t sim_host_makes(void) {
+    return selected->makes;
+}
+
+const sim_bus_stats_t *sim_bus_stats(void) {
+    return &selected->stats;
+}
+
+void sim_bus_stats_reset(void) {
+    memset(&selected->stats, 0, sizeof(selected->stats));
+    selected->makes = 0;
+}
@@ -0,0 +1,79 @@
+// sim_hw.h - Simulated RP2040 + PS/2 host for running the driver on Linux
+//
+// Everything runs on one virtual clock. Firmware busy waits and timer reads
+// advance it, ChibiOS virtual timers fire (like ISRs) at their exact
+// deadline while it advances, and the CLK/DATA lines are open drain wires
+// shared with a simulated host that decodes every frame the device clocks
+// out and can send commands back.
+#ifndef SIM_HW_H
+#define SIM_HW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Virtual time a timer_read()/timer_read32()/chVTGetSystemTimeX() call
+// costs, so polling loops always make progress
+#ifndef SIM_TIMER_READ_NS
+#define SIM_TIMER_READ_NS 50
+#endif
+
+// One CLK/DATA transition as seen on the wire
+typedef struct {
+    uint64_t time_ns;
+    uint8_t pin;
+    bool level;
+} sim_edge_t;
+
+// Frame-level bus statistics gathered by the host model
+typedef struct {
+    uint32_t frames;            // Device->host bytes decoded
+    uint32_t frame_errors;      // Bad start, parity or stop bit
+    uint32_t host_frames;       // Host->device bytes acknowledged
+    uint32_t clk_low_min_ns;    // Clock half periods while the device clocks
+    uint32_t clk_low_max_ns;
+    uint32_t clk_high_min_ns;
+    uint32_t clk_high_max_ns;
+    uint64_t first_frame_ns;    // Start bit of the first frame
+    uint64_t last_frame_ns;     // Stop bit of the last frame
+} sim_bus_stats_t;
+
+// Clock
+uint64_t sim_now_ns(void);
+void sim_advance_ns(uint64_t ns);  // Fires due timers on the way
+void sim_advance_to_ns(uint64_t time_ns);
+
+// Other interrupts: every virtual timer callback runs a pseudo-random
+// 0..max_ns after its deadline (0, the default, runs it on time)
+void sim_irq_latency(uint32_t max_ns);
+
+// Host ports the simulation can attach (keyboard and mouse)
+#ifndef SIM_BUSES
+#define SIM_BUSES 2
+#endif
+
+// Wires. The bus and host calls act on the selected bus (0 by default).
+void sim_bus_select(uint8_t bus);
+void sim_bus_attach(uint8_t clk_pin, uint8_t data_pin);
+void sim_bus_detach(void);  // Unplug the host: its pull-ups go with it
+void sim_pin_set_external(uint8_t pin, bool level);  // e.g. the mode switch
+const sim_edge_t *sim_edges(uint32_t *count);
+void sim_edges_clear(void);
+bool sim_vcd_open(const char *path);
+void sim_vcd_close(void);
+
+// Host model
+void sim_host_reset(void);
+void sim_host_send(uint8_t byte);  // Starts a request-to-send, returns at once
+bool sim_host_busy(void);          // Host->device transfer still in progress
+// A busy host: every period_us it holds CLK low for hold_us, mid-frame or
+// not (0 = never). sim_host_cuts() counts the device frames that cut off.
+void sim_host_inhibit_every(uint32_t period_us, uint32_t hold_us);
+uint32_t sim_host_cuts(void);
+uint32_t sim_host_received(uint8_t *bytes, uint32_t max);  // Drains the rx log
+uint32_t sim_host_received_at(uint8_t *bytes, uint64_t *times_ns, uint32_t max);  // ...with stop bit times
+uint8_t sim_host_keys_held(void);  // Keys the host's Set 2 decoder thinks are down
+uint32_t sim_host_makes(void);     // Make codes decoded (excluding repeats)
+const sim_bus_stats_t *sim_bus_stats(void);
+void sim_bus_stats_reset(void);
+
+#endif // SIM_HW_H
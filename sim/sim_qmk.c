@@ -0,0 +1,335 @@
+// sim_qmk.c - Just enough of QMK's main loop to drive kb.c and the driver
+//
+// Stands in for QMK's host driver selection, keyboard report handling and
+// eeconfig, plus the weak user hooks kb.c calls. The USB driver only counts
+// reports; the PS/2 driver is the real one.
+#include "sim_qmk.h"
+#include "sim_hw.h"
+#include "quantum.h"
+#include "kb.h"
+#include "usb_main.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+sim_qmk_stats_t sim_qmk_stats;
+bool sim_verbose = false;
+
+void sim_log(const char *fmt, ...) {
+    if (!sim_verbose) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+// =============================================================================
+// SAMPLES
+// =============================================================================
+
+void sim_samples_add(sim_samples_t *samples, uint64_t value) {
+    if (samples->count == samples->capacity) {
+        samples->capacity = samples->capacity ? samples->capacity * 2 : 1024;
+        samples->values = realloc(samples->values, samples->capacity * sizeof(uint64_t));
+        if (!samples->values) {
+            perror("sim: samples");
+            exit(1);
+        }
+    }
+    samples->values[samples->count++] = value;
+}
+
+static int sim_samples_compare(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+uint64_t sim_samples_percentile(sim_samples_t *samples, uint8_t percent) {
+    if (samples->count == 0) {
+        return 0;
+    }
+    qsort(samples->values, samples->count, sizeof(uint64_t), sim_samples_compare);
+    uint32_t index = ((uint64_t)samples->count * percent + 99) / 100;
+    return samples->values[index ? index - 1 : 0];
+}
+
+void sim_samples_clear(sim_samples_t *samples) {
+    samples->count = 0;
+}
+
+void sim_qmk_stats_reset(void) {
+    sim_samples_clear(&sim_qmk_stats.report_host_ns);
+    sim_samples_clear(&sim_qmk_stats.loop_stall_ns);
+    sim_qmk_stats.reports = 0;
+    sim_qmk_stats.reports_blocked = 0;
+}
+
+// =============================================================================
+// QMK STAND-INS
+// =============================================================================
+
+static uint32_t usb_reports = 0;
+
+static uint8_t usb_keyboard_leds(void) {
+    return 0;
+}
+
+static void usb_send_keyboard(report_keyboard_t *report) {
+    (void)report;
+    usb_reports++;
+}
+
+static void usb_send_nkro(report_nkro_t *report) {
+    (void)report;
+    usb_reports++;
+}
+
+static void usb_send_mouse(report_mouse_t *report) {
+    (void)report;
+}
+
+static void usb_send_extra(report_extra_t *report) {
+    (void)report;
+}
+
+static host_driver_t usb_driver = {usb_keyboard_leds, usb_send_keyboard, usb_send_nkro, usb_send_mouse, usb_send_extra};
+static host_driver_t *driver = &usb_driver;
+
+// Enumerated and active unless a test unplugs it
+USBDriver USBD1 = {.state = USB_ACTIVE};
+
+void sim_usb_connect(bool connected) {
+    USBD1.state = connected ? USB_ACTIVE : USB_READY;
+}
+
+uint32_t sim_usb_reports(void) {
+    return usb_reports;
+}
+
+void host_set_driver(host_driver_t *new_driver) {
+    driver = new_driver;
+}
+
+host_driver_t *host_get_driver(void) {
+    return driver;
+}
+
+static uint32_t eeprom_kb = 0;
+
+uint32_t eeconfig_read_kb(void) {
+    return eeprom_kb;
+}
+
+void eeconfig_update_kb(uint32_t val) {
+    eeprom_kb = val;
+}
+
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    (void)keycode;
+    (void)record;
+    return true;
+}
+
+void keyboard_pre_init_user(void) {}
+void keyboard_post_init_user(void) {}
+void housekeeping_task_user(void) {}
+void matrix_init_user(void) {}
+void matrix_scan_user(void) {}
+
+bool led_update_user(led_t led_state) {
+    (void)led_state;
+    return true;
+}
+
+// =============================================================================
+// KEYBOARD REPORT
+// =============================================================================
+// 6KRO report handling as in QMK's action layer: every register/unregister
+// sends a report straight away.
+
+static report_keyboard_t keyboard_report;
+
+static uint64_t sim_host_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void send_keyboard_report(void) {
+    host_driver_t *target = host_get_driver();
+    if (target == &usb_driver) {
+        target->send_keyboard(&keyboard_report);
+        return;
+    }
+
+    uint64_t virtual_start = sim_now_ns();
+    uint64_t host_start = sim_host_clock_ns();
+    target->send_keyboard(&keyboard_report);
+    uint64_t host_end = sim_host_clock_ns();
+
+    // A blocked call spent its time simulating the bus, not in the driver
+    sim_qmk_stats.reports++;
+    if (sim_now_ns() - virtual_start > SIM_BLOCKED_NS) {
+        sim_qmk_stats.reports_blocked++;
+    } else {
+        sim_samples_add(&sim_qmk_stats.report_host_ns, host_end - host_start);
+    }
+}
+
+void clear_keyboard(void) {
+    memset(&keyboard_report, 0, sizeof(keyboard_report));
+    send_keyboard_report();
+}
+
+static void sim_register(uint8_t keycode, bool pressed) {
+    if (keycode >= KC_LEFT_CTRL && keycode <= KC_RIGHT_GUI) {
+        uint8_t bit = 1 << (keycode - KC_LEFT_CTRL);
+        keyboard_report.mods = pressed ? keyboard_report.mods | bit : keyboard_report.mods & ~bit;
+    } else {
+        int8_t slot = -1;
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+            if (keyboard_report.keys[i] == keycode) {
+                slot = i;
+                break;
+            }
+            if (slot < 0 && keyboard_report.keys[i] == KC_NO) {
+                slot = i;
+            }
+        }
+        if (slot < 0) {
+            return;  // Rolled over
+        }
+        keyboard_report.keys[slot] = pressed ? keycode : KC_NO;
+    }
+    send_keyboard_report();
+}
+
+// Pointing device: one mouse report straight to the active driver
+void sim_mouse_event(int8_t x, int8_t y, int8_t v, uint8_t buttons) {
+    report_mouse_t report = {.buttons = buttons, .x = x, .y = y, .v = v};
+    host_get_driver()->send_mouse(&report);
+}
+
+void sim_extra_event(uint8_t report_id, uint16_t usage) {
+    report_extra_t report = {.report_id = report_id, .usage = usage};
+    host_get_driver()->send_extra(&report);
+}
+
+// QMK's KEYCODE2CONSUMER: the usage a media keycode sends
+static const uint16_t consumer_usages[] = {
+    [KC_AUDIO_MUTE - KC_AUDIO_MUTE] = AUDIO_MUTE,
+    [KC_AUDIO_VOL_UP - KC_AUDIO_MUTE] = AUDIO_VOL_UP,
+    [KC_AUDIO_VOL_DOWN - KC_AUDIO_MUTE] = AUDIO_VOL_DOWN,
+    [KC_MEDIA_NEXT_TRACK - KC_AUDIO_MUTE] = TRANSPORT_NEXT_TRACK,
+    [KC_MEDIA_PREV_TRACK - KC_AUDIO_MUTE] = TRANSPORT_PREV_TRACK,
+    [KC_MEDIA_STOP - KC_AUDIO_MUTE] = TRANSPORT_STOP,
+    [KC_MEDIA_PLAY_PAUSE - KC_AUDIO_MUTE] = TRANSPORT_PLAY_PAUSE,
+    [KC_MEDIA_SELECT - KC_AUDIO_MUTE] = AL_CC_CONFIG,
+    [KC_MEDIA_EJECT - KC_AUDIO_MUTE] = TRANSPORT_STOP_EJECT,
+    [KC_MAIL - KC_AUDIO_MUTE] = AL_EMAIL,
+    [KC_CALCULATOR - KC_AUDIO_MUTE] = AL_CALCULATOR,
+    [KC_MY_COMPUTER - KC_AUDIO_MUTE] = AL_LOCAL_BROWSER,
+    [KC_WWW_SEARCH - KC_AUDIO_MUTE] = AC_SEARCH,
+    [KC_WWW_HOME - KC_AUDIO_MUTE] = AC_HOME,
+    [KC_WWW_BACK - KC_AUDIO_MUTE] = AC_BACK,
+    [KC_WWW_FORWARD - KC_AUDIO_MUTE] = AC_FORWARD,
+    [KC_WWW_STOP - KC_AUDIO_MUTE] = AC_STOP,
+    [KC_WWW_REFRESH - KC_AUDIO_MUTE] = AC_REFRESH,
+    [KC_WWW_FAVORITES - KC_AUDIO_MUTE] = AC_BOOKMARKS,
+};
+
+// As QMK's action layer does it: system and media keycodes send an extra
+// report (and its release), the rest go into the keyboard report
+void sim_key_event(uint16_t keycode, bool pressed) {
+    keyrecord_t record = {.event = {.pressed = pressed, .time = timer_read()}};
+    if (!process_record_kb(keycode, &record)) {
+        return;
+    }
+    if (keycode >= KC_SYSTEM_POWER && keycode <= KC_SYSTEM_WAKE) {
+        sim_extra_event(REPORT_ID_SYSTEM, pressed ? SYSTEM_POWER_DOWN + (keycode - KC_SYSTEM_POWER) : 0);
+    } else if (keycode >= KC_AUDIO_MUTE && keycode <= KC_WWW_FAVORITES) {
+        sim_extra_event(REPORT_ID_CONSUMER, pressed ? consumer_usages[keycode - KC_AUDIO_MUTE] : 0);
+    } else if (keycode <= 0xFF) {
+        sim_register(keycode, pressed);
+    }
+}
+
+// US layout: keycode for each printable ASCII character, bit 7 = Shift
+static const uint8_t ascii_to_keycode[128] = {
+    ['\n'] = KC_ENTER, ['\t'] = KC_TAB, [' '] = KC_SPACE,
+    ['!'] = 0x80 | KC_1, ['"'] = 0x80 | KC_QUOTE, ['#'] = 0x80 | KC_3, ['$'] = 0x80 | KC_4,
+    ['%'] = 0x80 | KC_5, ['&'] = 0x80 | KC_7, ['\''] = KC_QUOTE, ['('] = 0x80 | KC_9,
+    [')'] = 0x80 | KC_0, ['*'] = 0x80 | KC_8, ['+'] = 0x80 | KC_EQUAL, [','] = KC_COMMA,
+    ['-'] = KC_MINUS, ['.'] = KC_DOT, ['/'] = KC_SLASH, [':'] = 0x80 | KC_SEMICOLON,
+    [';'] = KC_SEMICOLON, ['<'] = 0x80 | KC_COMMA, ['='] = KC_EQUAL, ['>'] = 0x80 | KC_DOT,
+    ['?'] = 0x80 | KC_SLASH, ['@'] = 0x80 | KC_2, ['['] = KC_LEFT_BRACKET, ['\\'] = KC_BACKSLASH,
+    [']'] = KC_RIGHT_BRACKET, ['^'] = 0x80 | KC_6, ['_'] = 0x80 | KC_MINUS, ['`'] = KC_GRAVE,
+    ['{'] = 0x80 | KC_LEFT_BRACKET, ['|'] = 0x80 | KC_BACKSLASH, ['}'] = 0x80 | KC_RIGHT_BRACKET,
+    ['~'] = 0x80 | KC_GRAVE,
+};
+
+uint8_t sim_ascii_keycode(char c) {
+    if (c >= 'a' && c <= 'z') return KC_A + (c - 'a');
+    if (c >= 'A' && c <= 'Z') return 0x80 | (KC_A + (c - 'A'));
+    if (c >= '1' && c <= '9') return KC_1 + (c - '1');
+    if (c == '0') return KC_0;
+    return (unsigned char)c < 128 ? ascii_to_keycode[(unsigned char)c] : KC_NO;
+}
+
+void sim_send_string(const char *text) {
+    for (; *text; text++) {
+        uint8_t code = sim_ascii_keycode(*text);
+        if ((code & 0x7F) == KC_NO) {
+            continue;
+        }
+        if (code & 0x80) {
+            sim_register(KC_LEFT_SHIFT, true);
+        }
+        sim_register(code & 0x7F, true);
+        sim_register(code & 0x7F, false);
+        if (code & 0x80) {
+            sim_register(KC_LEFT_SHIFT, false);
+        }
+    }
+}
+
+// =============================================================================
+// MAIN LOOP
+// =============================================================================
+
+void sim_loop_once(void (*scan)(void *ctx), void *ctx) {
+    sim_advance_ns(SIM_SCAN_NS);
+
+    uint64_t start = sim_now_ns();
+    if (scan) {
+        scan(ctx);
+    }
+    housekeeping_task_kb();
+    sim_samples_add(&sim_qmk_stats.loop_stall_ns, sim_now_ns() - start);
+}
+
+void sim_run_ms(uint32_t ms) {
+    uint64_t end = sim_now_ns() + (uint64_t)ms * 1000000;
+    while (sim_now_ns() < end) {
+        sim_loop_once(NULL, NULL);
+    }
+}
+
+void sim_boot(bool ps2_mode) {
+    sim_bus_select(SIM_BUS_MOUSE);
+    sim_bus_attach(PS2_MOUSE_CLOCK_PIN, PS2_MOUSE_DATA_PIN);
+    sim_bus_select(SIM_BUS_KEYBOARD);
+    sim_bus_attach(PS2_KEYBOARD_CLOCK_PIN, PS2_KEYBOARD_DATA_PIN);
+    sim_pin_set_external(MODE_SWITCH_PIN, !ps2_mode);
+    keyboard_pre_init_kb();
+    keyboard_post_init_kb();
+
+    // kb.c installs the fan-out driver on the first loop and switches
+    // within a millisecond; the rest lets the power-on BATs go out
+    sim_run_ms(100);
+}
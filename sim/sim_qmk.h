@@ -0,0 +1,79 @@
+// sim_qmk.h - Just enough of QMK's main loop to drive kb.c and the driver
+#ifndef SIM_QMK_H
+#define SIM_QMK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Virtual time one matrix scan takes, before any key is processed
+#ifndef SIM_SCAN_NS
+#define SIM_SCAN_NS 50000
+#endif
+
+// A report call that took this much virtual time waited for queue space
+#ifndef SIM_BLOCKED_NS
+#define SIM_BLOCKED_NS 10000
+#endif
+
+// Buses sim_boot() attaches the host ports to (see sim_bus_select())
+#define SIM_BUS_KEYBOARD 0
+#define SIM_BUS_MOUSE    1
+
+// Growable sample set for percentiles
+typedef struct {
+    uint64_t *values;
+    uint32_t count;
+    uint32_t capacity;
+} sim_samples_t;
+
+void sim_samples_add(sim_samples_t *samples, uint64_t value);
+uint64_t sim_samples_percentile(sim_samples_t *samples, uint8_t percent);  // Sorts in place
+void sim_samples_clear(sim_samples_t *samples);
+
+typedef struct {
+    sim_samples_t report_host_ns;  // CPU time of PS/2 send_keyboard() calls that didn't block
+    sim_samples_t loop_stall_ns;   // Virtual time each loop spent past the scan
+    uint32_t reports;
+    uint32_t reports_blocked;      // Calls that waited for queue space
+} sim_qmk_stats_t;
+
+extern sim_qmk_stats_t sim_qmk_stats;
+extern bool sim_verbose;
+
+void sim_qmk_stats_reset(void);
+
+// Power up with the mode switch in the given position and run the main loop
+// until kb.c has settled on that mode. Leaves the keyboard bus selected.
+void sim_boot(bool ps2_mode);
+
+// USB host: plugged in and enumerated (the default) or not, and how many
+// reports the USB driver has been handed
+void sim_usb_connect(bool connected);
+uint32_t sim_usb_reports(void);
+
+// One main loop iteration: matrix scan, then scan(ctx) to feed key events
+// (may be NULL), then the keyboard's housekeeping task
+void sim_loop_once(void (*scan)(void *ctx), void *ctx);
+void sim_run_ms(uint32_t ms);
+
+// From inside a scan callback: a matrix event goes through
+// process_record_kb() and QMK's report handling (media and system keycodes
+// as extra reports)
+void sim_key_event(uint16_t keycode, bool pressed);
+
+// From inside a scan callback: a pointing device report (QMK directions,
+// Y down, V up)
+void sim_mouse_event(int8_t x, int8_t y, int8_t v, uint8_t buttons);
+
+// From inside a scan callback: a consumer or system report (usage 0 lets
+// go), straight to the active driver
+void sim_extra_event(uint8_t report_id, uint16_t usage);
+
+// US layout keycode for an ASCII character, bit 7 set if it needs Shift
+uint8_t sim_ascii_keycode(char c);
+
+// SEND_STRING: every character tapped (with Shift where needed) back to back,
+// without returning to the main loop, like QMK with TAP_CODE_DELAY 0
+void sim_send_string(const char *text);
+
+#endif // SIM_QMK_H
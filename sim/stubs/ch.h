@@ -0,0 +1,35 @@
+// ch.h - ChibiOS virtual timers and locks on the simulation's clock.
+// System ticks are microseconds, as on the RP2040 port.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint32_t systime_t;
+typedef uint32_t sysinterval_t;
+
+typedef struct virtual_timer virtual_timer_t;
+typedef void (*vtfunc_t)(virtual_timer_t *vtp, void *p);
+
+struct virtual_timer {
+    bool armed;
+    uint64_t deadline_ns;
+    vtfunc_t func;
+    void *par;
+    virtual_timer_t *next;  // Armed timer list
+};
+
+#define TIME_US2I(us) ((sysinterval_t)(us))
+#define TIME_I2US(ticks) ((uint32_t)(ticks))
+
+void chVTObjectInit(virtual_timer_t *vtp);
+void chVTSetI(virtual_timer_t *vtp, sysinterval_t delay, vtfunc_t vtfunc, void *par);
+void chVTResetI(virtual_timer_t *vtp);
+bool chVTIsArmedI(const virtual_timer_t *vtp);
+systime_t chVTGetSystemTimeX(void);
+
+// Timer callbacks only run while the lock is free, like a real ISR
+void chSysLock(void);
+void chSysUnlock(void);
+void chSysLockFromISR(void);
+void chSysUnlockFromISR(void);
@@ -0,0 +1,23 @@
+// gpio.h - Simulated open-drain GPIO (see sim_hw.c)
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint8_t pin_t;
+
+#define GP14 14
+#define GP15 15
+#define GP16 16
+#define GP17 17
+#define GP18 18
+#define GP19 19
+#define GP25 25
+
+void setPinInput(pin_t pin);
+void setPinInputHigh(pin_t pin);
+void setPinInputLow(pin_t pin);
+void setPinOutput(pin_t pin);
+void writePinLow(pin_t pin);
+void writePinHigh(pin_t pin);
+bool readPin(pin_t pin);
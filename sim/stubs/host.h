@@ -0,0 +1,7 @@
+// host.h - QMK host driver selection
+#pragma once
+
+#include "host_driver.h"
+
+void host_set_driver(host_driver_t *driver);
+host_driver_t *host_get_driver(void);
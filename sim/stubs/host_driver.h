@@ -0,0 +1,13 @@
+// host_driver.h - QMK host driver interface
+#pragma once
+
+#include <stdint.h>
+#include "report.h"
+
+typedef struct {
+    uint8_t (*keyboard_leds)(void);
+    void (*send_keyboard)(report_keyboard_t *);
+    void (*send_nkro)(report_nkro_t *);
+    void (*send_mouse)(report_mouse_t *);
+    void (*send_extra)(report_extra_t *);
+} host_driver_t;
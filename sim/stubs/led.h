@@ -0,0 +1,17 @@
+// led.h - QMK LED state
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef union {
+    uint8_t raw;
+    struct {
+        bool num_lock : 1;
+        bool caps_lock : 1;
+        bool scroll_lock : 1;
+        bool compose : 1;
+        bool kana : 1;
+        uint8_t reserved : 3;
+    };
+} led_t;
@@ -0,0 +1,6 @@
+// print.h - Console output goes to the simulation log (shown with -v)
+#pragma once
+
+void sim_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#define uprintf sim_log
@@ -0,0 +1,40 @@
+// quantum.h - Minimal stand-in for QMK's quantum.h in the host simulation
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "report.h"
+#include "host_driver.h"
+#include "host.h"
+#include "keycodes.h"
+#include "gpio.h"
+#include "timer.h"
+#include "wait.h"
+#include "print.h"
+#include "led.h"
+
+#define PROGMEM
+#define MATRIX_ROWS 1
+#define MATRIX_COLS 1
+
+typedef struct {
+    struct {
+        bool pressed;
+        uint16_t time;
+    } event;
+} keyrecord_t;
+
+bool process_record_user(uint16_t keycode, keyrecord_t *record);
+void keyboard_pre_init_user(void);
+void keyboard_post_init_user(void);
+void housekeeping_task_user(void);
+void matrix_init_user(void);
+void matrix_scan_user(void);
+bool led_update_user(led_t led_state);
+
+void clear_keyboard(void);
+void send_keyboard_report(void);
+
+uint32_t eeconfig_read_kb(void);
+void eeconfig_update_kb(uint32_t val);
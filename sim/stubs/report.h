@@ -0,0 +1,72 @@
+// report.h - QMK HID report layouts used by the PS/2 driver
+#pragma once
+
+#include <stdint.h>
+
+#define KEYBOARD_REPORT_KEYS 6
+#define NKRO_REPORT_BITS 30
+
+enum {
+    REPORT_ID_ALL = 0,
+    REPORT_ID_KEYBOARD = 1,
+    REPORT_ID_MOUSE,
+    REPORT_ID_SYSTEM,
+    REPORT_ID_CONSUMER,
+    REPORT_ID_PROGRAMMABLE_BUTTON,
+    REPORT_ID_NKRO,
+};
+
+// Generic Desktop page: system controls
+enum desktop_usages {
+    SYSTEM_POWER_DOWN = 0x81,
+    SYSTEM_SLEEP = 0x82,
+    SYSTEM_WAKE_UP = 0x83,
+};
+
+// Consumer page: the usages QMK's media keycodes send
+enum consumer_usages {
+    TRANSPORT_NEXT_TRACK = 0x0B5,
+    TRANSPORT_PREV_TRACK = 0x0B6,
+    TRANSPORT_STOP = 0x0B7,
+    TRANSPORT_STOP_EJECT = 0x0CC,
+    TRANSPORT_PLAY_PAUSE = 0x0CD,
+    AUDIO_MUTE = 0x0E2,
+    AUDIO_VOL_UP = 0x0E9,
+    AUDIO_VOL_DOWN = 0x0EA,
+    AL_CC_CONFIG = 0x183,
+    AL_EMAIL = 0x18A,
+    AL_CALCULATOR = 0x192,
+    AL_LOCAL_BROWSER = 0x194,
+    AC_SEARCH = 0x221,
+    AC_HOME = 0x223,
+    AC_BACK = 0x224,
+    AC_FORWARD = 0x225,
+    AC_STOP = 0x226,
+    AC_REFRESH = 0x227,
+    AC_BOOKMARKS = 0x22A,
+};
+
+typedef struct {
+    uint8_t mods;
+    uint8_t reserved;
+    uint8_t keys[KEYBOARD_REPORT_KEYS];
+} report_keyboard_t;
+
+typedef struct {
+    uint8_t report_id;
+    uint8_t mods;
+    uint8_t bits[NKRO_REPORT_BITS];
+} report_nkro_t;
+
+typedef struct {
+    uint8_t buttons;
+    int8_t x;
+    int8_t y;
+    int8_t v;
+    int8_t h;
+} report_mouse_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t report_id;
+    uint16_t usage;
+} report_extra_t;
@@ -0,0 +1,20 @@
+// usb_main.h - ChibiOS USB driver state (see sim_qmk.c)
+#pragma once
+
+typedef enum {
+    USB_UNINIT,
+    USB_STOP,
+    USB_READY,
+    USB_SELECTED,
+    USB_ACTIVE,
+    USB_SUSPENDED
+} usbstate_t;
+
+typedef struct {
+    usbstate_t state;
+} USBDriver;
+
+extern USBDriver USBD1;
+
+#define USB_DRIVER USBD1
+#define usbGetDriverStateI(usbp) ((usbp)->state)
@@ -0,0 +1,5 @@
+// wait.h - Busy waits advance the virtual clock
+#pragma once
+
+void wait_us(unsigned us);
+void wait_ms(unsigned ms);